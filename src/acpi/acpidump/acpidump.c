@@ -117,7 +117,7 @@ static int acpidump_test1(fwts_framework *fw)
 		return FWTS_ERROR;
 	}
 
-	for (i = 0; i < ACPI_MAX_TABLES; i++) {
+	for (i = 0; ; i++) {
 		fwts_acpi_table_info *table;
 		fwts_list *output;
 		char *provenance;
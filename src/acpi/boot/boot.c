@@ -107,6 +107,7 @@ static fwts_framework_ops boot_ops = {
 	.minor_tests = boot_tests
 };
 
-FWTS_REGISTER("boot", &boot_ops, FWTS_TEST_ANYTIME, FWTS_FLAG_BATCH | FWTS_FLAG_ACPI)
+FWTS_REGISTER("boot", &boot_ops, FWTS_TEST_ANYTIME, FWTS_FLAG_BATCH | FWTS_FLAG_ACPI |
+	      FWTS_FLAG_READ_ONLY)
 
 #endif
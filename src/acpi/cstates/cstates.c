@@ -35,6 +35,7 @@
 #include <dirent.h>
 #include <stdint.h>
 #include <ctype.h>
+#include <fcntl.h>
 
 #define MIN_CSTATE	1
 #define MAX_CSTATE	16
@@ -45,11 +46,23 @@ typedef struct {
 	bool present[MAX_CSTATE];
 } fwts_cstates;
 
+/*
+ *  Per CPU C-state sampling state, the usage counter file names
+ *  are looked up once so each tick is just a read of the counters
+ */
+typedef struct {
+	int cpu;			/* CPU number */
+	char *usage[MAX_CSTATE];	/* usage counter files of present C-states */
+	fwts_cstates state;		/* last counts and C-states reached */
+	bool keepgoing;			/* some present C-states not reached yet */
+} fwts_cstates_cpu;
+
 static int statecount = -1;
 static int firstcpu = -1;
 
-static void get_cstates(char *path, fwts_cstates *state)
+static void get_cstates(char *path, fwts_cstates_cpu *cpu)
 {
+	fwts_cstates *state = &cpu->state;
 	struct dirent *entry;
 	char filename[PATH_MAX];
 	char *data;
@@ -70,8 +83,9 @@ static void get_cstates(char *path, fwts_cstates *state)
 			long int nr;
 			int count;
 
-			snprintf(filename, sizeof(filename), "%s/%s/name",
-				path, entry->d_name);
+			if (snprintf(filename, sizeof(filename), "%s/%s/name",
+				path, entry->d_name) >= (int)sizeof(filename))
+				break;
 			if ((data = fwts_get(filename)) == NULL)
 				break;
 
@@ -93,8 +107,9 @@ static void get_cstates(char *path, fwts_cstates *state)
 			}
 			free(data);
 
-			snprintf(filename, sizeof(filename), "%s/%s/usage",
-				path, entry->d_name);
+			if (snprintf(filename, sizeof(filename), "%s/%s/usage",
+				path, entry->d_name) >= (int)sizeof(filename))
+				break;
 			if ((data = fwts_get(filename)) == NULL)
 				break;
 			count = strtoull(data, NULL, 10);
@@ -103,85 +118,124 @@ static void get_cstates(char *path, fwts_cstates *state)
 			if ((nr >= 0) && (nr < MAX_CSTATE)) {
 				state->counts[nr] = count;
 				state->present[nr] = true;
+				free(cpu->usage[nr]);
+				cpu->usage[nr] = strdup(filename);
 			}
 		}
 	}
 	closedir(dir);
 }
 
-#define TOTAL_WAIT_TIME		20
-
-static void do_cpu(fwts_framework *fw, int nth, int cpus, int cpu, char *path)
+/*
+ *  read_cstates()
+ *	read the usage counters of the present C-states of a CPU,
+ *	note which C-states have been used since the last read
+ */
+static void read_cstates(fwts_cstates_cpu *cpu)
 {
-	fwts_cstates initial, current;
-	int	count;
-	char	buffer[128];
-	char	tmp[8];
-	bool	keepgoing = true;
-	int	i;
+	fwts_cstates *state = &cpu->state;
+	int i;
 
-	get_cstates(path, &initial);
+	cpu->keepgoing = false;
+	for (i = MIN_CSTATE; i < MAX_CSTATE; i++) {
+		if (cpu->usage[i]) {
+			char buffer[32];
+			ssize_t n;
+			int fd, count;
+
+			if ((fd = open(cpu->usage[i], O_RDONLY)) < 0)
+				continue;
+			n = read(fd, buffer, sizeof(buffer) - 1);
+			(void)close(fd);
+			if (n <= 0)
+				continue;
+			buffer[n] = '\0';
+			count = strtoull(buffer, NULL, 10);
+
+			if (state->counts[i] != count) {
+				state->counts[i] = count;
+				state->used[i] = true;
+			}
+		}
+		if (state->present[i] && !state->used[i])
+			cpu->keepgoing = true;
+	}
+}
 
-	for (i = 0; (i < TOTAL_WAIT_TIME) && keepgoing; i++) {
-		int j;
+#define TOTAL_WAIT_TIME		20
+#define LOAD_TIME_USECS		250000
 
-		snprintf(buffer, sizeof(buffer),"(CPU %d of %d)", nth + 1, cpus);
-		fwts_progress_message(fw,
-			100 * (i + (TOTAL_WAIT_TIME*nth)) /
-				(cpus * TOTAL_WAIT_TIME), buffer);
+/*
+ *  load_cpus()
+ *	burn cycles on all the CPUs that have not reached all
+ *	their C-states yet, at the same time
+ */
+static void load_cpus(fwts_framework *fw, fwts_cstates_cpu *cpus, const int ncpus)
+{
+	int *load;
+	bool *pinned;
+	int i, n;
+
+	load = calloc(ncpus, sizeof(*load));
+	pinned = calloc(ncpus, sizeof(*pinned));
+	if (!load || !pinned) {
+		fwts_log_error(fw, "Cannot allocate CPU load worker list.");
+		goto out;
+	}
 
-		if ((i & 7) < 4)
-			sleep(1);
-		else {
-			fwts_cpu_benchmark_result result;
-
-			if (fwts_cpu_benchmark(fw, cpu, &result) != FWTS_OK) {
-				fwts_failed(fw, LOG_LEVEL_HIGH, "CPUFailedPerformance",
-					"Could not determine the CPU performance, this "
-					"may be due to not being able to get or set the "
-					"CPU affinity for CPU %d.", cpu);
-			}
-		}
+	for (n = 0, i = 0; i < ncpus; i++)
+		if (cpus[i].keepgoing)
+			load[n++] = cpus[i].cpu;
 
-		get_cstates(path, &current);
+	if (fwts_cpu_consume_cpus(load, n, LOAD_TIME_USECS, pinned) != FWTS_OK)
+		fwts_log_error(fw, "Cannot start all the CPU load workers.");
 
-		keepgoing = false;
-		for (j = MIN_CSTATE; j < MAX_CSTATE; j++) {
-			if (initial.counts[j] != current.counts[j]) {
-				initial.counts[j] = current.counts[j];
-				initial.used[j] = true;
-			}
-			if (initial.present[j] && !initial.used[j])
-				keepgoing = true;
-		}
+	for (i = 0; i < n; i++) {
+		if (!pinned[i])
+			fwts_failed(fw, LOG_LEVEL_HIGH, "CPUFailedPerformance",
+				"Could not determine the CPU performance, this "
+				"may be due to not being able to get or set the "
+				"CPU affinity for CPU %d.", load[i]);
 	}
+out:
+	free(pinned);
+	free(load);
+}
+
+static void check_cpu(fwts_framework *fw, fwts_cstates_cpu *cpu)
+{
+	fwts_cstates *state = &cpu->state;
+	int	count;
+	char	buffer[128];
+	char	tmp[8];
+	int	i;
 
 	*buffer = '\0';
-	if (keepgoing) {
+	if (cpu->keepgoing) {
 		/* Not a failure, but not a pass either! */
 		for (i = MIN_CSTATE; i < MAX_CSTATE; i++)  {
-			if (initial.present[i] && !initial.used[i]) {
+			if (state->present[i] && !state->used[i]) {
 				snprintf(tmp, sizeof(tmp), "C%d ", i);
 				strcat(buffer, tmp);
 			}
 		}
 		fwts_log_info(fw, "Processor %d has not reached %s during tests. "
 				  "This is not a failure, however it is not a "
-				  "complete and thorough test.", cpu, buffer);
+				  "complete and thorough test.", cpu->cpu, buffer);
 	} else {
 		for (i = MIN_CSTATE; i < MAX_CSTATE; i++)  {
-			if (initial.present[i] && initial.used[i]) {
+			if (state->present[i] && state->used[i]) {
 				snprintf(tmp, sizeof(tmp), "C%d ", i);
 				strcat(buffer, tmp);
 			}
 		}
 		fwts_passed(fw, "Processor %d has reached all C-states: %s",
-			cpu, buffer);
+			cpu->cpu, buffer);
 	}
 
 	count = 0;
 	for (i = MIN_CSTATE; i < MAX_CSTATE; i++)
-		if (initial.present[i])
+		if (state->present[i])
 			count++;
 
 	if (statecount == -1)
@@ -190,21 +244,65 @@ static void do_cpu(fwts_framework *fw, int nth, int cpus, int cpu, char *path)
 	if (statecount != count)
 		fwts_failed(fw, LOG_LEVEL_HIGH, "CPUNoCState",
 			"Processor %d is expected to have %d C-states but has %d.",
-			cpu, statecount, count);
+			cpu->cpu, statecount, count);
 	else
 		if (firstcpu == -1)
-			firstcpu = cpu;
+			firstcpu = cpu->cpu;
 		else
 			fwts_passed(fw, "Processor %d has the same number of C-states as processor %d",
-				cpu, firstcpu);
+				cpu->cpu, firstcpu);
+}
+
+/*
+ *  do_cpus()
+ *	sample the C-state usage of all the CPUs at once, alternating
+ *	idle and load on all CPUs until every CPU has reached all its
+ *	C-states or the wait time is up
+ */
+static void do_cpus(fwts_framework *fw, fwts_cstates_cpu *cpus, const int ncpus)
+{
+	bool	keepgoing = true;
+	int	i, j;
+
+	for (i = 0; i < ncpus; i++)
+		cpus[i].keepgoing = true;
+
+	for (i = 0; (i < TOTAL_WAIT_TIME) && keepgoing; i++) {
+		char	buffer[128];
+		int	done;
+
+		for (done = 0, j = 0; j < ncpus; j++)
+			if (!cpus[j].keepgoing)
+				done++;
+
+		snprintf(buffer, sizeof(buffer), "(%d of %d CPUs done)", done, ncpus);
+		fwts_progress_message(fw, 100 * i / TOTAL_WAIT_TIME, buffer);
+
+		if ((i & 7) < 4)
+			sleep(1);
+		else
+			load_cpus(fw, cpus, ncpus);
+
+		keepgoing = false;
+		for (j = 0; j < ncpus; j++) {
+			if (cpus[j].keepgoing) {
+				read_cstates(&cpus[j]);
+				keepgoing |= cpus[j].keepgoing;
+			}
+		}
+	}
+
+	for (i = 0; i < ncpus; i++)
+		check_cpu(fw, &cpus[i]);
 }
 
 static int cstates_test1(fwts_framework *fw)
 {
 	DIR *dir;
 	struct dirent *entry;
-	int cpus;
-	int i;
+	fwts_cstates_cpu *cpus;
+	int ncpus;
+	int i, j;
 
 	fwts_log_info(fw,
 		"This test checks if all processors have the same number of "
@@ -218,16 +316,27 @@ static int cstates_test1(fwts_framework *fw)
 	}
 
 	/* How many CPUs are there? */
-	for (cpus = 0; (entry = readdir(dir)) != NULL; )
+	for (ncpus = 0; (entry = readdir(dir)) != NULL; )
 		if (entry &&
 		    (strlen(entry->d_name)>3) &&
 		    (strncmp(entry->d_name, "cpu", 3) == 0) &&
 		    (isdigit(entry->d_name[3])))
-			cpus++;
+			ncpus++;
+
+	if (ncpus == 0) {
+		closedir(dir);
+		return FWTS_OK;
+	}
+
+	if ((cpus = calloc(ncpus, sizeof(*cpus))) == NULL) {
+		fwts_log_error(fw, "Cannot allocate CPU C-state information.");
+		closedir(dir);
+		return FWTS_ERROR;
+	}
 
 	rewinddir(dir);
 
-	for (i = 0; (cpus > 0) && (entry = readdir(dir)) != NULL; ) {
+	for (i = 0; (i < ncpus) && (entry = readdir(dir)) != NULL; ) {
 		if (entry &&
 		    (strlen(entry->d_name)>3) &&
 		    (strncmp(entry->d_name, "cpu", 3) == 0) &&
@@ -236,11 +345,21 @@ static int cstates_test1(fwts_framework *fw)
 
 			snprintf(cpupath, sizeof(cpupath), "%s/%s/cpuidle",
 				PROCESSOR_PATH, entry->d_name);
-			do_cpu(fw, i++, cpus, strtoul(entry->d_name+3, NULL, 10), cpupath);
+			cpus[i].cpu = strtoul(entry->d_name+3, NULL, 10);
+			get_cstates(cpupath, &cpus[i]);
+			i++;
 		}
 	}
 
 	closedir(dir);
+	ncpus = i;
+
+	do_cpus(fw, cpus, ncpus);
+
+	for (i = 0; i < ncpus; i++)
+		for (j = 0; j < MAX_CSTATE; j++)
+			free(cpus[i].usage[j]);
+	free(cpus);
 
 	return FWTS_OK;
 }
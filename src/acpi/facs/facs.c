@@ -75,7 +75,7 @@ static int facs_test1(fwts_framework *fw)
 	 * If we've loaded the table from memory we can do some extra checks
 	 */
 	if (table->provenance == FWTS_ACPI_TABLE_FROM_FIRMWARE) {
-		fwts_list *memory_map;
+		fwts_memory_map *memory_map;
 
 		if (table->addr & 0x3f) {
 			passed = false;
@@ -145,6 +145,7 @@ static fwts_framework_ops facs_ops = {
 	.minor_tests = facs_tests
 };
 
-FWTS_REGISTER("facs", &facs_ops, FWTS_TEST_ANYTIME, FWTS_FLAG_BATCH | FWTS_FLAG_ACPI)
+FWTS_REGISTER("facs", &facs_ops, FWTS_TEST_ANYTIME, FWTS_FLAG_BATCH | FWTS_FLAG_ACPI |
+	      FWTS_FLAG_READ_ONLY)
 
 #endif
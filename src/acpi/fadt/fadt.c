@@ -1426,6 +1426,7 @@ static uint64_t fadt_find_p_blk(fwts_framework *fw)
 			 * ignore any CPUs defined as Device objects.
 			 */
 			if (type == ACPI_TYPE_PROCESSOR) {
+				fwts_acpi_reset();
 				status = AcpiEvaluateObject(handle, NULL, NULL,
 							    &buf);
 				if (ACPI_FAILURE(status))
@@ -394,12 +394,14 @@ static int hpet_check_test3(fwts_framework *fw)
 		return FWTS_ERROR;
 	}
 
-	for (i = 0; i < ACPI_MAX_TABLES; i++) {
+	for (i = 0; ; i++) {
 		fwts_acpi_table_info *info;
 
 		if (fwts_acpi_get_table(fw, i, &info) != FWTS_OK)
 			break;
-		if (info && info->has_aml)
+		if (info == NULL)
+			break;
+		if (info->has_aml)
 			hpet_check_base_acpi_table(fw, info, &parsed);
 	}
 	fwts_iasl_deinit();
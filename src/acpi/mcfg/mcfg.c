@@ -27,7 +27,7 @@
 #include <inttypes.h>
 #include <stdbool.h>
 
-static fwts_list *memory_map_list;
+static fwts_memory_map *memory_map_list;
 static fwts_acpi_table_info *mcfg_table;
 acpi_table_init(MCFG, &mcfg_table)
 
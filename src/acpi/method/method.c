@@ -393,45 +393,21 @@ static int method_evaluate_method(fwts_framework *fw,
 	fwts_method_return check_func,
 	void *private)
 {
-	fwts_list *methods;
-	size_t name_len = strlen(name);
+	fwts_acpi_object_info *info;
 	bool found = false;
 
+	for (info = fwts_acpi_object_find_first(name); info;
+	     info = fwts_acpi_object_find_next(info, name)) {
+		ACPI_OBJECT_LIST  arg_list;
 
-	if ((methods = fwts_acpi_object_get_names()) != NULL) {
-		fwts_list_link	*item;
-
-		fwts_list_foreach(item, methods) {
-			char *method_name = fwts_list_data(char*, item);
-			ACPI_HANDLE method_handle;
-			ACPI_OBJECT_TYPE type;
-			ACPI_STATUS status;
-
-			size_t len = strlen(method_name);
-			if (strncmp(name, method_name + len - name_len, name_len) == 0) {
-				ACPI_OBJECT_LIST  arg_list;
-
-				status = AcpiGetHandle (NULL, method_name, &method_handle);
-				if (ACPI_FAILURE(status)) {
-					fwts_warning(fw, "Failed to get handle for object %s.", name);
-					continue;
-				}
-				status = AcpiGetType(method_handle, &type);
-				if (ACPI_FAILURE(status)) {
-					fwts_warning(fw, "Failed to get object type for %s.",name);
-					continue;
-				}
-
-				if (type == ACPI_TYPE_LOCAL_SCOPE)
-					continue;
+		if (info->type == ACPI_TYPE_LOCAL_SCOPE)
+			continue;
 
-				found = true;
-				arg_list.Count   = num_args;
-				arg_list.Pointer = args;
-				method_evaluate_found_method(fw, method_name,
-					check_func, private, &arg_list);
-			}
-		}
+		found = true;
+		arg_list.Count   = num_args;
+		arg_list.Pointer = args;
+		method_evaluate_found_method(fw, info->name,
+			check_func, private, &arg_list);
 	}
 
 	if (found) {
@@ -226,6 +226,6 @@ static fwts_framework_ops rsdp_ops = {
 };
 
 FWTS_REGISTER("rsdp", &rsdp_ops, FWTS_TEST_ANYTIME, FWTS_FLAG_BATCH |
-	      FWTS_FLAG_ACPI | FWTS_FLAG_COMPLIANCE_ACPI)
+	      FWTS_FLAG_ACPI | FWTS_FLAG_COMPLIANCE_ACPI | FWTS_FLAG_READ_ONLY)
 
 #endif
@@ -446,101 +446,24 @@ tidy:
 static int s3_scan_times(
 	fwts_framework *fw,
 	fwts_list *klog,
+	fwts_pm_timeline_stats *timings,
 	int *suspend_too_long,
 	int *resume_too_long)
 {
-	fwts_list_link *item;
+	fwts_pm_timeline timeline;
+	double seconds;
 
-	double s3_suspend_start = -1.0, s3_suspend_finish = -1.0;
-	double s3_resume_start = -1.0, s3_resume_finish = -1.0;
-	double previous_ts = -1.0, ts = 0.0;
+	fwts_pm_timeline_init(&timeline, FWTS_PM_TIMELINE_SUSPEND);
+	fwts_pm_timeline_scan(klog, &timeline);
+	fwts_pm_timeline_log(fw, &timeline);
+	fwts_pm_timeline_stats_add(timings, &timeline);
 
-	fwts_list_foreach(item, klog) {
-		char *txt = (char *)item->data;
-		char *bracket = strchr(txt, '[');
-		size_t len = strlen(txt);
-
-		if (len < 15 || bracket == NULL)
-			continue;
-
-		previous_ts = ts;
-
-		/* Get log time stamp */
-		sscanf(bracket + 1, "%lf", &ts);
-		if (strstr(txt, FWTS_SUSPEND) ||
-		    strstr(txt, "Starting fwts suspend")) {
-			s3_suspend_start = ts;
-			continue;
-		}
-
-		/* Update log time if this is available */
-		if (strstr(txt, "PM: suspend entry")) {
-			s3_suspend_start = ts;
-			continue;
-		}
-
-		if (strstr(txt, FWTS_RESUME)) {
-			s3_resume_finish = ts;
-			continue;
-		}
-		/* This may be the last message we see from the kernel */
-		if (strstr(txt, "PM: Saving platform NVS memory")) {
-			s3_suspend_finish = ts;
-			continue;
-		}
-		/* And this may appear even later */
-		if (strstr(txt, "smpboot: CPU") && strstr(txt, "is now offline")) {
-			s3_suspend_finish = ts;
-			continue;
-		}
-
-		if (strstr(txt, "ACPI: Low-level resume complete")) {
-			s3_resume_start = ts;
-			if (s3_suspend_finish < 0.0)
-				s3_suspend_finish = previous_ts;
-			continue;
-		}
-		if (s3_resume_start < 0.0 && strstr(txt, "ACPI: Waking up from system sleep state S3")) {
-			s3_resume_start = ts;
-			if (s3_suspend_finish < 0.0)
-				s3_suspend_finish = previous_ts;
-			continue;
-		}
-
-		/* get log time for s2idle */
-		if (strstr(txt, "PM: suspend-to-idle")) {
-			s3_suspend_finish = ts;
-			continue;
-		}
-		if (strstr(txt, "PM: Timekeeping suspended")) {
-			s3_resume_start = ts;
-			if (s3_suspend_finish < 0.0)
-				s3_suspend_finish = previous_ts;
-			continue;
-		}
-
-		if (strstr(txt, "Restarting tasks ... done")) {
-			s3_resume_finish = ts;
-			break;
-		}
-	}
-
-	fwts_log_info(fw, "Suspend/Resume Timings:");
-	if (s3_suspend_start > 0.0 && s3_suspend_finish > 0.0) {
-		fwts_log_info_verbatim(fw, "  Suspend: %.3f seconds.",
-			s3_suspend_finish - s3_suspend_start);
-		if (s3_suspend_finish - s3_suspend_start > s3_suspend_time)
-			(*suspend_too_long)++;
-	} else
-		fwts_log_info_verbatim(fw, "  Could not determine time to suspend.");
-
-	if (s3_resume_start > 0.0 && s3_resume_finish > 0.0) {
-		fwts_log_info_verbatim(fw, "  Resume:  %.3f seconds.",
-			s3_resume_finish - s3_resume_start);
-		if (s3_resume_finish - s3_resume_start > s3_resume_time)
-			(*resume_too_long)++;
-	} else
-		fwts_log_info_verbatim(fw, "  Could not determine time to resume.");
+	if (fwts_pm_timeline_suspend_time(&timeline, &seconds) &&
+	    seconds > s3_suspend_time)
+		(*suspend_too_long)++;
+	if (fwts_pm_timeline_resume_time(&timeline, &seconds) &&
+	    seconds > s3_resume_time)
+		(*resume_too_long)++;
 
 	return FWTS_OK;
 }
@@ -551,6 +474,7 @@ static int s3_check_log(
 	int *errors,
 	int *oopses,
 	int *warn_ons,
+	fwts_pm_timeline_stats *timings,
 	int *suspend_too_long,
 	int *resume_too_long)
 {
@@ -572,7 +496,7 @@ static int s3_check_log(
 	*oopses += oops;
 	*warn_ons += warn_on;
 
-	s3_scan_times(fw, klog, suspend_too_long, resume_too_long);
+	s3_scan_times(fw, klog, timings, suspend_too_long, resume_too_long);
 
 	return FWTS_OK;
 }
@@ -593,6 +517,7 @@ static int s3_test_multiple(fwts_framework *fw)
 	int delta = (int)(s3_delay_delta * 1000.0);
 	uint64_t s2idle_residency = get_s2_idle_residency();
 	int pm_debug;
+	fwts_pm_timeline_stats timings;
 
 #if FWTS_ENABLE_LOGIND
 #if !GLIB_CHECK_VERSION(2,35,0)
@@ -603,6 +528,7 @@ static int s3_test_multiple(fwts_framework *fw)
 
 	(void)fwts_pm_debug_get(&pm_debug);
 	(void)fwts_pm_debug_set(1);
+	fwts_pm_timeline_stats_init(&timings, FWTS_PM_TIMELINE_SUSPEND);
 
 	if (s3_multiple == 1)
 		fwts_log_info(fw, "Defaulted to 1 test, use --s3-multiple=N to run more %s cycles\n", sleep_type);
@@ -610,10 +536,11 @@ static int s3_test_multiple(fwts_framework *fw)
 	for (i = 0; i < s3_multiple; i++) {
 		struct timeval tv;
 		int ret, percent = (i * 100) / s3_multiple;
-		fwts_list *klog_pre, *klog_post, *klog_diff;
+		fwts_klog_cursor *cursor;
+		fwts_list *klog_diff;
 		fwts_log_info(fw, "%s cycle %d of %d\n", sleep_type, i+1, s3_multiple);
 
-		if ((klog_pre = fwts_klog_read()) == NULL)
+		if ((cursor = fwts_klog_cursor_open(fw->klog)) == NULL)
 			fwts_log_error(fw, "Cannot read kernel log.");
 
 		ret = s3_do_suspend_resume(fw, &hw_errors, &pm_errors, &hook_errors,
@@ -621,26 +548,26 @@ static int s3_test_multiple(fwts_framework *fw)
 					   s3_sleep_delay, percent);
 		if (ret == FWTS_OUT_OF_MEMORY) {
 			fwts_log_error(fw, "%s cycle %d failed - out of memory error.", sleep_type, i+1);
-			fwts_klog_free(klog_pre);
+			fwts_klog_cursor_close(cursor);
 			break;
 		}
 		if (hook_errors > 0) {
-			fwts_klog_free(klog_pre);
+			fwts_klog_cursor_close(cursor);
 			break;
 		}
 
-		if ((klog_post = fwts_klog_read()) == NULL)
+		/* Only the lines logged during this cycle are checked */
+		if ((klog_diff = fwts_klog_cursor_read(cursor)) == NULL)
 			fwts_log_error(fw, "Cannot re-read kernel log.");
+		fwts_klog_cursor_check_lost(fw, cursor);
 
 		fwts_progress_message(fw, percent, "(Checking logs for errors)");
-		klog_diff = fwts_klog_find_changes(klog_pre, klog_post);
 		if (klog_diff)
 			s3_check_log(fw, klog_diff, &klog_errors, &klog_oopses, &klog_warn_ons,
-				&suspend_too_long, &resume_too_long);
+				&timings, &suspend_too_long, &resume_too_long);
 
-		fwts_klog_free(klog_pre);
-		fwts_klog_free(klog_post);
-		fwts_list_free(klog_diff, NULL);
+		fwts_klog_cursor_close(cursor);
+		fwts_klog_free(klog_diff);
 
 		if (!s3_device_check) {
 			char buffer[80];
@@ -669,6 +596,9 @@ static int s3_test_multiple(fwts_framework *fw)
 
 	fwts_log_info(fw, "Completed %s cycle(s)\n", sleep_type);
 
+	if (timings.cycles > 1)
+		fwts_pm_timeline_stats_log(fw, &timings);
+
 	if (klog_errors > 0)
 		fwts_log_info(fw, "Found %d errors in kernel log.", klog_errors);
 	else
@@ -246,6 +246,9 @@ static int s3power_test(fwts_framework *fw)
 	int pm_debug;
 
 	bool offline;
+	fwts_klog_cursor *cursor;
+	fwts_list *klog_diff;
+	fwts_pm_timeline timeline;
 
 	uint32_t capacity_before_mAh;
 	uint32_t capacity_after_mAh;
@@ -320,8 +323,17 @@ static int s3power_test(fwts_framework *fw)
 	(void)fwts_pm_debug_set(1);
 
 	/* Do S3 here */
+	if ((cursor = fwts_klog_cursor_open(fw->klog)) == NULL)
+		fwts_log_error(fw, "Cannot read kernel log.");
+
 	status = do_suspend(fwts_settings, 100, &duration, PM_SUSPEND);
 
+	/* Only the lines logged during the suspend are scanned */
+	if ((klog_diff = fwts_klog_cursor_read(cursor)) == NULL)
+		fwts_log_error(fw, "Cannot re-read kernel log.");
+	fwts_klog_cursor_check_lost(fw, cursor);
+	fwts_klog_cursor_close(cursor);
+
 	/* Restore pm debug value */
 	if (pm_debug != -1)
 		(void)fwts_pm_debug_set(pm_debug);
@@ -333,6 +345,13 @@ static int s3power_test(fwts_framework *fw)
 
 	fwts_log_info(fw, "pm-suspend returned %d after %d seconds.", status, duration);
 
+	if (klog_diff) {
+		fwts_pm_timeline_init(&timeline, FWTS_PM_TIMELINE_SUSPEND);
+		fwts_pm_timeline_scan(klog_diff, &timeline);
+		fwts_pm_timeline_log(fw, &timeline);
+		fwts_klog_free(klog_diff);
+	}
+
 	if (duration < s3power_sleep_delay)
 		fwts_failed(fw, LOG_LEVEL_MEDIUM, "ShortSuspend",
 			"Unexpected: S3 slept for %d seconds, less than the expected %d seconds.",
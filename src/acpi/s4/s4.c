@@ -41,6 +41,28 @@ static char *s4_quirks = NULL;		/* Quirks to be passed to pm-hibernate */
 static int  s4_device_check_delay = 15;	/* Time to sleep after waking up and then running device check */
 static bool s4_min_max_delay = false;
 
+/*
+ *  PM messages expected in the kernel log for each
+ *  hibernate/resume cycle, compiled once in s4_init()
+ */
+enum {
+	S4_FREEZE_USER_SPACE,
+	S4_FREEZE_TASKS,
+	S4_FREEZE_DEVICES,
+	S4_LATE_FREEZE_DEVICES,
+	S4_IMAGE_ALLOCATED,
+	S4_IMAGE_RESTORED,
+};
+
+static fwts_log_regex s4_regexes[] = {
+	[S4_FREEZE_USER_SPACE]	= { .pattern = "Freezing user space processes.*done" },
+	[S4_FREEZE_TASKS]	= { .pattern = "Freezing remaining freezable tasks.*done" },
+	[S4_FREEZE_DEVICES]	= { .pattern = "PM: freeze of devices complete" },
+	[S4_LATE_FREEZE_DEVICES] = { .pattern = "PM: late freeze of devices complete" },
+	[S4_IMAGE_ALLOCATED]	= { .pattern = "PM: Allocated.*kbytes" },
+	[S4_IMAGE_RESTORED]	= { .pattern = "PM: Image restored successfully" },
+};
+
 static int s4_init(fwts_framework *fw)
 {
 	fwts_list* swap_devs;
@@ -62,6 +84,17 @@ static int s4_init(fwts_framework *fw)
 		return FWTS_ERROR;
 	}
 
+	(void)fwts_log_regex_compile(fw, s4_regexes, FWTS_ARRAY_SIZE(s4_regexes));
+
+	return FWTS_OK;
+}
+
+static int s4_deinit(fwts_framework *fw)
+{
+	FWTS_UNUSED(fw);
+
+	fwts_log_regex_free(s4_regexes, FWTS_ARRAY_SIZE(s4_regexes));
+
 	return FWTS_OK;
 }
 
@@ -172,9 +205,12 @@ static int s4_hibernate(fwts_framework *fw,
 	int *klog_oopses,
 	int *klog_warn_ons,
 	int *failed_alloc_image,
+	fwts_pm_timeline_stats *timings,
 	int percent)
 {
-	fwts_list *klog_pre, *klog_post, *klog_diff;
+	fwts_klog_cursor *cursor;
+	fwts_list *klog_diff;
+	fwts_pm_timeline timeline;
 	fwts_hwinfo hwinfo1, hwinfo2;
 	int status;
 	int duration;
@@ -254,13 +290,16 @@ static int s4_hibernate(fwts_framework *fw,
 	fwts_wakealarm_trigger(fw, s4_sleep_delay);
 
 	/* Do s4 here */
-	if ((klog_pre = fwts_klog_read()) == NULL)
+	if ((cursor = fwts_klog_cursor_open(fw->klog)) == NULL)
 		fwts_log_error(fw, "S4: hibernate: Cannot read kernel log.");
 
 	status = do_s4(fwts_settings, percent, &duration, command);
 
-	if ((klog_post = fwts_klog_read()) == NULL)
+	/* Only the lines logged during this cycle are checked */
+	if ((klog_diff = fwts_klog_cursor_read(cursor)) == NULL)
 		fwts_log_error(fw, "S4: hibernate: Cannot re-read kernel log.");
+	fwts_klog_cursor_check_lost(fw, cursor);
+	fwts_klog_cursor_close(cursor);
 
 	if (s4_device_check) {
 		int i;
@@ -287,9 +326,14 @@ static int s4_hibernate(fwts_framework *fw,
 
 	fwts_progress_message(fw, percent, "(Checking for errors)");
 
-	klog_diff = fwts_klog_find_changes(klog_pre, klog_post);
 	s4_check_log(fw, klog_diff, klog_errors, klog_oopses, klog_warn_ons);
 
+	fwts_pm_timeline_init(&timeline, FWTS_PM_TIMELINE_HIBERNATE);
+	if (klog_diff)
+		fwts_pm_timeline_scan(klog_diff, &timeline);
+	fwts_pm_timeline_log(fw, &timeline);
+	fwts_pm_timeline_stats_add(timings, &timeline);
+
 	fwts_progress_message(fw, percent, "(Checking for PM errors)");
 
 	/* Add in error check for pm-hibernate status */
@@ -310,41 +354,41 @@ static int s4_hibernate(fwts_framework *fw,
 		(*pm_errors)++;
 	}
 
-	if (fwts_klog_regex_find(fw, klog_diff, "Freezing user space processes.*done") < 1) {
+	fwts_klog_regex_find_all(fw, klog_diff, s4_regexes, FWTS_ARRAY_SIZE(s4_regexes));
+
+	if (s4_regexes[S4_FREEZE_USER_SPACE].count < 1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "UserSpaceTaskFreeze",
 			"Failed to freeze user space processes.");
 		(*pm_errors)++;
 	}
 
-	if (fwts_klog_regex_find(fw, klog_diff, "Freezing remaining freezable tasks.*done") < 1) {
+	if (s4_regexes[S4_FREEZE_TASKS].count < 1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "KernelTaskFreeze",
 			"Failed to freeze remaining non-user space processes.");
 		(*pm_errors)++;
 	}
 
-	if ((fwts_klog_regex_find(fw, klog_diff, "PM: freeze of devices complete") < 1) &&
-	    (fwts_klog_regex_find(fw, klog_diff, "PM: late freeze of devices complete") < 1)) {
+	if ((s4_regexes[S4_FREEZE_DEVICES].count < 1) &&
+	    (s4_regexes[S4_LATE_FREEZE_DEVICES].count < 1)) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "DeviceFreeze",
 			"Failed to freeze devices.");
 		(*pm_errors)++;
 	}
 
-	if (fwts_klog_regex_find(fw, klog_diff, "PM: Allocated.*kbytes") < 1) {
+	if (s4_regexes[S4_IMAGE_ALLOCATED].count < 1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "HibernateImageAlloc",
 			"Failed to allocate memory for hibernate image.");
 		*failed_alloc_image = 1;
 		(*pm_errors)++;
 	}
 
-	if (fwts_klog_regex_find(fw, klog_diff, "PM: Image restored successfully") < 1) {
+	if (s4_regexes[S4_IMAGE_RESTORED].count < 1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "HibernateImageRestore",
 			"Failed to restore hibernate image.");
 		(*pm_errors)++;
 	}
 
-	fwts_klog_free(klog_pre);
-	fwts_klog_free(klog_post);
-	fwts_list_free(klog_diff, NULL);
+	fwts_klog_free(klog_diff);
 tidy:
 	free(command);
 	free(quirks);
@@ -367,6 +411,7 @@ static int s4_test_multiple(fwts_framework *fw)
 	int ret = FWTS_OK;
 	int pm_debug;
 	bool retried = false;
+	fwts_pm_timeline_stats timings;
 
 #if FWTS_ENABLE_LOGIND
 #if !GLIB_CHECK_VERSION(2,35,0)
@@ -377,6 +422,7 @@ static int s4_test_multiple(fwts_framework *fw)
 
 	(void)fwts_pm_debug_get(&pm_debug);
 	(void)fwts_pm_debug_set(1);
+	fwts_pm_timeline_stats_init(&timings, FWTS_PM_TIMELINE_HIBERNATE);
 
         if (s4_multiple == 1)
                 fwts_log_info(fw, "Defaulted to run 1 test, run --s4-multiple=N to run more S4 cycles\n");
@@ -391,7 +437,7 @@ static int s4_test_multiple(fwts_framework *fw)
 		if (s4_hibernate(fw,
 			&klog_errors, &hw_errors, &pm_errors,
 			&klog_oopses, &klog_warn_ons,
-			&failed_alloc_image, percent) != FWTS_OK) {
+			&failed_alloc_image, &timings, percent) != FWTS_OK) {
 			fwts_log_error(fw, "Aborting S4 multiple tests.");
 			return FWTS_ERROR;
 		}
@@ -419,7 +465,7 @@ static int s4_test_multiple(fwts_framework *fw)
 					if (s4_hibernate(fw,
 						&klog_errors, &hw_errors, &pm_errors,
 						&klog_oopses, &klog_warn_ons,
-						&failed_alloc_image, percent) != FWTS_OK) {
+						&failed_alloc_image, &timings, percent) != FWTS_OK) {
 						fwts_log_error(fw, "Aborting S4 multiple tests.");
 						ret = FWTS_ABORTED;
 						break;
@@ -466,6 +512,9 @@ static int s4_test_multiple(fwts_framework *fw)
 		(void)fwts_set(tmp, FWTS_TRACING_BUFFER_SIZE);
 	}
 
+	if (timings.cycles > 1)
+		fwts_pm_timeline_stats_log(fw, &timings);
+
 	if (klog_errors > 0)
 		fwts_log_info(fw, "Found %d errors in kernel log.", klog_errors);
 	else
@@ -599,6 +648,7 @@ static fwts_framework_minor_test s4_tests[] = {
 static fwts_framework_ops s4_ops = {
 	.description = "S4 hibernate/resume test.",
 	.init        = s4_init,
+	.deinit      = s4_deinit,
 	.minor_tests = s4_tests,
 	.options     = s4_options,
 	.options_handler = s4_options_handler,
@@ -483,27 +483,26 @@ static void syntaxcheck_give_advice(fwts_framework *fw, uint32_t error_code)
 
 /*
  *  syntaxcheck_single_table()
- *	disassemble and reassemble a table, check for errors. which indicates the Nth
+ *	check the reassembly of a table for errors, n indicates the Nth
  *	table
  */
 static int syntaxcheck_single_table(
 	fwts_framework *fw,
 	const fwts_acpi_table_info *info,
-	const int n)
+	const int n,
+	const int ret,
+	fwts_list *iasl_disassembly,
+	fwts_list *iasl_stdout,
+	fwts_list *iasl_stderr)
 {
 	fwts_list_link *item;
 	int errors = 0;
 	int warnings = 0;
 	int remarks = 0;
-	fwts_list *iasl_stdout = NULL,
-		  *iasl_stderr = NULL,
-		  *iasl_disassembly = NULL;
-
-	if (fwts_iasl_reassemble(fw, info,
-		&iasl_disassembly, &iasl_stdout, &iasl_stderr) != FWTS_OK) {
-		fwts_text_list_free(iasl_disassembly);
-		fwts_text_list_free(iasl_stderr);
-		fwts_text_list_free(iasl_stdout);
+
+	FWTS_UNUSED(iasl_stdout);
+
+	if (ret != FWTS_OK) {
 		fwts_aborted(fw, "Cannot re-assasemble with iasl.");
 		return FWTS_ERROR;
 	}
@@ -626,10 +625,6 @@ static int syntaxcheck_single_table(
 		}
 	}
 
-	fwts_text_list_free(iasl_disassembly);
-	fwts_text_list_free(iasl_stdout);
-	fwts_text_list_free(iasl_stderr);
-
 	if (errors + warnings + remarks > 0)
 		fwts_log_info(fw, "Table %s (%d) reassembly: Found %d errors, %d warnings, %d remarks.",
 			info->name, n, errors, warnings, remarks);
@@ -641,19 +636,38 @@ static int syntaxcheck_single_table(
 	return FWTS_OK;
 }
 
+/*
+ *  syntaxcheck_tables()
+ *	reassemble all the tables containing AML, the tables are
+ *	reassembled in parallel and then checked in table order
+ */
 static int syntaxcheck_tables(fwts_framework *fw)
 {
+	fwts_acpi_table_info **tables = NULL;
 	int i, n;
 
-	for (i = 0, n = 0; i < ACPI_MAX_TABLES; i++) {
-		fwts_acpi_table_info *info;
+	for (i = 0, n = 0; ; i++) {
+		fwts_acpi_table_info *info, **tmp;
 
 		if (fwts_acpi_get_table(fw, i, &info) != FWTS_OK)
 			break;
-		if (info && info->has_aml)
-			syntaxcheck_single_table(fw, info, n++);
+		if (info == NULL)
+			break;
+		if (!info->has_aml)
+			continue;
+
+		if ((tmp = realloc(tables, (n + 1) * sizeof(*tables))) == NULL) {
+			fwts_log_error(fw, "Cannot allocate list of tables to reassemble.");
+			free(tables);
+			return FWTS_ERROR;
+		}
+		tables = tmp;
+		tables[n++] = info;
 	}
 
+	(void)fwts_iasl_reassemble_tables(fw, tables, n, syntaxcheck_single_table);
+	free(tables);
+
 	return FWTS_OK;
 }
 
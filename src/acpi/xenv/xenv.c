@@ -71,6 +71,6 @@ static fwts_framework_ops xenv_check_ops = {
 };
 
 FWTS_REGISTER("xenv", &xenv_check_ops, FWTS_TEST_ANYTIME,
-	FWTS_FLAG_BATCH | FWTS_FLAG_ACPI)
+	FWTS_FLAG_BATCH | FWTS_FLAG_ACPI | FWTS_FLAG_READ_ONLY)
 
 #endif
@@ -34,7 +34,7 @@
 
 static off_t ebda_addr = FWTS_NO_EBDA;
 
-static fwts_list *memory_map;
+static fwts_memory_map *memory_map;
 
 static int ebda_init(fwts_framework *fw)
 {
@@ -60,7 +60,7 @@ static int ebda_deinit(fwts_framework *fw)
 {
 	FWTS_UNUSED(fw);
 
-	fwts_klog_free(memory_map);
+	fwts_memory_map_table_free(memory_map);
 
 	return FWTS_OK;
 }
@@ -23,7 +23,7 @@
 
 static int memory_mapdump_util(fwts_framework *fw)
 {
-	fwts_list *memory_mapdump_memory_map_info;
+	fwts_memory_map *memory_mapdump_memory_map_info;
 
 	if ((memory_mapdump_memory_map_info =
 		fwts_memory_map_table_load(fw)) == NULL) {
@@ -283,24 +283,22 @@ static int check_prefetchable(
 	const uint64_t address,
 	bool *pref)
 {
-	char path[PATH_MAX];
-	uint8_t config[64];
-	int fd, i, n, bars;
+	fwts_pci_snapshot_device *pci_device;
+	uint8_t *config;
+	int i, bars;
 	uint32_t *bar;
 
 	*pref = false;
-	snprintf(path, sizeof(path), FWTS_PCI_DEV_PATH "/%s/config", device);
-	if ((fd = open(path, O_RDONLY)) < 0) {
+	pci_device = fwts_pci_snapshot_find_name(fwts_pci_snapshot_get(fw), device);
+	if (pci_device == NULL) {
 		fwts_log_error(fw, "Cannot read PCI config for device %s\n", device);
 		return FWTS_ERROR;
 	}
 
-	n = read(fd, config, sizeof(config));
-	(void)close(fd);
-
 	/* config space too small? ignore for now */
-	if (n < 64)
+	if (pci_device->config_len < 64)
 		return FWTS_OK;
+	config = pci_device->config;
 
 	/* Type, mask off top bit so we can cater for multi-function devices */
 	switch (config[FWTS_PCI_CONFIG_HEADER_TYPE] & 0x7f) {
@@ -636,15 +634,25 @@ static int mtrr_test2(fwts_framework *fw)
 	if (klog != NULL) {
 		bool failed = false;
 
-		if (fwts_klog_regex_find(fw, klog, "mtrr: your CPUs had inconsistent fixed MTRR settings") > 0) {
+		fwts_log_regex regexes[] = {
+			{ .pattern = "mtrr: your CPUs had inconsistent fixed MTRR settings" },
+			{ .pattern = "mtrr: your CPUs had inconsistent variable MTRR settings" },
+			{ .pattern = "mtrr: your CPUs had inconsistent MTRRdefType" },
+		};
+
+		(void)fwts_log_regex_compile(fw, regexes, FWTS_ARRAY_SIZE(regexes));
+		fwts_klog_regex_find_all(fw, klog, regexes, FWTS_ARRAY_SIZE(regexes));
+		fwts_log_regex_free(regexes, FWTS_ARRAY_SIZE(regexes));
+
+		if (regexes[0].count > 0) {
 			fwts_log_info(fw, "Detected CPUs with inconsistent fixed MTRR settings which the kernel fixed.");
 			failed = true;
 		}
-		if (fwts_klog_regex_find(fw, klog, "mtrr: your CPUs had inconsistent variable MTRR settings") > 0) {
+		if (regexes[1].count > 0) {
 			fwts_log_info(fw, "Detected CPUs with inconsistent variable MTRR settings which the kernel fixed.");
 			failed = true;
 		}
-		if (fwts_klog_regex_find(fw, klog, "mtrr: your CPUs had inconsistent MTRRdefType") > 0) {
+		if (regexes[2].count > 0) {
 			fwts_log_info(fw, "Detected CPUs with inconsistent variable MTRR settings which the kernel fixed.");
 			failed = true;
 		}
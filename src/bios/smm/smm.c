@@ -22,9 +22,6 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#include <fcntl.h>
-
-#define FWTS_INTEL_HOST_PATH	"/sys/bus/pci/devices/0000:00:00.0/config"
 
 #define FWTS_GGC		0x50
 #define FWTS_TSEGMB		0xB8
@@ -56,20 +53,20 @@ static int smm_deinit(fwts_framework *fw)
 
 static int smm_test0(fwts_framework *fw)
 {
-	uint8_t config[256];
+	const fwts_pci_snapshot_device *host;
+	const uint8_t *config;
 	bool passed = true;
-	int fd;
 
-	if ((fd = open(FWTS_INTEL_HOST_PATH, O_RDONLY)) < 0) {
+	host = fwts_pci_snapshot_find(fwts_pci_snapshot_get(fw), 0, 0, 0, 0);
+	if (!host) {
 		fwts_log_warning(fw, "Could not open PCI HOST bridge config data\n");
 		return FWTS_ERROR;
 	}
-	if (read(fd, config, sizeof(config)) < 0) {
+	if (host->config_len <= FWTS_TOLUD) {
 		fwts_log_warning(fw, "Could not read PCI HOST bridge config data\n");
-		(void)close(fd);
 		return FWTS_ERROR;
 	}
-	(void)close(fd);
+	config = host->config;
 
 	if ((config[FWTS_GGC] & FWTS_LOCK_FIELD) != 1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "SMMGGCNotLocked",
@@ -284,11 +284,236 @@ static uint64_t get_bios_limit(struct cpu *cpu)
 	return value;
 }
 
+/*
+ *  parse_cpu_list()
+ *	mark the CPUs in a sysfs CPU list such as "0-3,8" in set
+ */
+static void parse_cpu_list(const char *str, bool *set, const int max_cpus)
+{
+	while (str && *str) {
+		char *end;
+		long first, last, i;
+
+		first = strtol(str, &end, 10);
+		if (end == str)
+			break;
+		last = first;
+		if (*end == '-') {
+			str = end + 1;
+			last = strtol(str, &end, 10);
+			if (end == str)
+				break;
+		}
+		for (i = first; (i <= last) && (i < max_cpus); i++)
+			if (i >= 0)
+				set[i] = true;
+		str = end;
+		if (*str == ',')
+			str++;
+		else
+			break;
+	}
+}
+
+/*
+ *  get_domain_cpus()
+ *	find all the CPUs that are affected by benchmarking the
+ *	frequency domain of a master CPU, that is the CPUs related
+ *	to it and their SMT siblings
+ */
+static void get_domain_cpus(struct cpu *cpu, bool *set, const int max_cpus)
+{
+	char path[PATH_MAX];
+	bool *related;
+	char *str;
+	int i;
+
+	memset(set, 0, max_cpus * sizeof(*set));
+	if (cpu->idx < max_cpus)
+		set[cpu->idx] = true;
+
+	if ((related = calloc(max_cpus, sizeof(*related))) == NULL)
+		return;
+
+	cpu_mkpath(path, sizeof(path), cpu, "related_cpus");
+	if ((str = fwts_get(path)) != NULL) {
+		parse_cpu_list(str, related, max_cpus);
+		free(str);
+	}
+	if (cpu->idx < max_cpus)
+		related[cpu->idx] = true;
+
+	for (i = 0; i < max_cpus; i++) {
+		if (!related[i])
+			continue;
+		set[i] = true;
+		snprintf(path, sizeof(path), "%s/cpu%d/topology/thread_siblings_list",
+			FWTS_CPU_PATH, i);
+		if ((str = fwts_get(path)) != NULL) {
+			parse_cpu_list(str, set, max_cpus);
+			free(str);
+		}
+	}
+	free(related);
+}
+
+/*
+ *  benchmark_cpus()
+ *	run the benchmark on a batch of CPUs in parallel, or one after
+ *	the other if the parallel workers could not be run
+ */
+static void benchmark_cpus(
+	fwts_framework *fw,
+	struct cpu **batch,
+	const int n,
+	const int step)
+{
+	fwts_cpu_benchmark_result *results;
+	int *idxs, *rets;
+	bool parallel = false;
+	int i;
+
+	idxs = calloc(n, sizeof(*idxs));
+	rets = calloc(n, sizeof(*rets));
+	results = calloc(n, sizeof(*results));
+
+	if (idxs && rets && results) {
+		for (i = 0; i < n; i++)
+			idxs[i] = batch[i]->idx;
+		parallel = (fwts_cpu_benchmark_cpus(fw, idxs, n, results, rets) == FWTS_OK);
+	}
+
+	for (i = 0; i < n; i++) {
+		fwts_cpu_freq *freq = &batch[i]->freqs[step];
+		int ret;
+
+		if (parallel) {
+			freq->perf = results[i];
+			ret = rets[i];
+		} else {
+			ret = fwts_cpu_benchmark(fw, batch[i]->idx, &freq->perf);
+		}
+		if (ret != FWTS_OK)
+			fwts_log_error(fw, "Failed to get CPU performance for "
+				"CPU frequency %" PRId64 " Hz.", freq->Hz);
+	}
+
+	free(results);
+	free(rets);
+	free(idxs);
+}
+
+/*
+ *  benchmark_master_cpus()
+ *	benchmark every frequency of all the online master CPUs.
+ *	Frequency domains that share no CPUs (nor SMT siblings) are
+ *	benchmarked in parallel, one pinned worker per domain.
+ */
+static void benchmark_master_cpus(fwts_framework *fw, const int n_master_cpus)
+{
+	struct cpu **masters, **batch;
+	bool **domains, *busy;
+	int *batch_of;
+	int max_cpus = 0, n_masters = 0, n_batches = 0;
+	int total_steps = 0, done_steps = 0;
+	int i, j, b;
+
+	for (i = 0; i < num_cpus; i++)
+		if (cpus[i].idx >= max_cpus)
+			max_cpus = cpus[i].idx + 1;
+
+	masters = calloc(n_master_cpus, sizeof(*masters));
+	batch = calloc(n_master_cpus, sizeof(*batch));
+	domains = calloc(n_master_cpus, sizeof(*domains));
+	batch_of = calloc(n_master_cpus, sizeof(*batch_of));
+	busy = calloc(max_cpus, sizeof(*busy));
+	if (!masters || !batch || !domains || !batch_of || !busy) {
+		fwts_log_error(fw, "Cannot allocate CPU frequency domain information.");
+		goto out;
+	}
+
+	for (i = 0; (i < num_cpus) && (n_masters < n_master_cpus); i++) {
+		if (!(cpus[i].online && cpus[i].master))
+			continue;
+		if ((domains[n_masters] = calloc(max_cpus, sizeof(bool))) == NULL) {
+			fwts_log_error(fw, "Cannot allocate CPU frequency domain information.");
+			goto out;
+		}
+		get_domain_cpus(&cpus[i], domains[n_masters], max_cpus);
+		total_steps += cpus[i].n_freqs;
+		masters[n_masters++] = &cpus[i];
+	}
+
+	/* Put each domain in the first batch it does not overlap with */
+	for (i = 0; i < n_masters; i++)
+		batch_of[i] = -1;
+
+	for (i = 0; i < n_masters; i++) {
+		if (batch_of[i] >= 0)
+			continue;
+
+		memset(busy, 0, max_cpus * sizeof(*busy));
+		for (j = i; j < n_masters; j++) {
+			bool overlap = false;
+			int k;
+
+			if (batch_of[j] >= 0)
+				continue;
+			for (k = 0; k < max_cpus; k++) {
+				if (domains[j][k] && busy[k]) {
+					overlap = true;
+					break;
+				}
+			}
+			if (overlap)
+				continue;
+			for (k = 0; k < max_cpus; k++)
+				busy[k] |= domains[j][k];
+			batch_of[j] = n_batches;
+		}
+		n_batches++;
+	}
+
+	for (b = 0; b < n_batches; b++) {
+		int step, max_freqs = 0;
+
+		for (i = 0; i < n_masters; i++)
+			if ((batch_of[i] == b) && (masters[i]->n_freqs > max_freqs))
+				max_freqs = masters[i]->n_freqs;
+
+		for (step = 0; step < max_freqs; step++) {
+			int n = 0;
+
+			for (i = 0; i < n_masters; i++) {
+				if ((batch_of[i] != b) || (step >= masters[i]->n_freqs))
+					continue;
+				cpu_set_frequency(fw, masters[i], masters[i]->freqs[step].Hz);
+				batch[n++] = masters[i];
+			}
+			benchmark_cpus(fw, batch, n, step);
+
+			done_steps += n;
+			fwts_progress(fw, (100 * done_steps) / total_steps);
+		}
+
+		for (i = 0; i < n_masters; i++)
+			if (batch_of[i] == b)
+				cpu_set_lowest_frequency(fw, masters[i]);
+	}
+out:
+	if (domains)
+		for (i = 0; i < n_masters; i++)
+			free(domains[i]);
+	free(busy);
+	free(batch_of);
+	free(domains);
+	free(batch);
+	free(masters);
+}
+
 static int test_one_cpu_performance(
 	fwts_framework *fw,
-	struct cpu *cpu,
-	const int cpu_idx,
-	const int n_online_cpus)
+	struct cpu *cpu)
 {
 	uint64_t cpu_top_perf = 1;
 	int i;
@@ -296,20 +521,9 @@ static int test_one_cpu_performance(
 	for (i = 0; i < cpu->n_freqs; i++) {
 		uint64_t perf;
 
-		cpu_set_frequency(fw, cpu, cpu->freqs[i].Hz);
-
-		if (fwts_cpu_benchmark(fw, cpu->idx, &cpu->freqs[i].perf)
-				!= FWTS_OK) {
-			fwts_log_error(fw, "Failed to get CPU performance for "
-				"CPU frequency %" PRId64 " Hz.",
-				cpu->freqs[i].Hz);
-		}
 		perf = fwts_cpu_benchmark_best_result(&cpu->freqs[i].perf);
 		if (perf > cpu_top_perf)
 			cpu_top_perf = perf;
-
-		fwts_progress(fw, (100 * ((cpu_idx * cpu->n_freqs) + i)) /
-				(n_online_cpus * cpu->n_freqs));
 	}
 
 	fwts_log_info(fw, "CPU %d: %i CPU frequency steps supported.",
@@ -365,7 +579,7 @@ static int test_one_cpu_performance(
 
 static int cpufreq_test_cpu_performance(fwts_framework *fw)
 {
-	int n_master_cpus, i, c, rc;
+	int n_master_cpus, i, rc;
 	bool ok = true;
 
 	n_master_cpus = 0;
@@ -385,15 +599,16 @@ static int cpufreq_test_cpu_performance(fwts_framework *fw)
 	}
 
 	/* then do the benchmark */
-	for (i = 0, c = 0; i < num_cpus; i++) {
+	if (n_master_cpus > 0)
+		benchmark_master_cpus(fw, n_master_cpus);
+
+	for (i = 0; i < num_cpus; i++) {
 		if (!(cpus[i].online && cpus[i].master))
 			continue;
 
-		rc = test_one_cpu_performance(fw, &cpus[i], c++, n_master_cpus);
+		rc = test_one_cpu_performance(fw, &cpus[i]);
 		if (rc != FWTS_OK)
 			ok = false;
-
-		cpu_set_lowest_frequency(fw, &cpus[i]);
 	}
 
 	if (ok)
@@ -25,6 +25,7 @@
 typedef void (*msr_callback_check)(fwts_framework *fw, const uint64_t val);
 
 static int ncpus;
+static int *cpus;
 static bool intel_cpu;
 static bool amd_cpu;
 static bool hygon_cpu;
@@ -33,6 +34,7 @@ static fwts_cpuinfo_x86 *cpuinfo;
 static int msr_init(fwts_framework *fw)
 {
 	char *bios_vendor;
+	int i;
 
 	if ((cpuinfo = fwts_cpu_get_info(-1)) == NULL) {
 		fwts_log_error(fw, "Cannot get CPU info");
@@ -67,6 +69,17 @@ static int msr_init(fwts_framework *fw)
 		}
 		free(bios_vendor);
 	}
+
+	if ((cpus = calloc(ncpus, sizeof(*cpus))) == NULL) {
+		fwts_log_error(fw, "Out of memory allocating CPU list.");
+		return FWTS_ERROR;
+	}
+	for (i = 0; i < ncpus; i++)
+		cpus[i] = i;
+
+	/* Keep the msr devices open while the tests run */
+	(void)fwts_cpu_msr_cache_open();
+
 	return FWTS_OK;
 }
 
@@ -74,75 +87,45 @@ static int msr_deinit(fwts_framework *fw)
 {
 	FWTS_UNUSED(fw);
 
+	fwts_cpu_msr_cache_close();
 	fwts_cpu_free_info(cpuinfo);
+	free(cpus);
+	cpus = NULL;
 
 	return FWTS_OK;
 }
 
-static int msr_consistent(
-	fwts_framework *fw,
+/*
+ *  msr_consistent_report()
+ *	check the shifted and masked MSR values read from each
+ *	CPU are the same and report the outcome
+ */
+static int msr_consistent_report(fwts_framework *fw,
+	const fwts_log_level level,
+	const char *const msr_name,
 	const uint32_t msr,
 	const int shift,
 	const uint64_t mask,
-	uint64_t *const vals,
-	int *const inconsistent_count,
-	bool *const inconsistent)
+	const msr_callback_check callback,
+	const uint64_t *const vals)
 {
+	bool *inconsistent;
+	int inconsistent_count = 0;
 	int cpu;
 
-	*inconsistent_count = 0;
-
-	for (cpu = 0; cpu < ncpus; cpu++) {
-		uint64_t val;
-		if (fwts_cpu_readmsr(fw, cpu, msr, &val) != FWTS_OK) {
-			return FWTS_ERROR;
-		}
-		val >>= shift;
-		val &= mask;
-		vals[cpu] = val;
+	if ((inconsistent = calloc(ncpus, sizeof(bool))) == NULL) {
+		fwts_log_error(fw, "Out of memory allocating msr value buffers.");
+		return FWTS_ERROR;
 	}
 
 	for (cpu = 0; cpu < ncpus; cpu++) {
 		if (vals[0] != vals[cpu]) {
-			(*inconsistent_count)++;
+			inconsistent_count++;
 			inconsistent[cpu] = true;
-		} else {
-			inconsistent[cpu] = false;
 		}
 	}
-	return FWTS_OK;
-}
 
-static int msr_consistent_check(fwts_framework *fw,
-	const fwts_log_level level,
-	const char *const msr_name,
-	const uint32_t msr,
-	const int shift,
-	const uint64_t mask,
-	const msr_callback_check callback)
-{
-	uint64_t *vals;
-	bool *inconsistent;
-	int inconsistent_count;
-
-	if ((vals = calloc(ncpus, sizeof(uint64_t))) == NULL) {
-		fwts_log_error(fw, "Out of memory allocating msr value buffers.");
-		return FWTS_ERROR;
-	}
-	if ((inconsistent = calloc(ncpus, sizeof(bool))) == NULL) {
-		fwts_log_error(fw, "Out of memory allocating msr value buffers.");
-		free(vals);
-		return FWTS_ERROR;
-	}
-	if (msr_consistent(fw, msr, shift, mask,
-		vals, &inconsistent_count, inconsistent) != FWTS_OK) {
-		free(inconsistent);
-		free(vals);
-		return FWTS_ERROR;
-	}
 	if (inconsistent_count > 0) {
-		int cpu;
-
 		fwts_failed(fw, level, "MSRCPUsInconsistent",
 			"MSR 0x%8.8" PRIx32 " %s has %d inconsistent values across "
 			"%d CPUs (shift: %d mask: 0x%" PRIx64 ").",
@@ -164,11 +147,38 @@ static int msr_consistent_check(fwts_framework *fw,
 	}
 
 	free(inconsistent);
-	free(vals);
 
 	return FWTS_OK;
 }
 
+static int msr_consistent_check(fwts_framework *fw,
+	const fwts_log_level level,
+	const char *const msr_name,
+	const uint32_t msr,
+	const int shift,
+	const uint64_t mask,
+	const msr_callback_check callback)
+{
+	uint64_t *vals;
+	int cpu, ret;
+
+	if ((vals = calloc(ncpus, sizeof(uint64_t))) == NULL) {
+		fwts_log_error(fw, "Out of memory allocating msr value buffers.");
+		return FWTS_ERROR;
+	}
+	if (fwts_cpu_readmsrs(fw, cpus, ncpus, &msr, 1, vals, NULL) != FWTS_OK) {
+		free(vals);
+		return FWTS_ERROR;
+	}
+	for (cpu = 0; cpu < ncpus; cpu++)
+		vals[cpu] = (vals[cpu] >> shift) & mask;
+
+	ret = msr_consistent_report(fw, level, msr_name, msr, shift, mask, callback, vals);
+	free(vals);
+
+	return ret;
+}
+
 static int msr_pstate_ratios(fwts_framework *fw)
 {
 	if (intel_cpu) {
@@ -698,13 +708,55 @@ static const msr_info IA32_haswell_MSRs[] = {
 	{ NULL,				0x00000000,	0, NULL },
 };
 
+/*
+ *  msr_table_check()
+ *	read all the MSRs in the table from all CPUs in one batch
+ *	and check each MSR is consistent across the CPUs
+ */
 static int msr_table_check(fwts_framework *fw, const msr_info *const info)
 {
-	int i;
+	uint32_t *regs;
+	uint64_t *raw, *vals;
+	int *rets;
+	int i, n, cpu;
+
+	for (n = 0; info[n].name != NULL; n++)
+		;
+	if (n == 0)
+		return FWTS_OK;
+
+	regs = calloc(n, sizeof(*regs));
+	raw = calloc((size_t)n * ncpus, sizeof(*raw));
+	rets = calloc((size_t)n * ncpus, sizeof(*rets));
+	vals = calloc(ncpus, sizeof(*vals));
+	if (!regs || !raw || !rets || !vals) {
+		fwts_log_error(fw, "Out of memory allocating msr value buffers.");
+		goto out;
+	}
+
+	for (i = 0; i < n; i++)
+		regs[i] = info[i].msr;
+
+	(void)fwts_cpu_readmsrs(fw, cpus, ncpus, regs, n, raw, rets);
 
-	for (i = 0; info[i].name != NULL; i++)
-		msr_consistent_check(fw, LOG_LEVEL_MEDIUM,
-			info[i].name, info[i].msr, 0, info[i].mask, info[i].callback);
+	for (i = 0; i < n; i++) {
+		/* MSRs that cannot be read on every CPU are not checked */
+		for (cpu = 0; cpu < ncpus; cpu++) {
+			if (rets[(cpu * n) + i] != FWTS_OK)
+				break;
+			vals[cpu] = raw[(cpu * n) + i] & info[i].mask;
+		}
+		if (cpu < ncpus)
+			continue;
+
+		msr_consistent_report(fw, LOG_LEVEL_MEDIUM,
+			info[i].name, info[i].msr, 0, info[i].mask, info[i].callback, vals);
+	}
+out:
+	free(vals);
+	free(rets);
+	free(raw);
+	free(regs);
 
 	return FWTS_OK;
 }
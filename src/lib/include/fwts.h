@@ -165,6 +165,7 @@
 #include "fwts_log.h"
 #include "fwts_log_scan.h"
 #include "fwts_list.h"
+#include "fwts_hash.h"
 #include "fwts_text_list.h"
 #include "fwts_set.h"
 #include "fwts_get.h"
@@ -218,6 +219,7 @@
 #include "fwts_safe_mem.h"
 #include "fwts_devicetree.h"
 #include "fwts_pm_debug.h"
+#include "fwts_pm_timeline.h"
 #include "fwts_modprobe.h"
 
 #endif
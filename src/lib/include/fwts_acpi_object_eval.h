@@ -27,9 +27,22 @@
 #include "acpi.h"
 #pragma GCC diagnostic error "-Wunused-parameter"
 
+/*
+ *  ACPI namespace object, objects with the same final
+ *  NameSeg are chained together in namespace order
+ */
+typedef struct fwts_acpi_object_info {
+	char *name;				/* Full path name */
+	ACPI_HANDLE handle;			/* Object handle */
+	ACPI_OBJECT_TYPE type;			/* Object type */
+	struct fwts_acpi_object_info *next;	/* Next object with same NameSeg */
+} fwts_acpi_object_info;
+
 int fwts_acpi_init(fwts_framework *fw);
 int fwts_acpi_deinit(fwts_framework *fw);
 char *fwts_acpi_object_exists(const char *name);
+fwts_acpi_object_info *fwts_acpi_object_find_first(const char *name);
+fwts_acpi_object_info *fwts_acpi_object_find_next(fwts_acpi_object_info *info, const char *name);
 fwts_list *fwts_acpi_object_get_names(void);
 void fwts_acpi_object_dump(fwts_framework *fw, const ACPI_OBJECT *obj);
 void fwts_acpi_object_evaluate_report_error(fwts_framework *fw,
@@ -22,8 +22,6 @@
 
 #include "fwts.h"
 
-#define ACPI_MAX_TABLES		(128)
-
 #define fwts_acpi_revision_check(table, actual, must_be, passed) \
 	fwts_acpi_fixed_value(fw, LOG_LEVEL_HIGH, table, "Revision", actual, must_be, passed)
 
@@ -32,5 +32,8 @@ void fwts_acpica_sem_count_clear(void);
 void fwts_acpica_sem_count_get(int *acquired, int *released);
 void fwts_acpi_region_handler_called_set(const bool val);
 bool fwts_acpi_region_handler_called_get(void);
+void fwts_acpi_reset(void);
+int  fwts_acpi_release(void);
+void fwts_acpi_session_stats(unsigned long *inits, unsigned long *inits_saved);
 
 #endif
@@ -22,6 +22,21 @@
 
 #include "fwts.h"
 
+#define FWTS_SHA256_DIGEST_SIZE	(32)
+
+/*
+ *  Running SHA-256 state, for content addressing rather than security
+ */
+typedef struct {
+	uint32_t state[8];		/* intermediate hash */
+	uint64_t length;		/* bytes hashed so far */
+	uint8_t block[64];		/* partially filled block */
+} fwts_sha256;
+
 uint8_t fwts_checksum(const uint8_t *data, const size_t length);
 
+void fwts_sha256_init(fwts_sha256 *ctx);
+void fwts_sha256_update(fwts_sha256 *ctx, const void *data, size_t length);
+void fwts_sha256_final(fwts_sha256 *ctx, uint8_t digest[FWTS_SHA256_DIGEST_SIZE]);
+
 #endif
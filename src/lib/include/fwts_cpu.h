@@ -58,6 +58,10 @@ typedef struct cpu_benchmark_result {
 } fwts_cpu_benchmark_result;
 
 int fwts_cpu_readmsr(fwts_framework *fw, const int cpu, const uint32_t reg, uint64_t *val);
+int fwts_cpu_readmsrs(fwts_framework *fw, const int *cpus, const int ncpus,
+		const uint32_t *regs, const int nregs, uint64_t *vals, int *rets);
+int fwts_cpu_msr_cache_open(void);
+void fwts_cpu_msr_cache_close(void);
 
 int fwts_cpu_is_Intel(bool *is_intel);
 int fwts_cpu_is_AMD(bool *is_amd);
@@ -71,8 +75,11 @@ int fwts_cpu_enumerate(void);
 int fwts_cpu_consume(const int seconds);
 int fwts_cpu_consume_start(void);
 void fwts_cpu_consume_complete(void);
+int fwts_cpu_consume_cpus(const int *cpus, const int n, const int usecs, bool *pinned);
 int fwts_cpu_benchmark(fwts_framework *fw, const int cpu,
 		fwts_cpu_benchmark_result *result);
+int fwts_cpu_benchmark_cpus(fwts_framework *fw, const int *cpus, const int n,
+		fwts_cpu_benchmark_result *results, int *rets);
 
 uint64_t fwts_cpu_benchmark_best_result(fwts_cpu_benchmark_result *res);
 
@@ -27,4 +27,25 @@ int fwts_lib_efi_runtime_close(const int fd);
 int fwts_lib_efi_runtime_kernel_lockdown(fwts_framework *fw);
 int fwts_lib_efi_runtime_module_init(fwts_framework *fw, int *fd);
 
+/*
+ *  Latency of calls to an EFI runtime service, in nanoseconds
+ */
+typedef struct {
+	uint64_t count;		/* number of calls */
+	uint64_t min;		/* fastest call */
+	uint64_t p50;		/* median call */
+	uint64_t p99;		/* 99th percentile call */
+	uint64_t max;		/* slowest call */
+	uint64_t outliers;	/* calls slower than the service threshold */
+} fwts_efi_runtime_latency;
+
+typedef int (*fwts_efi_runtime_ioctl_func)(const int fd, const unsigned long request, void *arg);
+
+int fwts_lib_efi_runtime_ioctl(const int fd, const unsigned long request, void *arg);
+void fwts_lib_efi_runtime_ioctl_set(fwts_efi_runtime_ioctl_func func);
+void fwts_lib_efi_runtime_latency_reset(void);
+int fwts_lib_efi_runtime_latency_get(const unsigned long request, fwts_efi_runtime_latency *latency);
+int fwts_lib_efi_runtime_latency_threshold(const char *str);
+void fwts_lib_efi_runtime_latency_report(fwts_framework *fw);
+
 #endif
@@ -31,6 +31,7 @@ typedef struct fwts_framework fwts_framework;
 #include "fwts_arch.h"
 #include "fwts_log.h"
 #include "fwts_list.h"
+#include "fwts_hash.h"
 #include "fwts_acpica_mode.h"
 #include "fwts_types.h"
 #include "fwts_firmware.h"
@@ -63,6 +64,7 @@ typedef enum {
 	FWTS_FLAG_COMPLIANCE_ACPI		= 0x00800000,
 	FWTS_FLAG_SBBR				= 0x01000000,
 	FWTS_FLAG_EBBR				= 0x02000000,
+	FWTS_FLAG_READ_ONLY			= 0x04000000,
 	FWTS_FLAG_XBBR				= FWTS_FLAG_SBBR | FWTS_FLAG_EBBR
 } fwts_framework_flags;
 
@@ -113,6 +115,7 @@ struct fwts_framework {
 	fwts_log *results;			/* log for test results */
 	char *results_logname;			/* filename of results log */
 	char *lspci;				/* path to lspci */
+	char *pci_dev_path;			/* path to PCI devices sysfs tree */
 	char *acpi_table_path;			/* path to raw ACPI tables */
 	char *acpi_table_acpidump_file;		/* path to ACPI dump file */
 	char *clog;				/* path to dump of coreboot log */
@@ -120,6 +123,7 @@ struct fwts_framework {
 	char *olog;				/* path to OLOG */
 	char *json_data_path;			/* path to application json data files, e.g. json klog data */
 	char *json_data_file;			/* json file to use for olog analysis */
+	char *iasl_cache_path;			/* --iasl-cache directory of cached iasl results */
 	struct fwts_framework_test *current_major_test; /* current test */
 	void *rsdp;				/* ACPI RSDP address */
 	void *fdt;				/* Flattened device tree data */
@@ -130,6 +134,7 @@ struct fwts_framework {
 	uint32_t major_tests_total;		/* Total number of major tests */
 	uint32_t total_run;			/* total number of major tests run */
 	uint32_t minor_test_progress;		/* Percentage completion of current test */
+	uint32_t jobs;				/* --jobs, max number of read-only tests run at once */
 
 	fwts_results minor_tests;		/* results for each minor test */
 	fwts_results total;			/* totals over all tests */
@@ -140,6 +145,8 @@ struct fwts_framework {
 	fwts_log_type	log_type;		/* Output log type, default is plain text ASCII */
 	fwts_list errors_filter_keep;		/* Results to keep, empty = keep all */
 	fwts_list errors_filter_discard;	/* Results to discard, empty = discard none */
+	fwts_hash *errors_filter_keep_hash;	/* Index of errors_filter_keep labels */
+	fwts_hash *errors_filter_discard_hash;	/* Index of errors_filter_discard labels */
 	fwts_acpica_mode acpica_mode;		/* ACPICA mode flags */
 	fwts_pm_method pm_method;
 	fwts_architecture host_arch;		/* arch FWTS was built for */
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2021 Canonical
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef __FWTS_HASH_H__
+#define __FWTS_HASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ *  Simple chained hash table keyed on strings. Keys are not
+ *  copied, so the caller must keep them valid for the lifetime
+ *  of the hash. Ordering is not preserved, callers that need
+ *  insertion order keep their items on a fwts_list and use the
+ *  hash as an index into it.
+ */
+typedef struct fwts_hash_node {
+	struct fwts_hash_node *next;	/* next node in hash chain */
+	const char *key;		/* key, owned by the caller */
+	uint32_t hash;			/* cached hash of key */
+	void *data;			/* user data */
+} fwts_hash_node;
+
+typedef struct {
+	fwts_hash_node **table;		/* hash buckets */
+	size_t size;			/* number of buckets */
+	size_t count;			/* number of nodes in the hash */
+} fwts_hash;
+
+typedef void (*fwts_hash_data_free)(void *);
+
+uint32_t   fwts_hash_str(const char *str);
+fwts_hash *fwts_hash_new(const size_t size);
+void       fwts_hash_free(fwts_hash *hash, fwts_hash_data_free data_free);
+void      *fwts_hash_get(fwts_hash *hash, const char *key);
+int        fwts_hash_add(fwts_hash *hash, const char *key, void *data);
+
+/*
+ *  fwts_hash_count()
+ *	return number of items in the hash, 0 if hash is NULL
+ */
+static inline size_t fwts_hash_count(fwts_hash *hash)
+{
+	return hash ? hash->count : 0;
+}
+
+#endif
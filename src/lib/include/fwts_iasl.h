@@ -26,6 +26,10 @@
 int fwts_iasl_init(fwts_framework *fw);
 void fwts_iasl_deinit(void);
 
+int fwts_iasl_cache_open(fwts_framework *fw, const char *path);
+void fwts_iasl_cache_close(void);
+void fwts_iasl_cache_stats(unsigned long *hits, unsigned long *misses);
+
 int fwts_iasl_disassemble_all_to_file(fwts_framework *fw,
 	const char *path);
 
@@ -40,6 +44,23 @@ int fwts_iasl_reassemble(fwts_framework *fw,
 	fwts_list **iasl_stdout,
 	fwts_list **iasl_stderr);
 
+/*
+ *  Called by fwts_iasl_reassemble_tables() with the result of
+ *  reassembling the nth table, the lists are freed on return
+ */
+typedef int (*fwts_iasl_reassemble_func)(fwts_framework *fw,
+	const fwts_acpi_table_info *info,
+	const int n,
+	const int ret,
+	fwts_list *iasl_disassembly,
+	fwts_list *iasl_stdout,
+	fwts_list *iasl_stderr);
+
+int fwts_iasl_reassemble_tables(fwts_framework *fw,
+	fwts_acpi_table_info *tables[],
+	const int count,
+	fwts_iasl_reassemble_func func);
+
 const char *fwts_iasl_exception_level(uint8_t level);
 
 #endif
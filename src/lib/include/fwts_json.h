@@ -19,6 +19,8 @@
 #ifndef __FWTS_JSON_H__
 #define __FWTS_JSON_H__
 
+#include "fwts_hash.h"
+
 /*
  *  Minimal subset of json for fwts
  */
@@ -44,17 +46,22 @@ typedef enum {
 	type_array,
 } json_type;
 
+typedef struct json_arena json_arena;
+
 /*
  *  json object information
  */
 typedef struct json_object {
 	char *key;		/* Null if undefined */
 	int length;		/* Length of a collection of objects */
+	int size;		/* Allocated size of the collection */
 	json_type type;		/* Object type */
         union {
                 void *ptr;	/* string or object array pointer */
                 int  intval;	/* integer value */
         } u;
+	json_arena *arena;	/* Arena of a parsed tree, NULL if heap allocated */
+	fwts_hash *index;	/* Key index of large objects, built on demand */
 } json_object;
 
 /*
@@ -21,6 +21,8 @@
 #define __FWTS_KLOG_H__
 
 #include <sys/types.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <regex.h>
 
 #include "fwts_list.h"
@@ -32,6 +34,20 @@
 #define KERN_ERROR              0x00000002
 
 
+/*
+ *  Kernel log cursor, tracks how far the kernel log has been read
+ *  so that only newly added lines need to be fetched and checked
+ */
+typedef struct {
+	int fd;			/* /dev/kmsg or log dump file, -1 if not open */
+	bool kmsg;		/* true if fd is /dev/kmsg */
+	bool seq_valid;		/* true once a /dev/kmsg record has been read */
+	uint64_t seq;		/* next /dev/kmsg record sequence number */
+	uint64_t lost;		/* records overwritten before they were read */
+	off_t offset;		/* offset read up to in log dump file */
+	fwts_list *klog;	/* last log snapshot if no /dev/kmsg */
+} fwts_klog_cursor;
+
 typedef void (*fwts_klog_progress_func)(fwts_framework *fw, int percent);
 typedef void (*fwts_klog_scan_func)(fwts_framework *fw, char *line, int repeated, char *prevline, void *private, int *errors);
 
@@ -40,11 +56,16 @@ void       fwts_klog_scan_patterns(fwts_framework *fw, char *line, int repeated,
 fwts_list *fwts_klog_read(void);
 fwts_list *fwts_klog_find_changes(fwts_list *klog_old, fwts_list *klog_new);
 void       fwts_klog_free(fwts_list *list);
+fwts_klog_cursor *fwts_klog_cursor_open(const char *filename);
+fwts_list *fwts_klog_cursor_read(fwts_klog_cursor *cursor);
+void       fwts_klog_cursor_close(fwts_klog_cursor *cursor);
+void       fwts_klog_cursor_check_lost(fwts_framework *fw, fwts_klog_cursor *cursor);
 
 
 int        fwts_klog_firmware_check(fwts_framework *fw, fwts_klog_progress_func progress, fwts_list *klog, int *errors);
 int        fwts_klog_pm_check(fwts_framework *fw, fwts_klog_progress_func progress, fwts_list *klog, int *errors);
 int	   fwts_klog_regex_find(fwts_framework *fw, fwts_list *klog, char *pattern);
+int	   fwts_klog_regex_find_all(fwts_framework *fw, fwts_list *klog, fwts_log_regex *regexes, const int n);
 char      *fwts_klog_remove_timestamp(char *text);
 int        fwts_klog_write(fwts_framework *fw, const char *msg);
 
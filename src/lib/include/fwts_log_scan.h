@@ -40,6 +40,31 @@ typedef struct {
 	bool compiled_ok;
 } fwts_log_pattern;
 
+/*
+ *  A regex pattern compiled once for fwts_log_regex_find_all()
+ */
+typedef struct {
+	const char *pattern;		/* extended regex pattern */
+	regex_t compiled;		/* compiled regex */
+	bool compiled_ok;		/* regex compiled OK */
+	int count;			/* number of matching log lines */
+	fwts_list *lines;		/* if not NULL, matching lines are appended */
+} fwts_log_regex;
+
+typedef struct fwts_log_matcher fwts_log_matcher;
+
+/*
+ *  A pattern table loaded from the json data and the
+ *  multi-pattern matcher built from it, this is the
+ *  private data passed to fwts_log_scan_patterns()
+ */
+typedef struct {
+	json_object *objs;		/* json data the patterns are taken from */
+	fwts_log_pattern *patterns;	/* pattern table, NULL pattern terminated */
+	int count;			/* number of patterns in the table */
+	fwts_log_matcher *matcher;	/* NULL, match each pattern in turn */
+} fwts_log_patterns;
+
 typedef void (*fwts_log_progress_func)(fwts_framework *fw, int percent);
 typedef void (*fwts_log_scan_func)(fwts_framework *fw, char *line, int repeated, char *prevline, void *private, int *errors);
 
@@ -51,7 +76,19 @@ char *fwts_log_unique_label(const char *str, const char *label);
 void       fwts_log_scan_patterns(fwts_framework *fw, char *line, int repeated, char *prevline, void *private, int *errors, const char *name, const char *advice);
 fwts_compare_mode fwts_log_compare_mode_str_to_val(const char *str);
 const char *fwts_json_str(fwts_framework *fw, const char *table, int index, json_object *obj, const char *key, bool log_error);
+fwts_log_patterns *fwts_log_patterns_load(fwts_framework *fw, const char *json_data_path, const char *table, const char *label);
+void        fwts_log_patterns_free(fwts_log_patterns *table);
+fwts_log_patterns *fwts_log_patterns_get(fwts_framework *fw, const char *json_data_path, const char *table, const char *label);
+void        fwts_log_patterns_put(fwts_log_patterns *patterns);
+void        fwts_log_patterns_cache_stats(unsigned long *hits, unsigned long *misses);
+void        fwts_log_patterns_cache_free(void);
 int         fwts_log_check(fwts_framework *fw, const char *table, fwts_log_scan_func fwts_log_scan_patterns, fwts_log_progress_func progress, fwts_list *log, int *errors, const char *json_data_path, const char *label, bool remove_timestamp);
+fwts_log_matcher *fwts_log_matcher_new(fwts_log_pattern *patterns, const int count);
+void       fwts_log_matcher_free(fwts_log_matcher *matcher);
+int        fwts_log_matcher_match(fwts_framework *fw, fwts_log_matcher *matcher, const char *line);
+int        fwts_log_regex_compile(fwts_framework *fw, fwts_log_regex *regexes, const int n);
+void       fwts_log_regex_free(fwts_log_regex *regexes, const int n);
+int        fwts_log_regex_find_all(fwts_framework *fw, fwts_list *log, fwts_log_regex *regexes, const int n, bool remove_timestamp);
 int        fwts_log_regex_find(fwts_framework *fw, fwts_list *log, char *pattern, bool remove_timestamp);
 
 #endif
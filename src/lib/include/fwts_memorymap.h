@@ -37,12 +37,21 @@ typedef struct {
 	int             type;
 } fwts_memory_map_entry;
 
-int        fwts_memory_map_type(fwts_list *memory_map_list, const uint64_t memory);
-int        fwts_memory_map_is_reserved(fwts_list *memory_map_list, const uint64_t memory);
-fwts_list *fwts_memory_map_table_load(fwts_framework *fw);
-void       fwts_memory_map_table_free(fwts_list *memory_map_list);
-void       fwts_memory_map_table_dump(fwts_framework *fw, fwts_list *memory_map_list);
+typedef struct {
+	fwts_memory_map_entry *entries;	/* entries as loaded, sorted on start address */
+	size_t entries_count;
+	size_t entries_size;		/* number of entries allocated */
+	fwts_memory_map_entry *regions;	/* entries coalesced into sorted disjoint regions */
+	size_t regions_count;
+} fwts_memory_map;
+
+int        fwts_memory_map_type(fwts_memory_map *memory_map, const uint64_t memory);
+int        fwts_memory_map_is_reserved(fwts_memory_map *memory_map, const uint64_t memory);
+fwts_memory_map *fwts_memory_map_table_load(fwts_framework *fw);
+void       fwts_memory_map_table_free(fwts_memory_map *memory_map);
+void       fwts_memory_map_table_dump(fwts_framework *fw, fwts_memory_map *memory_map);
 const char *fwts_memory_map_name(const int type);
-fwts_memory_map_entry *fwts_memory_map_info(fwts_list *memory_map_list, const uint64_t memory);
+fwts_memory_map_entry *fwts_memory_map_info(fwts_memory_map *memory_map, const uint64_t memory);
+size_t     fwts_memory_map_overlaps(fwts_memory_map *memory_map, const uint64_t start, const uint64_t end, fwts_memory_map_entry **regions);
 
 #endif
@@ -193,6 +193,54 @@ typedef struct {
 	uint8_t config[256];
 } fwts_pci_device;
 
+/*
+ *  A capability in a capability chain
+ */
+typedef struct {
+	uint16_t id;			/* capability ID */
+	uint16_t offset;		/* offset in config space */
+} fwts_pci_capability;
+
+/*
+ *  A PCI function in a PCI snapshot
+ */
+typedef struct fwts_pci_snapshot_device {
+	char name[32];			/* sysfs name, e.g. 0000:00:1f.3 */
+	uint32_t segment;
+	uint8_t bus;
+	uint8_t dev;
+	uint8_t func;
+	uint8_t *config;		/* config space, up to 4K */
+	size_t config_len;		/* bytes of config space read */
+	fwts_pci_capability *caps;	/* capability chain */
+	size_t caps_count;
+	fwts_pci_capability *ext_caps;	/* extended capability chain */
+	size_t ext_caps_count;
+	struct fwts_pci_snapshot_device *downstream;	/* devices on a bridge's secondary bus */
+	size_t downstream_count;
+} fwts_pci_snapshot_device;
+
+/*
+ *  All the PCI functions, sorted on segment, bus, device and function
+ */
+typedef struct {
+	fwts_pci_snapshot_device *devices;
+	size_t count;
+} fwts_pci_snapshot;
+
 const char *fwts_pci_description(const uint8_t class_code, const uint8_t subclass_code);
 
+fwts_pci_snapshot *fwts_pci_snapshot_load(fwts_framework *fw, const char *path);
+fwts_pci_snapshot *fwts_pci_snapshot_get(fwts_framework *fw);
+void fwts_pci_snapshot_free(fwts_pci_snapshot *snapshot);
+void fwts_pci_snapshot_release(void);
+fwts_pci_snapshot_device *fwts_pci_snapshot_find(fwts_pci_snapshot *snapshot,
+	const uint32_t segment, const uint8_t bus, const uint8_t dev, const uint8_t func);
+fwts_pci_snapshot_device *fwts_pci_snapshot_find_name(fwts_pci_snapshot *snapshot, const char *name);
+size_t fwts_pci_snapshot_bus(fwts_pci_snapshot *snapshot, const uint32_t segment,
+	const uint8_t bus, fwts_pci_snapshot_device **devices);
+uint16_t fwts_pci_capability_find(const fwts_pci_snapshot_device *device, const uint8_t id);
+uint16_t fwts_pci_ext_capability_find(const fwts_pci_snapshot_device *device, const uint16_t id);
+fwts_pcie_capability *fwts_pci_pcie_capability(const fwts_pci_snapshot_device *device);
+
 #endif
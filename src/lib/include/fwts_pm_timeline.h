@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2021 Canonical
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+#ifndef __FWTS_PM_TIMELINE_H__
+#define __FWTS_PM_TIMELINE_H__
+
+#include <stdbool.h>
+
+#include "fwts_framework.h"
+#include "fwts_list.h"
+
+typedef enum {
+	FWTS_PM_TIMELINE_SUSPEND,
+	FWTS_PM_TIMELINE_HIBERNATE
+} fwts_pm_timeline_type;
+
+/*
+ *  Kernel log time stamps of each phase of a suspend or
+ *  hibernate cycle, -1.0 if the phase was not found
+ */
+typedef struct {
+	fwts_pm_timeline_type type;
+	double suspend_start;
+	double suspend_finish;
+	double resume_start;
+	double resume_finish;
+	double s2idle_enter;	/* PM: suspend-to-idle */
+	double s2idle_exit;	/* PM: resume from suspend-to-idle */
+} fwts_pm_timeline;
+
+/*
+ *  Suspend and resume times gathered over a number of cycles
+ */
+typedef struct {
+	fwts_pm_timeline_type type;
+	int cycles;		/* number of timelines added */
+	int suspends;		/* number of cycles with a known suspend time */
+	int resumes;		/* number of cycles with a known resume time */
+	double suspend_min;
+	double suspend_max;
+	double suspend_total;
+	double resume_min;
+	double resume_max;
+	double resume_total;
+} fwts_pm_timeline_stats;
+
+void   fwts_pm_timeline_init(fwts_pm_timeline *timeline, const fwts_pm_timeline_type type);
+void   fwts_pm_timeline_scan(fwts_list *klog, fwts_pm_timeline *timeline);
+bool   fwts_pm_timeline_suspend_time(const fwts_pm_timeline *timeline, double *seconds);
+bool   fwts_pm_timeline_resume_time(const fwts_pm_timeline *timeline, double *seconds);
+void   fwts_pm_timeline_log(fwts_framework *fw, const fwts_pm_timeline *timeline);
+
+void   fwts_pm_timeline_stats_init(fwts_pm_timeline_stats *stats, const fwts_pm_timeline_type type);
+void   fwts_pm_timeline_stats_add(fwts_pm_timeline_stats *stats, const fwts_pm_timeline *timeline);
+void   fwts_pm_timeline_stats_log(fwts_framework *fw, const fwts_pm_timeline_stats *stats);
+
+#endif
@@ -21,6 +21,7 @@
 #define __FWTS_SUMMARY_H__
 
 #include <stdlib.h>
+#include <stdio.h>
 
 #include "fwts_list.h"
 #include "fwts_framework.h"
@@ -28,6 +29,8 @@
 int fwts_summary_init(void);
 void fwts_summary_deinit(void);
 int fwts_summary_add(fwts_framework *fw, const char *test, const fwts_log_level level, const char *text);
+int fwts_summary_save(FILE *fp);
+int fwts_summary_load(fwts_framework *fw, FILE *fp);
 int fwts_summary_report(fwts_framework *fw, fwts_list *test_list);
 
 #endif
@@ -274,41 +274,242 @@ static const acpi_eval_error errors[] = {
 static fwts_list *fwts_object_names;
 static bool fwts_acpi_initialized = false;
 
+/*
+ *  Namespace objects in namespace order, indexed on their final
+ *  NameSeg so suffix lookups of "_XXX" names only visit matches
+ */
+static fwts_acpi_object_info *fwts_objects;
+static size_t fwts_objects_count;
+static size_t fwts_objects_size;
+static fwts_hash *fwts_objects_index;
+
+#define NAMESEG_LEN		(4)
+
+/*
+ *  The ACPICA session is shared by all users of fwts_acpi_init()
+ *  and kept running between tests unless the namespace state may
+ *  have changed, so it is only brought up once per fwts run.
+ */
+static int fwts_acpi_users;			/* current session users */
+static bool fwts_acpi_changed;			/* namespace state may have changed */
+static unsigned long fwts_acpi_inits;		/* sessions started */
+static unsigned long fwts_acpi_inits_saved;	/* inits served by a running session */
+
+/*
+ *  fwts_acpi_session_end()
+ *	Close ACPIA engine and free method namespace
+ */
+static int fwts_acpi_session_end(void)
+{
+	int ret;
+
+	fwts_hash_free(fwts_objects_index, NULL);
+	fwts_objects_index = NULL;
+	free(fwts_objects);
+	fwts_objects = NULL;
+	fwts_objects_count = 0;
+	fwts_objects_size = 0;
+	fwts_list_free(fwts_object_names, free);
+	fwts_object_names = NULL;
+	ret = fwts_acpica_deinit();
+
+	fwts_acpi_initialized = false;
+	fwts_acpi_changed = false;
+
+	return ret;
+}
+
+/*
+ *  fwts_acpi_walk_for_objects()
+ *	append object name to the names list and the object
+ *	to the objects array (callback from AcpiWalkNamespace())
+ */
+static ACPI_STATUS fwts_acpi_walk_for_objects(
+	ACPI_HANDLE	handle,
+	UINT32		nesting_level,
+	void		*context,
+	void		**ret)
+{
+	fwts_acpi_object_info *info;
+	ACPI_BUFFER buffer;
+	char tmpbuf[1024];
+	char *name;
+
+	FWTS_UNUSED(nesting_level);
+	FWTS_UNUSED(context);
+	FWTS_UNUSED(ret);
+
+	buffer.Pointer = tmpbuf;
+	buffer.Length  = sizeof(tmpbuf);
+
+	if (ACPI_FAILURE(AcpiGetName(handle, ACPI_FULL_PATHNAME, &buffer)))
+		return AE_OK;
+	if ((name = strdup(tmpbuf)) == NULL)
+		return AE_NO_MEMORY;
+	if (fwts_list_append(fwts_object_names, name) == NULL) {
+		free(name);
+		return AE_NO_MEMORY;
+	}
+
+	if (fwts_objects_count >= fwts_objects_size) {
+		const size_t size = fwts_objects_size ? fwts_objects_size * 2 : 1024;
+
+		info = realloc(fwts_objects, size * sizeof(*info));
+		if (!info)
+			return AE_NO_MEMORY;
+		fwts_objects = info;
+		fwts_objects_size = size;
+	}
+	info = &fwts_objects[fwts_objects_count++];
+	info->name = name;
+	info->handle = handle;
+	info->next = NULL;
+	if (ACPI_FAILURE(AcpiGetType(handle, &info->type)))
+		info->type = ACPI_TYPE_ANY;
+
+	return AE_OK;
+}
+
+/*
+ *  fwts_acpi_objects_get()
+ *	walk the namespace collecting object names, handles and
+ *	types and index the objects on their final NameSeg
+ */
+static void fwts_acpi_objects_get(void)
+{
+	fwts_acpi_object_info **tails;
+	size_t i;
+
+	if ((fwts_object_names = fwts_list_new()) == NULL)
+		return;
+
+	(void)AcpiWalkNamespace(ACPI_TYPE_ANY, ACPI_ROOT_OBJECT, ACPI_UINT32_MAX,
+		fwts_acpi_walk_for_objects, NULL, NULL, NULL);
+
+	/* Last object on the chain of each first object with a NameSeg */
+	if ((tails = calloc(fwts_objects_count + 1, sizeof(*tails))) == NULL)
+		return;
+	if ((fwts_objects_index = fwts_hash_new(fwts_objects_count / 4)) == NULL) {
+		free(tails);
+		return;
+	}
+
+	/*
+	 *  Only the first object with a NameSeg is hashed, the others
+	 *  are appended to its chain so chains are in namespace order
+	 */
+	for (i = 0; i < fwts_objects_count; i++) {
+		fwts_acpi_object_info *info = &fwts_objects[i];
+		const size_t len = strlen(info->name);
+		const char *nameseg = info->name + len - NAMESEG_LEN;
+		fwts_acpi_object_info *first;
+
+		if (len < NAMESEG_LEN)
+			continue;
+		if ((first = fwts_hash_get(fwts_objects_index, nameseg)) != NULL) {
+			const size_t j = first - fwts_objects;
+
+			tails[j]->next = info;
+			tails[j] = info;
+			continue;
+		}
+		if (fwts_hash_add(fwts_objects_index, nameseg, info) != FWTS_OK) {
+			fwts_hash_free(fwts_objects_index, NULL);
+			fwts_objects_index = NULL;
+			break;
+		}
+		tails[i] = info;
+	}
+	free(tails);
+}
+
 /*
  *  fwts_acpi_init()
- *	Initialise ACPIA engine and collect method namespace
+ *	Initialise ACPIA engine and collect method namespace,
+ *	if the engine is already running just use it
  */
 int fwts_acpi_init(fwts_framework *fw)
 {
+	if (fwts_acpi_initialized) {
+		fwts_acpi_users++;
+		fwts_acpi_inits_saved++;
+		return FWTS_OK;
+	}
+
 	if (fwts_acpica_init(fw) != FWTS_OK)
 		return FWTS_ERROR;
 
 	/* Gather all object names */
-	fwts_object_names = fwts_acpica_get_object_names(0);
+	fwts_acpi_objects_get();
 	fwts_acpi_initialized = true;
+	fwts_acpi_users = 1;
+	fwts_acpi_inits++;
 
 	return FWTS_OK;
 }
 
 /*
  *  fwts_acpi_deinit()
- *	Close ACPIA engine and free method namespace
+ *	Release the ACPICA engine, it is kept running for the next
+ *	user unless the namespace state may have been changed
  */
 int fwts_acpi_deinit(fwts_framework *fw)
 {
-	int ret = FWTS_ERROR;
-
 	FWTS_UNUSED(fw);
 
-	if (fwts_acpi_initialized) {
-		fwts_list_free(fwts_object_names, free);
-		fwts_object_names = NULL;
-		ret = fwts_acpica_deinit();
+	if (!fwts_acpi_initialized)
+		return FWTS_ERROR;
 
-		fwts_acpi_initialized = false;
-	}
+	if (--fwts_acpi_users > 0)
+		return FWTS_OK;
 
-	return ret;
+	fwts_acpi_users = 0;
+	if (fwts_acpi_changed)
+		return fwts_acpi_session_end();
+
+	return FWTS_OK;
+}
+
+/*
+ *  fwts_acpi_reset()
+ *	flag that the namespace state may have changed, for example
+ *	by evaluating objects, so the ACPICA engine is closed down
+ *	rather than reused once the last user has released it
+ */
+void fwts_acpi_reset(void)
+{
+	if (!fwts_acpi_initialized)
+		return;
+
+	fwts_acpi_changed = true;
+	if (fwts_acpi_users == 0)
+		(void)fwts_acpi_session_end();
+}
+
+/*
+ *  fwts_acpi_release()
+ *	close down the ACPICA engine if it is running with no
+ *	users, returns FWTS_ERROR if it is still in use
+ */
+int fwts_acpi_release(void)
+{
+	if (!fwts_acpi_initialized)
+		return FWTS_OK;
+	if (fwts_acpi_users > 0)
+		return FWTS_ERROR;
+
+	return fwts_acpi_session_end();
+}
+
+/*
+ *  fwts_acpi_session_stats()
+ *	report number of ACPICA engine start ups and the number
+ *	of fwts_acpi_init() calls that reused a running engine
+ */
+void fwts_acpi_session_stats(unsigned long *inits, unsigned long *inits_saved)
+{
+	*inits = fwts_acpi_inits;
+	*inits_saved = fwts_acpi_inits_saved;
 }
 
 /*
@@ -321,24 +522,82 @@ fwts_list *fwts_acpi_object_get_names(void)
 }
 
 /*
- *  fwts_acpi_object_exists()
- *	return first matching name
+ *  fwts_acpi_object_match()
+ *	return true if object name ends with name
  */
-char *fwts_acpi_object_exists(const char *name)
+static inline bool fwts_acpi_object_match(
+	const fwts_acpi_object_info *info,
+	const char *name,
+	const size_t name_len)
+{
+	const size_t len = strlen(info->name);
+
+	return (len >= name_len) &&
+	       (strncmp(name, info->name + len - name_len, name_len) == 0);
+}
+
+/*
+ *  fwts_acpi_object_find_next()
+ *	return the next object after info whose name ends with
+ *	name, NULL if there are no more
+ */
+fwts_acpi_object_info *fwts_acpi_object_find_next(
+	fwts_acpi_object_info *info,
+	const char *name)
 {
-	size_t name_len = strlen(name);
-	fwts_list_link	*item;
+	const size_t name_len = strlen(name);
 
-	fwts_list_foreach(item, fwts_object_names) {
-		char *method_name = fwts_list_data(char*, item);
-		size_t len = strlen(method_name);
+	if (!info)
+		return NULL;
 
-		if (strncmp(name, method_name + len - name_len, name_len) == 0)
-			return method_name;
+	if (fwts_objects_index && (name_len >= NAMESEG_LEN)) {
+		/* Only objects with a matching final NameSeg can match */
+		for (info = info->next; info; info = info->next)
+			if (fwts_acpi_object_match(info, name, name_len))
+				return info;
+		return NULL;
 	}
+
+	for (info++; info < fwts_objects + fwts_objects_count; info++)
+		if (fwts_acpi_object_match(info, name, name_len))
+			return info;
 	return NULL;
 }
 
+/*
+ *  fwts_acpi_object_find_first()
+ *	return the first object whose name ends with name,
+ *	NULL if not found
+ */
+fwts_acpi_object_info *fwts_acpi_object_find_first(const char *name)
+{
+	const size_t name_len = strlen(name);
+	fwts_acpi_object_info *info;
+
+	if (!fwts_objects_count)
+		return NULL;
+
+	if (fwts_objects_index && (name_len >= NAMESEG_LEN))
+		info = fwts_hash_get(fwts_objects_index, name + name_len - NAMESEG_LEN);
+	else
+		info = fwts_objects;
+
+	if (!info || fwts_acpi_object_match(info, name, name_len))
+		return info;
+
+	return fwts_acpi_object_find_next(info, name);
+}
+
+/*
+ *  fwts_acpi_object_exists()
+ *	return first matching name
+ */
+char *fwts_acpi_object_exists(const char *name)
+{
+	fwts_acpi_object_info *info = fwts_acpi_object_find_first(name);
+
+	return info ? info->name : NULL;
+}
 
 /*
  *   fwts_acpi_object_dump_recursive()
@@ -464,6 +723,9 @@ ACPI_STATUS fwts_acpi_object_evaluate(fwts_framework *fw,
 {
 	FWTS_UNUSED(fw);
 
+	/* Evaluation can change namespace state, don't reuse the engine */
+	fwts_acpi_reset();
+
 	buf->Length  = ACPI_ALLOCATE_BUFFER;
 	buf->Pointer = NULL;
 
@@ -1149,6 +1411,9 @@ void fwts_evaluate_found_method(
 
 	fwts_acpica_sem_count_clear();
 
+	/* The method may change namespace state */
+	fwts_acpi_reset();
+
 	buf.Length  = ACPI_ALLOCATE_BUFFER;
 	buf.Pointer = NULL;
 	status = AcpiEvaluateObject(*parent, name, arg_list, &buf);
@@ -42,7 +42,30 @@
 #define BIOS_LENGTH	(BIOS_END - BIOS_START)	/* Length of BIOS memory */
 #define PAGE_SIZE	(4096)
 
-static fwts_acpi_table_info	tables[ACPI_MAX_TABLES];
+/*
+ *  Cached table, the info is handed out to callers so entries are
+ *  allocated individually and never move once added
+ */
+typedef struct {
+	fwts_acpi_table_info info;	/* Table info, must be first */
+	char addr_key[17];		/* Hex address, key of addr_index */
+} fwts_acpi_table_entry;
+
+/*
+ *  All the instances of tables with the same signature
+ */
+typedef struct {
+	char name[5];			/* Signature, key of sig_index */
+	uint32_t count;			/* Number of instances */
+	uint32_t size;			/* Allocated size of instances */
+	fwts_acpi_table_info **instances;
+} fwts_acpi_table_sig;
+
+static fwts_acpi_table_info	**tables;	/* Tables in the order they were added */
+static uint32_t			tables_count;
+static uint32_t			tables_size;
+static fwts_hash		*sig_index;	/* Signature -> fwts_acpi_table_sig */
+static fwts_hash		*addr_index;	/* Address -> first table at that address */
 
 typedef enum {
 	ACPI_TABLES_NOT_LOADED		= 0,
@@ -236,6 +259,38 @@ static void *fwts_acpi_load_table(const off_t addr)
 	return table;
 }
 
+/*
+ *  fwts_acpi_index_addr()
+ *	index a table by its address, only the first table at an
+ *	address is indexed so lookups find the oldest one
+ */
+static int fwts_acpi_index_addr(fwts_acpi_table_info *info)
+{
+	fwts_acpi_table_entry *entry = (fwts_acpi_table_entry *)info;
+
+	(void)snprintf(entry->addr_key, sizeof(entry->addr_key), "%" PRIx64, info->addr);
+	if (fwts_hash_get(addr_index, entry->addr_key))
+		return FWTS_OK;
+
+	return fwts_hash_add(addr_index, entry->addr_key, info);
+}
+
+/*
+ *  fwts_acpi_reindex_addrs()
+ *	rebuild the address index after table addresses have been fixed up
+ */
+static void fwts_acpi_reindex_addrs(void)
+{
+	uint32_t i;
+
+	fwts_hash_free(addr_index, NULL);
+	if ((addr_index = fwts_hash_new(tables_count)) == NULL)
+		return;
+
+	for (i = 0; i < tables_count; i++)
+		(void)fwts_acpi_index_addr(tables[i]);
+}
+
 /*
  *  fwts_acpi_add_table()
  *	Add a table to internal ACPI table cache. Ignore duplicates based on
@@ -249,32 +304,94 @@ static void fwts_acpi_add_table(
 	const fwts_acpi_table_provenance provenance)
 						/* Where we got the table from */
 {
-	int i;
-	uint32_t which = 0;
+	fwts_acpi_table_entry *entry;
+	fwts_acpi_table_info *info;
+	fwts_acpi_table_sig *sig;
+	char key[17];
+	char sig_name[5];
 
-	for (i = 0; i < ACPI_MAX_TABLES; i++) {
-		if (addr && tables[i].addr == addr) {
-			/* We don't need it, it's a duplicate, so free and return */
-			fwts_low_free(table);
-			return;
-		}
-		if (strncmp(tables[i].name, name, 4) == 0)
-			which++;
-		if (tables[i].data == NULL) {
-			memcpy(tables[i].name, name, 4);
-			tables[i].name[4] = 0;
-			tables[i].data = table;
-			tables[i].addr = addr;
-			tables[i].length = length;
-			tables[i].which = which;
-			tables[i].index = i;
-			tables[i].provenance = provenance;
-			tables[i].has_aml =
-				((!strcmp(tables[i].name, "DSDT")) ||
-				 (!strcmp(tables[i].name, "SSDT")));
-			return;
+	if (!sig_index && ((sig_index = fwts_hash_new(0)) == NULL))
+		goto err;
+	if (!addr_index && ((addr_index = fwts_hash_new(0)) == NULL))
+		goto err;
+
+	(void)snprintf(key, sizeof(key), "%" PRIx64, addr);
+	if (addr && fwts_hash_get(addr_index, key)) {
+		/* We don't need it, it's a duplicate, so free and return */
+		fwts_low_free(table);
+		return;
+	}
+
+	memcpy(sig_name, name, 4);
+	sig_name[4] = 0;
+	if ((sig = fwts_hash_get(sig_index, sig_name)) == NULL) {
+		if ((sig = calloc(1, sizeof(*sig))) == NULL)
+			goto err;
+		memcpy(sig->name, sig_name, sizeof(sig->name));
+		if (fwts_hash_add(sig_index, sig->name, sig) != FWTS_OK) {
+			free(sig);
+			goto err;
 		}
 	}
+
+	if (sig->count >= sig->size) {
+		uint32_t size = sig->size ? sig->size * 2 : 4;
+		fwts_acpi_table_info **instances;
+
+		if ((instances = realloc(sig->instances, size * sizeof(*instances))) == NULL)
+			goto err;
+		sig->instances = instances;
+		sig->size = size;
+	}
+
+	if (tables_count >= tables_size) {
+		uint32_t size = tables_size ? tables_size * 2 : 64;
+		fwts_acpi_table_info **new_tables;
+
+		if ((new_tables = realloc(tables, size * sizeof(*new_tables))) == NULL)
+			goto err;
+		tables = new_tables;
+		tables_size = size;
+	}
+
+	if ((entry = calloc(1, sizeof(*entry))) == NULL)
+		goto err;
+
+	info = &entry->info;
+	memcpy(info->name, sig_name, sizeof(info->name));
+	info->data = table;
+	info->addr = addr;
+	info->length = length;
+	info->which = sig->count;
+	info->index = tables_count;
+	info->provenance = provenance;
+	info->has_aml =
+		((!strcmp(info->name, "DSDT")) ||
+		 (!strcmp(info->name, "SSDT")));
+
+	if (fwts_acpi_index_addr(info) != FWTS_OK) {
+		free(entry);
+		goto err;
+	}
+
+	sig->instances[sig->count++] = info;
+	tables[tables_count++] = info;
+	return;
+err:
+	/* Out of memory, drop the table */
+	fwts_low_free(table);
+}
+
+/*
+ *  fwts_acpi_free_table_sig()
+ *	free a signature index entry
+ */
+static void fwts_acpi_free_table_sig(void *data)
+{
+	fwts_acpi_table_sig *sig = (fwts_acpi_table_sig *)data;
+
+	free(sig->instances);
+	free(sig);
 }
 
 /*
@@ -283,14 +400,22 @@ static void fwts_acpi_add_table(
  */
 int fwts_acpi_free_tables(void)
 {
-	int i;
+	uint32_t i;
 
-	for (i = 0; i < ACPI_MAX_TABLES; i++) {
-		if (tables[i].data) {
-			fwts_low_free(tables[i].data);
-			memset(&tables[i], 0, sizeof(fwts_acpi_table_info));
-		}
+	for (i = 0; i < tables_count; i++) {
+		fwts_low_free(tables[i]->data);
+		free((fwts_acpi_table_entry *)tables[i]);
 	}
+	free(tables);
+	tables = NULL;
+	tables_count = 0;
+	tables_size = 0;
+
+	fwts_hash_free(sig_index, fwts_acpi_free_table_sig);
+	sig_index = NULL;
+	fwts_hash_free(addr_index, NULL);
+	addr_index = NULL;
+
 	return FWTS_OK;
 }
 
@@ -557,60 +682,80 @@ static uint32_t fwts_fake_physical_addr(const size_t size)
 }
 
 /*
- *  fwts_acpi_load_table_from_acpidump()
- *	Load an ACPI table from the output of acpidump or fwts --dump
+ *  acpidump text being parsed, lines are fetched in the same way
+ *  as fgets() into a 128 byte buffer so over-long lines are split
  */
-static uint8_t *fwts_acpi_load_table_from_acpidump(
-	fwts_framework *fw,
-	FILE *fp,
-	char *name,
-	uint64_t *addr,
-	size_t *size)
-{
-	uint32_t offset, expected_offset = 0;
-	uint8_t  data[16];
-	char buffer[128];
-	uint8_t *table;
-	uint8_t *tmp = NULL;
-	char *ptr;
-	size_t len = 0;
-	unsigned long long table_addr;
-	ptrdiff_t name_len;
+typedef struct {
+	const char *buf;	/* acpidump text */
+	size_t len;		/* length of text */
+	size_t pos;		/* current parse position */
+	char line[128];		/* current line, nul terminated */
+	size_t line_len;	/* length of line up to the first nul */
+} fwts_acpidump_text;
 
-	*size = 0;
-
-	if (fgets(buffer, sizeof(buffer), fp) == NULL)
-		return NULL;
-
-	/*
-	 * Parse tablename followed by address, e.g.
-	 *   DSTD @ 0xbfa02344
-	 *   SSDT4 @ 0xbfa0f230
-	 */
-	ptr = strstr(buffer, "@ 0x");
-	if (ptr == NULL)
-		return NULL; /* Can't find table name */
+/*
+ *  Hex digit values, -1 for non hex digits
+ */
+static const int8_t fwts_acpidump_hex[256] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
 
-	name_len = ptr - buffer;
-	/*
-	 * We should have no more than the table name (4..5 chars)
-	 * plus a space left between the start of the buffer and
-	 * the @ sign.  If we have more then something is wrong with
-	 * the data. So just ignore this garbage as we don't want to
-	 * overflow the name on the following strcpy()
-	 */
-	if ((name_len > 6) || (name_len < 5))
-		return NULL; /* Name way too long or too short */
+/*
+ *  fwts_acpidump_getline()
+ *	fetch the next line of acpidump text, false at the end
+ */
+static bool fwts_acpidump_getline(fwts_acpidump_text *text)
+{
+	const char *start = text->buf + text->pos;
+	const char *ptr;
+	size_t n = text->len - text->pos;
 
-	if (sscanf(ptr, "@ 0x%Lx\n", &table_addr) < 1)
-		return NULL; /* Can't parse address */
+	if (n == 0)
+		return false;
+	if (n > sizeof(text->line) - 1)
+		n = sizeof(text->line) - 1;
+	if ((ptr = memchr(start, '\n', n)) != NULL)
+		n = (ptr - start) + 1;
+
+	memcpy(text->line, start, n);
+	text->line[n] = '\0';
+	text->pos += n;
+	/* Binary junk, only use the text up to any nul */
+	ptr = memchr(text->line, '\0', n + 1);
+	text->line_len = ptr - text->line;
 
-	*(ptr-1) = '\0';
-	strcpy(name, buffer);
+	return true;
+}
 
-	/* In fwts RSD PTR is known as the RSDP */
-	if (strncmp(name, "RSD PTR", 7) == 0)
-		strcpy(name, "RSDP");
+/*
+ *  fwts_acpi_load_rows_from_acpidump()
+ *	Parse the hex rows of a table from acpidump text.  If table is
+ *	NULL then just find the table length and report any bad data,
+ *	otherwise decode the rows into table.  Returns the table length.
+ */
+static size_t fwts_acpi_load_rows_from_acpidump(
+	fwts_framework *fw,
+	fwts_acpidump_text *text,
+	const char *name,
+	uint8_t *table)
+{
+	uint32_t offset, expected_offset = 0;
+	size_t len = 0;
 
 	/*
 	 *  Pull in 16 bytes at a time, data MUST be conforming to the
@@ -621,92 +766,147 @@ static uint8_t *fwts_acpi_load_table_from_acpidump(
 	 *  anything not conforming to this rigid format will be prematurely
 	 *  aborted
 	 */
-	while (fgets(buffer, sizeof(buffer), fp) ) {
-		uint8_t *new_tmp;
+	while (fwts_acpidump_getline(text)) {
+		const char *line_end = text->line + text->line_len;
+		char *ptr;
 		int n;
 
 		/* Get offset */
-		if (sscanf(buffer,"  %" SCNx32 ": ", &offset) < 1)
+		offset = (uint32_t)strtoul(text->line, &ptr, 16);
+		if (ptr == text->line)
 			break;
 
 		/* Offset are not correct, abort with truncated table */
 		if (offset != expected_offset) {
-			fwts_log_error(fw, "ACPI dump offsets in table '%s'"
-				" are not incrementing by 16 bytes per row. "
-				" Table truncated prematurely due to bad acpidump data.",
-				name);
+			if (!table)
+				fwts_log_error(fw, "ACPI dump offsets in table '%s'"
+					" are not incrementing by 16 bytes per row. "
+					" Table truncated prematurely due to bad acpidump data.",
+					name);
 			break;
 		}
 
 		expected_offset += 16;
 
 		/* Data follows the colon, abort if not found */
-		ptr = strstr(buffer, ": ");
+		ptr = strstr(text->line, ": ");
 		if (!ptr) {
-			fwts_log_error(fw, "ACPI dump in table '%s' did not contain "
-				"any data, expecting at least 1 hex byte of data per row.",
-				name);
+			if (!table)
+				fwts_log_error(fw, "ACPI dump in table '%s' did not contain "
+					"any data, expecting at least 1 hex byte of data per row.",
+					name);
 			break;
 		}
 
 		ptr += 2;
 		/* Now expect 16 lots of 2 hex digits and a space */
-		for (n = 0; n < 16; n++) {
+		for (n = 0; n < 16; n++, ptr += 3) {
+			int hi, lo;
+
 			/*
 			 *  Need to be 100% sure 2 hex digits. Maybe a short row
-		 	 *  because it is the end of the table, so assume it is the
+			 *  because it is the end of the table, so assume it is the
 			 *  end of the table if not hex digits.
 			 */
-			if (!isxdigit(*ptr) || !isxdigit(*(ptr + 1))) {
+			if (ptr >= line_end)
 				break;
-			}
-			if (sscanf(ptr, "%2" SCNx8, &data[n]) != 1) {
-				/* Bug in parsing! should never happen! */
-				fwts_log_error(fw, "ACPI dump in table '%s' at hex byte position "
-					"%d did parse correctly, got "
-					"'%2.2s' which could not be parsed as a hex value.",
-					name, n, ptr);
+			hi = fwts_acpidump_hex[(uint8_t)ptr[0]];
+			lo = fwts_acpidump_hex[(uint8_t)ptr[1]];
+			if ((hi | lo) < 0)
 				break;
-			}
-			ptr += 3;
+			if (table)
+				table[len + n] = (uint8_t)((hi << 4) | lo);
 		}
 
 		/* Got no data? */
 		if (n == 0) {
-			fwts_log_error(fw, "ACPI dump in table '%s' did not contain "
-				"any data, expecting at least 1 hex byte of data per row.",
-				name);
+			if (!table)
+				fwts_log_error(fw, "ACPI dump in table '%s' did not contain "
+					"any data, expecting at least 1 hex byte of data per row.",
+					name);
 			break;
 		}
 
 		len += n;
-		if ((new_tmp = realloc(tmp, len)) == NULL) {
-			free(tmp);
-			fwts_log_error(fw, "ACPI table parser run out of memory parsing table '%s'.", name);
-			return NULL;
-		} else
-			tmp = new_tmp;
-
-		memcpy(tmp + offset, data, n);
 
 		/* Treat less than a full row as last one */
 		if (n != 16)
 			break;
 	}
+
+	return len;
+}
+
+/*
+ *  fwts_acpi_load_table_from_acpidump()
+ *	Load an ACPI table from the output of acpidump or fwts --dump,
+ *	the rows are parsed once to size the table and then decoded
+ *	straight into the table
+ */
+static uint8_t *fwts_acpi_load_table_from_acpidump(
+	fwts_framework *fw,
+	fwts_acpidump_text *text,
+	char *name,
+	uint64_t *addr,
+	size_t *size)
+{
+	uint8_t *table;
+	char *ptr;
+	size_t len, pos;
+	unsigned long long table_addr;
+	ptrdiff_t name_len;
+
+	*size = 0;
+
+	if (!fwts_acpidump_getline(text))
+		return NULL;
+
+	/*
+	 * Parse tablename followed by address, e.g.
+	 *   DSTD @ 0xbfa02344
+	 *   SSDT4 @ 0xbfa0f230
+	 */
+	ptr = strstr(text->line, "@ 0x");
+	if (ptr == NULL)
+		return NULL; /* Can't find table name */
+
+	name_len = ptr - text->line;
+	/*
+	 * We should have no more than the table name (4..5 chars)
+	 * plus a space left between the start of the buffer and
+	 * the @ sign.  If we have more then something is wrong with
+	 * the data. So just ignore this garbage as we don't want to
+	 * overflow the name on the following strcpy()
+	 */
+	if ((name_len > 6) || (name_len < 5))
+		return NULL; /* Name way too long or too short */
+
+	if (sscanf(ptr, "@ 0x%Lx\n", &table_addr) < 1)
+		return NULL; /* Can't parse address */
+
+	*(ptr-1) = '\0';
+	strcpy(name, text->line);
+
+	/* In fwts RSD PTR is known as the RSDP */
+	if (strncmp(name, "RSD PTR", 7) == 0)
+		strcpy(name, "RSDP");
+
+	pos = text->pos;
+	len = fwts_acpi_load_rows_from_acpidump(fw, text, name, NULL);
+
 	/* Unlikely, but an empty table should be checked for */
-	if (!tmp) {
+	if (!len) {
 		fwts_log_error(fw, "ACPI table parser found an empty table '%s'.", name);
 		return NULL;
 	}
 
 	/* Allocate the table using low 32 bit memory */
 	if ((table = fwts_low_malloc(len)) == NULL) {
-		free(tmp);
 		fwts_log_error(fw, "ACPI table parser run out of 32 bit memory parsing table '%s'.", name);
 		return NULL;
 	}
-	memcpy(table, tmp, len);
-	free(tmp);
+	text->pos = pos;
+	(void)fwts_acpi_load_rows_from_acpidump(fw, text, name, table);
 
 	if (table_addr == 0)
 		table_addr = fwts_fake_physical_addr(len);
@@ -724,28 +924,68 @@ static uint8_t *fwts_acpi_load_table_from_acpidump(
  */
 static int fwts_acpi_load_tables_from_acpidump(fwts_framework *fw)
 {
-	FILE *fp;
+	fwts_acpidump_text text;
+	struct stat buf;
+	void *mem = MAP_FAILED;
+	char *data = NULL;
+	int fd;
 
 	if (!fw->acpi_table_acpidump_file)
 		return FWTS_ERROR;
 
-	if ((fp = fopen(fw->acpi_table_acpidump_file, "r")) == NULL) {
+	if ((fd = open(fw->acpi_table_acpidump_file, O_RDONLY)) < 0) {
 		fwts_log_error(fw, "Cannot open '%s' to read ACPI tables.",
 			fw->acpi_table_acpidump_file);
 		return FWTS_ERROR;
 	}
 
-	while (!feof(fp)) {
+	(void)memset(&text, 0, sizeof(text));
+	if ((fstat(fd, &buf) == 0) && (buf.st_size > 0))
+		mem = mmap(NULL, (size_t)buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mem != MAP_FAILED) {
+		text.buf = mem;
+		text.len = (size_t)buf.st_size;
+	} else {
+		/* Can't mmap, e.g. not a regular file, so read it in blocks */
+		size_t size = 0;
+		ssize_t n;
+
+		for (;;) {
+			if (text.len == size) {
+				char *tmp;
+
+				size = size ? size * 2 : 65536;
+				if ((tmp = realloc(data, size)) == NULL) {
+					fwts_log_error(fw, "ACPI table parser run out of memory reading '%s'.",
+						fw->acpi_table_acpidump_file);
+					free(data);
+					(void)close(fd);
+					return FWTS_ERROR;
+				}
+				data = tmp;
+			}
+			n = read(fd, data + text.len, size - text.len);
+			if (n <= 0)
+				break;
+			text.len += (size_t)n;
+		}
+		text.buf = data;
+	}
+	(void)close(fd);
+
+	while (text.pos < text.len) {
 		uint64_t addr;
 		uint8_t *table;
 		size_t length;
 		char name[16];
 
-		if ((table = fwts_acpi_load_table_from_acpidump(fw, fp, name, &addr, &length)) != NULL)
+		if ((table = fwts_acpi_load_table_from_acpidump(fw, &text, name, &addr, &length)) != NULL)
 			fwts_acpi_add_table(name, table, addr, length, FWTS_ACPI_TABLE_FROM_FILE);
 	}
 
-	(void)fclose(fp);
+	if (mem != MAP_FAILED)
+		(void)munmap(mem, text.len);
+	free(data);
 
 	return FWTS_OK;
 }
@@ -986,6 +1226,10 @@ void fwts_acpi_fixup_addr_from_fadt(
 		table->addr = addr64;
 	else if (addr32)
 		table->addr = addr32;
+	else
+		return;
+
+	fwts_acpi_reindex_addrs();
 }
 
 /*
@@ -1280,7 +1524,7 @@ int fwts_acpi_find_table(
 	const uint32_t which,
 	fwts_acpi_table_info **info)
 {
-	int i;
+	fwts_acpi_table_sig *sig;
 
 	if (info == NULL)
 		return FWTS_NULL_POINTER;
@@ -1297,15 +1541,10 @@ int fwts_acpi_find_table(
 			return ret;
 	}
 
-	for (i = 0; i < ACPI_MAX_TABLES; i++) {
-		if (tables[i].data == NULL)
-			break;
-		if ((strcmp(tables[i].name, name) == 0) &&
-	            (tables[i].which == which)) {
-			*info = &tables[i];
-			return FWTS_OK;
-		}
-	}
+	sig = fwts_hash_get(sig_index, name);
+	if (sig && (which < sig->count))
+		*info = sig->instances[which];
+
 	return FWTS_OK;
 }
 
@@ -1315,7 +1554,7 @@ int fwts_acpi_find_table(
  */
 int fwts_acpi_find_table_by_addr(fwts_framework *fw, const uint64_t addr, fwts_acpi_table_info **info)
 {
-	int i;
+	char key[17];
 
 	if (info == NULL)
 		return FWTS_NULL_POINTER;
@@ -1328,14 +1567,9 @@ int fwts_acpi_find_table_by_addr(fwts_framework *fw, const uint64_t addr, fwts_a
 			return ret;
 	}
 
-	for (i = 0; i < ACPI_MAX_TABLES; i++) {
-		if (tables[i].data == NULL)
-			break;
-		if (tables[i].addr == addr) {
-			*info = &tables[i];
-			return FWTS_OK;
-		}
-	}
+	(void)snprintf(key, sizeof(key), "%" PRIx64, addr);
+	*info = fwts_hash_get(addr_index, key);
+
 	return FWTS_OK;
 }
 
@@ -1350,19 +1584,20 @@ int fwts_acpi_get_table(fwts_framework *fw, const uint32_t index, fwts_acpi_tabl
 
 	*info = NULL;
 
-	if (index >= ACPI_MAX_TABLES)
-		return FWTS_ERROR;
-
 	if (acpi_tables_loaded == ACPI_TABLES_NOT_LOADED) {
 		int ret;
 		if ((ret = fwts_acpi_load_tables(fw)) != FWTS_OK)
 			return ret;
 	}
 
-	if (tables[index].data == NULL)
+	/* One past the last table is an empty slot, beyond that is an error */
+	if (index > tables_count)
+		return FWTS_ERROR;
+
+	if (index == tables_count)
 		return FWTS_OK;
 
-	*info = &tables[index];
+	*info = tables[index];
 	return FWTS_OK;
 }
 
@@ -1376,7 +1611,7 @@ bool fwts_acpi_obj_find(fwts_framework *fw, const char *obj_name)
 	char *c = expanded;
 	const char *obj_ptr;
 	int i;
-	fwts_list_link *item;
+	fwts_acpi_object_info *info;
 	fwts_list *objects;
 	bool found = false;
 
@@ -1412,10 +1647,9 @@ bool fwts_acpi_obj_find(fwts_framework *fw, const char *obj_name)
 	}
 
 	/* Search for object */
-	fwts_list_foreach(item, objects) {
-		char *name = fwts_list_data(char*, item);
-
-		if (strcmp(expanded, name) == 0) {
+	for (info = fwts_acpi_object_find_first(expanded); info;
+	     info = fwts_acpi_object_find_next(info, expanded)) {
+		if (strcmp(expanded, info->name) == 0) {
 			found = true;
 			break;
 		}
@@ -17,6 +17,8 @@
  *
  */
 
+#include <string.h>
+
 #include "fwts.h"
 
 /*
@@ -33,3 +35,144 @@ uint8_t fwts_checksum(const uint8_t *data, const size_t length)
 
 	return checksum;
 }
+
+static const uint32_t fwts_sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define SHA256_ROR(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+
+/*
+ *  fwts_sha256_block()
+ *	hash one 64 byte block into the SHA-256 state
+ */
+static void fwts_sha256_block(fwts_sha256 *ctx, const uint8_t *block)
+{
+	uint32_t w[64], s[8];
+	int i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = ((uint32_t)block[i * 4] << 24) |
+		       ((uint32_t)block[i * 4 + 1] << 16) |
+		       ((uint32_t)block[i * 4 + 2] << 8) |
+		       ((uint32_t)block[i * 4 + 3]);
+	for (; i < 64; i++) {
+		const uint32_t s0 = SHA256_ROR(w[i - 15], 7) ^
+				    SHA256_ROR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		const uint32_t s1 = SHA256_ROR(w[i - 2], 17) ^
+				    SHA256_ROR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	memcpy(s, ctx->state, sizeof(s));
+	for (i = 0; i < 64; i++) {
+		const uint32_t S1 = SHA256_ROR(s[4], 6) ^ SHA256_ROR(s[4], 11) ^ SHA256_ROR(s[4], 25);
+		const uint32_t ch = (s[4] & s[5]) ^ (~s[4] & s[6]);
+		const uint32_t t1 = s[7] + S1 + ch + fwts_sha256_k[i] + w[i];
+		const uint32_t S0 = SHA256_ROR(s[0], 2) ^ SHA256_ROR(s[0], 13) ^ SHA256_ROR(s[0], 22);
+		const uint32_t maj = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+		const uint32_t t2 = S0 + maj;
+
+		s[7] = s[6];
+		s[6] = s[5];
+		s[5] = s[4];
+		s[4] = s[3] + t1;
+		s[3] = s[2];
+		s[2] = s[1];
+		s[1] = s[0];
+		s[0] = t1 + t2;
+	}
+	for (i = 0; i < 8; i++)
+		ctx->state[i] += s[i];
+}
+
+/*
+ *  fwts_sha256_init()
+ *	start a new SHA-256 digest
+ */
+void fwts_sha256_init(fwts_sha256 *ctx)
+{
+	static const uint32_t init[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+		0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+
+	memcpy(ctx->state, init, sizeof(ctx->state));
+	ctx->length = 0;
+}
+
+/*
+ *  fwts_sha256_update()
+ *	add length bytes of data to the digest
+ */
+void fwts_sha256_update(fwts_sha256 *ctx, const void *data, size_t length)
+{
+	const uint8_t *ptr = (const uint8_t *)data;
+	size_t used = ctx->length % sizeof(ctx->block);
+
+	ctx->length += length;
+
+	if (used) {
+		size_t n = sizeof(ctx->block) - used;
+
+		if (n > length)
+			n = length;
+		memcpy(ctx->block + used, ptr, n);
+		ptr += n;
+		length -= n;
+		if (used + n < sizeof(ctx->block))
+			return;
+		fwts_sha256_block(ctx, ctx->block);
+	}
+
+	for (; length >= sizeof(ctx->block); length -= sizeof(ctx->block)) {
+		fwts_sha256_block(ctx, ptr);
+		ptr += sizeof(ctx->block);
+	}
+	memcpy(ctx->block, ptr, length);
+}
+
+/*
+ *  fwts_sha256_final()
+ *	pad the data and return the digest
+ */
+void fwts_sha256_final(fwts_sha256 *ctx, uint8_t digest[FWTS_SHA256_DIGEST_SIZE])
+{
+	const uint64_t bits = ctx->length * 8;
+	size_t used = ctx->length % sizeof(ctx->block);
+	int i;
+
+	ctx->block[used++] = 0x80;
+	if (used > sizeof(ctx->block) - 8) {
+		memset(ctx->block + used, 0, sizeof(ctx->block) - used);
+		fwts_sha256_block(ctx, ctx->block);
+		used = 0;
+	}
+	memset(ctx->block + used, 0, sizeof(ctx->block) - 8 - used);
+	for (i = 0; i < 8; i++)
+		ctx->block[56 + i] = (uint8_t)(bits >> (56 - i * 8));
+	fwts_sha256_block(ctx, ctx->block);
+
+	for (i = 0; i < 8; i++) {
+		digest[i * 4] = (uint8_t)(ctx->state[i] >> 24);
+		digest[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+		digest[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+		digest[i * 4 + 3] = (uint8_t)ctx->state[i];
+	}
+}
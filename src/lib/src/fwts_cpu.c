@@ -27,6 +27,7 @@
 #include <string.h>
 #include <dirent.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/syscall.h>
@@ -36,6 +37,7 @@
 #include <fcntl.h>
 #include <math.h>
 #include <sched.h>
+#include <pthread.h>
 
 #include <linux/perf_event.h>
 
@@ -50,19 +52,29 @@ static pid_t *fwts_cpu_pids;
 #define MSR_AMD64_OSVW_STATUS		0xc0010141
 
 /*
- *  fwts_cpu_readmsr()
- *	Read a given msr on a specified CPU
+ *  MSR device fd cache, only used between fwts_cpu_msr_cache_open()
+ *  and fwts_cpu_msr_cache_close(), otherwise each read opens and
+ *  closes the msr device
  */
-int fwts_cpu_readmsr(
-	fwts_framework *fw,
-	const int cpu,
-	const uint32_t reg,
-	uint64_t *val)
+static int *msr_fds;
+static int msr_fds_size;
+
+/*
+ *  Batch MSR reads fan out over worker threads when reading from at
+ *  least MSR_THREAD_MIN_CPUS CPUs, each worker reads from at least
+ *  MSR_THREAD_MIN_CPUS / 2 CPUs
+ */
+#define MSR_THREAD_MIN_CPUS	(64)
+#define MSR_THREADS_MAX		(16)
+
+/*
+ *  fwts_cpu_msr_open()
+ *	open the msr device of a CPU, loading the msr module if need be
+ */
+static int fwts_cpu_msr_open(fwts_framework *fw, const int cpu)
 {
 	char buffer[PATH_MAX];
-	uint64_t value = 0;
 	int fd;
-	int ret;
 
 	snprintf(buffer, sizeof(buffer), "/dev/cpu/%d/msr", cpu);
 	if ((fd = open(buffer, O_RDONLY)) < 0) {
@@ -73,17 +85,101 @@ int fwts_cpu_readmsr(
 		 *  module and retry
 		 */
 		if (fwts_module_load(fw, "msr") != FWTS_OK)
-			return FWTS_ERROR;
+			return -1;
 		if (fwts_module_loaded(fw, "msr", &loaded) != FWTS_OK)
-			return FWTS_ERROR;
+			return -1;
 		if (!loaded)
-			return FWTS_ERROR;
+			return -1;
 		if ((fd = open(buffer, O_RDONLY)) < 0)
-			return FWTS_ERROR; /* Really failed */
+			return -1; /* Really failed */
+	}
+	return fd;
+}
+
+/*
+ *  fwts_cpu_msr_fd()
+ *	get the msr device fd of a CPU, from the cache if it is open.
+ *	*cached is set if the fd is owned by the cache.
+ */
+static int fwts_cpu_msr_fd(fwts_framework *fw, const int cpu, bool *cached)
+{
+	*cached = false;
+	if (msr_fds && (cpu >= 0) && (cpu < msr_fds_size)) {
+		if (msr_fds[cpu] < 0)
+			msr_fds[cpu] = fwts_cpu_msr_open(fw, cpu);
+		*cached = (msr_fds[cpu] >= 0);
+		return msr_fds[cpu];
 	}
 
+	return fwts_cpu_msr_open(fw, cpu);
+}
+
+/*
+ *  fwts_cpu_msr_cache_open()
+ *	keep the msr devices open for all reads until
+ *	fwts_cpu_msr_cache_close() is called
+ */
+int fwts_cpu_msr_cache_open(void)
+{
+	int i, cpus;
+
+	if (msr_fds)
+		return FWTS_OK;
+
+	if ((cpus = fwts_cpu_enumerate()) < 0)
+		return FWTS_ERROR;
+
+	if ((msr_fds = calloc(cpus, sizeof(*msr_fds))) == NULL)
+		return FWTS_ERROR;
+
+	for (i = 0; i < cpus; i++)
+		msr_fds[i] = -1;
+	msr_fds_size = cpus;
+
+	return FWTS_OK;
+}
+
+/*
+ *  fwts_cpu_msr_cache_close()
+ *	close all the cached msr devices
+ */
+void fwts_cpu_msr_cache_close(void)
+{
+	int i;
+
+	if (!msr_fds)
+		return;
+
+	for (i = 0; i < msr_fds_size; i++)
+		if (msr_fds[i] >= 0)
+			(void)close(msr_fds[i]);
+
+	free(msr_fds);
+	msr_fds = NULL;
+	msr_fds_size = 0;
+}
+
+/*
+ *  fwts_cpu_readmsr()
+ *	Read a given msr on a specified CPU
+ */
+int fwts_cpu_readmsr(
+	fwts_framework *fw,
+	const int cpu,
+	const uint32_t reg,
+	uint64_t *val)
+{
+	uint64_t value = 0;
+	bool cached;
+	int fd;
+	int ret;
+
+	if ((fd = fwts_cpu_msr_fd(fw, cpu, &cached)) < 0)
+		return FWTS_ERROR;
+
 	ret = pread(fd, &value, 8, reg);
-	(void)close(fd);
+	if (!cached)
+		(void)close(fd);
 
 	*val = value;
 
@@ -93,6 +189,129 @@ int fwts_cpu_readmsr(
 	return FWTS_OK;
 }
 
+/*
+ *  Work for a batch MSR read worker, reads all the regs
+ *  from CPUs first .. last - 1 of the batch
+ */
+typedef struct {
+	const int *fds;
+	const uint32_t *regs;
+	int nregs;
+	int first;
+	int last;
+	uint64_t *vals;
+	int *rets;
+	bool failed;		/* set if any read failed */
+} fwts_cpu_msr_batch;
+
+/*
+ *  fwts_cpu_readmsrs_worker()
+ *	read the MSRs of a range of CPUs
+ */
+static void *fwts_cpu_readmsrs_worker(void *arg)
+{
+	fwts_cpu_msr_batch *batch = (fwts_cpu_msr_batch *)arg;
+	int i, j;
+
+	for (i = batch->first; i < batch->last; i++) {
+		for (j = 0; j < batch->nregs; j++) {
+			const int n = (i * batch->nregs) + j;
+			uint64_t value = 0;
+			int ret = FWTS_ERROR;
+
+			if ((batch->fds[i] >= 0) &&
+			    (pread(batch->fds[i], &value, 8, batch->regs[j]) >= 0))
+				ret = FWTS_OK;
+			else
+				batch->failed = true;
+			batch->vals[n] = value;
+			if (batch->rets)
+				batch->rets[n] = ret;
+		}
+	}
+	return NULL;
+}
+
+/*
+ *  fwts_cpu_readmsrs()
+ *	read nregs MSRs from each of ncpus CPUs. The value of regs[j]
+ *	on cpus[i] is stored in vals[(i * nregs) + j] and the result of
+ *	the read in rets[(i * nregs) + j] if rets is not NULL. Returns
+ *	FWTS_ERROR if any of the reads failed.
+ */
+int fwts_cpu_readmsrs(
+	fwts_framework *fw,
+	const int *cpus,
+	const int ncpus,
+	const uint32_t *regs,
+	const int nregs,
+	uint64_t *vals,
+	int *rets)
+{
+	fwts_cpu_msr_batch batches[MSR_THREADS_MAX];
+	pthread_t threads[MSR_THREADS_MAX];
+	bool *cached;
+	int *fds;
+	int i, started, nthreads = 1, ret = FWTS_OK;
+
+	if ((ncpus <= 0) || (nregs <= 0))
+		return FWTS_OK;
+
+	fds = calloc(ncpus, sizeof(*fds));
+	cached = calloc(ncpus, sizeof(*cached));
+	if (!fds || !cached) {
+		free(cached);
+		free(fds);
+		return FWTS_ERROR;
+	}
+
+	/* Open the devices here, opening can load the msr module and log */
+	for (i = 0; i < ncpus; i++)
+		fds[i] = fwts_cpu_msr_fd(fw, cpus[i], &cached[i]);
+
+	if (ncpus >= MSR_THREAD_MIN_CPUS) {
+		nthreads = ncpus / (MSR_THREAD_MIN_CPUS / 2);
+		if (nthreads > MSR_THREADS_MAX)
+			nthreads = MSR_THREADS_MAX;
+	}
+
+	for (i = 0; i < nthreads; i++) {
+		batches[i].fds = fds;
+		batches[i].regs = regs;
+		batches[i].nregs = nregs;
+		batches[i].first = (ncpus * i) / nthreads;
+		batches[i].last = (ncpus * (i + 1)) / nthreads;
+		batches[i].vals = vals;
+		batches[i].rets = rets;
+		batches[i].failed = false;
+	}
+
+	for (started = 1; started < nthreads; started++)
+		if (pthread_create(&threads[started], NULL,
+		    fwts_cpu_readmsrs_worker, &batches[started]) != 0)
+			break;
+
+	/* The calling thread reads the first range and any that have no worker */
+	(void)fwts_cpu_readmsrs_worker(&batches[0]);
+	for (i = started; i < nthreads; i++)
+		(void)fwts_cpu_readmsrs_worker(&batches[i]);
+	for (i = 1; i < started; i++)
+		(void)pthread_join(threads[i], NULL);
+
+	for (i = 0; i < nthreads; i++)
+		if (batches[i].failed)
+			ret = FWTS_ERROR;
+
+	for (i = 0; i < ncpus; i++)
+		if ((fds[i] >= 0) && !cached[i])
+			(void)close(fds[i]);
+
+	free(cached);
+	free(fds);
+
+	return ret;
+}
+
 /*
  *  fwts_cpu_free_info()
  *	free CPU information
@@ -417,13 +636,24 @@ static int perf_read_counter(int fd, unsigned long long *result)
 }
 
 /*
- *  fwts_cpu_benchmark()
- *
+ *  Benchmark status flags, set by fwts_cpu_benchmark_run() so that
+ *  workers that cannot log can report what happened to the parent
  */
-int fwts_cpu_benchmark(
-	fwts_framework *fw,
+#define BENCHMARK_NO_PERF		(0x01)	/* perf counters not available */
+#define BENCHMARK_PERF_READ_FAILED	(0x02)	/* could not read perf counter */
+#define BENCHMARK_GET_AFFINITY_FAILED	(0x04)
+#define BENCHMARK_SET_AFFINITY_FAILED	(0x08)
+#define BENCHMARK_RESTORE_AFFINITY_FAILED (0x10)
+
+/*
+ *  fwts_cpu_benchmark_run()
+ *	measure the performance of a CPU, does not log anything,
+ *	problems are reported in status
+ */
+static int fwts_cpu_benchmark_run(
 	const int cpu,		/* CPU we want to measure performance */
-	fwts_cpu_benchmark_result *result)
+	fwts_cpu_benchmark_result *result,
+	int *status)
 {
 	struct timeval start, end, duration;
 	unsigned long long perfctr_result;
@@ -433,6 +663,7 @@ int fwts_cpu_benchmark(
 	double duration_sec;
 	bool perf_ok;
 
+	*status = 0;
 	ncpus = fwts_cpu_enumerate();
 	memset(&tmp, 0, sizeof(tmp));
 
@@ -446,27 +677,20 @@ int fwts_cpu_benchmark(
 	perf_ok = true;
 	perfctr = perf_setup_counter(cpu);
 	if (perfctr < 0) {
-		static bool warned;
-
-		if (!warned) {
-			fwts_log_warning(fw, "Can't use linux performance "
-					"counters (perf), falling back to "
-					"relative measurements");
-			warned = true;
-		}
+		*status |= BENCHMARK_NO_PERF;
 		perf_ok = false;
 	}
 
 	/* Pin to the specified CPU */
 	if (sched_getaffinity(0, sizeof(oldset), &oldset) < 0) {
-		fwts_log_error(fw, "Cannot get scheduling affinity.");
+		*status |= BENCHMARK_GET_AFFINITY_FAILED;
 		return FWTS_ERROR;
 	}
 
 	CPU_ZERO(&mask);
 	CPU_SET(cpu, &mask);
 	if (sched_setaffinity(0, sizeof(mask), &mask) < 0) {
-		fwts_log_error(fw, "Cannot set scheduling affinity to CPU %d.", cpu);
+		*status |= BENCHMARK_SET_AFFINITY_FAILED;
 		return FWTS_ERROR;
 	}
 
@@ -493,7 +717,7 @@ int fwts_cpu_benchmark(
 		perf_stop_counter(perfctr);
 
 	if (sched_setaffinity(0, sizeof(oldset), &oldset) < 0) {
-		fwts_log_error(fw, "Cannot restore old CPU affinity settings.");
+		*status |= BENCHMARK_RESTORE_AFFINITY_FAILED;
 		return FWTS_ERROR;
 	}
 
@@ -509,7 +733,7 @@ int fwts_cpu_benchmark(
 			tmp.cycles = (1.0 * perfctr_result) / duration_sec;
 			tmp.cycles_valid = true;
 		} else {
-			fwts_log_warning(fw, "failed to read perf counters");
+			*status |= BENCHMARK_PERF_READ_FAILED;
 		}
 
 	}
@@ -519,6 +743,127 @@ int fwts_cpu_benchmark(
 	return FWTS_OK;
 }
 
+/*
+ *  fwts_cpu_benchmark_log()
+ *	log the problems a benchmark run reported in status
+ */
+static void fwts_cpu_benchmark_log(fwts_framework *fw, const int cpu, const int status)
+{
+	if (status & BENCHMARK_NO_PERF) {
+		static bool warned;
+
+		if (!warned) {
+			fwts_log_warning(fw, "Can't use linux performance "
+					"counters (perf), falling back to "
+					"relative measurements");
+			warned = true;
+		}
+	}
+	if (status & BENCHMARK_GET_AFFINITY_FAILED)
+		fwts_log_error(fw, "Cannot get scheduling affinity.");
+	if (status & BENCHMARK_SET_AFFINITY_FAILED)
+		fwts_log_error(fw, "Cannot set scheduling affinity to CPU %d.", cpu);
+	if (status & BENCHMARK_RESTORE_AFFINITY_FAILED)
+		fwts_log_error(fw, "Cannot restore old CPU affinity settings.");
+	if (status & BENCHMARK_PERF_READ_FAILED)
+		fwts_log_warning(fw, "failed to read perf counters");
+}
+
+/*
+ *  fwts_cpu_benchmark()
+ *
+ */
+int fwts_cpu_benchmark(
+	fwts_framework *fw,
+	const int cpu,		/* CPU we want to measure performance */
+	fwts_cpu_benchmark_result *result)
+{
+	int ret, status;
+
+	ret = fwts_cpu_benchmark_run(cpu, result, &status);
+	fwts_cpu_benchmark_log(fw, cpu, status);
+
+	return ret;
+}
+
+/*
+ *  Result of a benchmark worker, shared with the parent
+ */
+typedef struct {
+	fwts_cpu_benchmark_result result;
+	int ret;
+	int status;
+} fwts_cpu_benchmark_slot;
+
+/*
+ *  fwts_cpu_benchmark_cpus()
+ *	benchmark n CPUs at the same time, one worker process pinned
+ *	to each CPU. The result and return of each benchmark are stored
+ *	in results[i] and rets[i]. Returns FWTS_ERROR if the workers
+ *	could not be run, the caller may then benchmark each CPU in turn.
+ */
+int fwts_cpu_benchmark_cpus(
+	fwts_framework *fw,
+	const int *cpus,
+	const int n,
+	fwts_cpu_benchmark_result *results,
+	int *rets)
+{
+	fwts_cpu_benchmark_slot *slots;
+	pid_t *pids;
+	int i, started, ret = FWTS_OK;
+
+	if (n <= 0)
+		return FWTS_OK;
+
+	if ((pids = calloc(n, sizeof(pid_t))) == NULL)
+		return FWTS_ERROR;
+
+	slots = mmap(NULL, n * sizeof(*slots), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (slots == MAP_FAILED) {
+		free(pids);
+		return FWTS_ERROR;
+	}
+
+	for (started = 0; started < n; started++) {
+		pid_t pid;
+
+		pid = fork();
+		if (pid == 0) {
+			/* Child */
+			slots[started].ret = fwts_cpu_benchmark_run(cpus[started],
+				&slots[started].result, &slots[started].status);
+			_exit(0);
+		}
+		if (pid < 0) {
+			ret = FWTS_ERROR;
+			break;
+		}
+		pids[started] = pid;
+	}
+
+	for (i = 0; i < started; i++) {
+		int status;
+
+		if ((waitpid(pids[i], &status, 0) < 0) || (status != 0))
+			ret = FWTS_ERROR;
+	}
+
+	if (ret == FWTS_OK) {
+		for (i = 0; i < n; i++) {
+			results[i] = slots[i].result;
+			rets[i] = slots[i].ret;
+			fwts_cpu_benchmark_log(fw, cpus[i], slots[i].status);
+		}
+	}
+
+	(void)munmap(slots, n * sizeof(*slots));
+	free(pids);
+
+	return ret;
+}
+
 uint64_t fwts_cpu_benchmark_best_result(fwts_cpu_benchmark_result *res)
 {
 	return res->cycles_valid ? res->cycles : res->loops;
@@ -585,6 +930,65 @@ int fwts_cpu_consume_start(void)
 	return FWTS_OK;
 }
 
+/*
+ *  fwts_cpu_consume_cpus()
+ *	burn cycles on n CPUs at the same time for usecs microseconds
+ *	using one worker process pinned to each CPU. pinned[i] is set
+ *	to false if the worker could not run pinned to cpus[i].
+ */
+int fwts_cpu_consume_cpus(const int *cpus, const int n, const int usecs, bool *pinned)
+{
+	pid_t *pids;
+	int i, started, ret = FWTS_OK;
+
+	if ((pids = calloc(n, sizeof(pid_t))) == NULL)
+		return FWTS_ERROR;
+
+	for (started = 0; started < n; started++) {
+		pid_t pid;
+
+		pid = fork();
+		if (pid == 0) {
+			/* Child */
+			struct timeval start, now, duration;
+			cpu_set_t mask;
+
+			CPU_ZERO(&mask);
+			CPU_SET(cpus[started], &mask);
+			if (sched_setaffinity(0, sizeof(mask), &mask) < 0)
+				_exit(1);
+
+			gettimeofday(&start, NULL);
+			do {
+				fwts_cpu_burn_cycles();
+				gettimeofday(&now, NULL);
+				timersub(&now, &start, &duration);
+			} while ((duration.tv_sec * 1000000) + duration.tv_usec < usecs);
+			_exit(0);
+		}
+		if (pid < 0) {
+			/* Went wrong, reap the workers already running */
+			ret = FWTS_ERROR;
+			break;
+		}
+		pids[started] = pid;
+	}
+
+	for (i = 0; i < started; i++) {
+		int status;
+
+		if (waitpid(pids[i], &status, 0) < 0)
+			status = -1;
+		pinned[i] = (status == 0);
+	}
+	for (; i < n; i++)
+		pinned[i] = false;
+
+	free(pids);
+
+	return ret;
+}
+
 /*
  *  fwts_cpu_consume()
  *	consume a specified amount of CPU time
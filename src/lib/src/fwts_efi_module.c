@@ -23,12 +23,61 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/ioctl.h>
 
 #include "fwts_pipeio.h"
+#include "fwts_efi_runtime.h"
+#include "fwts_efi_module.h"
+
+/*
+ *  Latencies are kept in log-linear histograms, each power of 2
+ *  is split into 8 buckets so percentiles are within 12.5%
+ */
+#define LATENCY_SUB_BITS	(3)
+#define LATENCY_BUCKETS		((64 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+/* Default outlier thresholds in microseconds */
+#define LATENCY_THRESHOLD	(10000)
+#define LATENCY_THRESHOLD_SET	(100000)
+
+typedef struct {
+	const char *name;		/* runtime service name */
+	uint64_t threshold;		/* outlier threshold, usecs */
+	uint64_t count;			/* number of calls */
+	uint64_t min;			/* fastest call, nsecs */
+	uint64_t max;			/* slowest call, nsecs */
+	uint64_t outliers;		/* calls slower than threshold */
+	uint32_t hist[LATENCY_BUCKETS];	/* latency histogram */
+} efi_runtime_service;
+
+/* Indexed by the efi_runtime ioctl number */
+static efi_runtime_service efi_runtime_services[] = {
+	[0x01] = { .name = "GetVariable",		.threshold = LATENCY_THRESHOLD },
+	[0x02] = { .name = "SetVariable",		.threshold = LATENCY_THRESHOLD_SET },
+	[0x03] = { .name = "GetTime",			.threshold = LATENCY_THRESHOLD },
+	[0x04] = { .name = "SetTime",			.threshold = LATENCY_THRESHOLD },
+	[0x05] = { .name = "GetWakeupTime",		.threshold = LATENCY_THRESHOLD },
+	[0x06] = { .name = "SetWakeupTime",		.threshold = LATENCY_THRESHOLD },
+	[0x07] = { .name = "GetNextVariableName",	.threshold = LATENCY_THRESHOLD },
+	[0x08] = { .name = "QueryVariableInfo",		.threshold = LATENCY_THRESHOLD },
+	[0x09] = { .name = "GetNextHighMonotonicCount",	.threshold = LATENCY_THRESHOLD },
+	[0x0a] = { .name = "QueryCapsuleCapabilities",	.threshold = LATENCY_THRESHOLD },
+	[0x0b] = { .name = "ResetSystem",		.threshold = LATENCY_THRESHOLD },
+	[0x0c] = { .name = "GetSupportedMask",		.threshold = LATENCY_THRESHOLD },
+};
 
 static char *efi_dev_name = NULL;
 static char *module_name = NULL;
 
+static int efi_runtime_ioctl(const int fd, const unsigned long request, void *arg);
+static fwts_efi_runtime_ioctl_func efi_runtime_ioctl_func = efi_runtime_ioctl;
+
 /*
  *  check_module_loaded_no_dev()
  *	sanity check - we don't have a device so we definitely should
@@ -236,3 +285,269 @@ int fwts_lib_efi_runtime_module_init(fwts_framework *fw, int *fd)
 
 	return FWTS_OK;
 }
+
+/*
+ *  efi_runtime_ioctl()
+ *	default ioctl backend, the efi_runtime device
+ */
+static int efi_runtime_ioctl(const int fd, const unsigned long request, void *arg)
+{
+	return ioctl(fd, request, arg);
+}
+
+/*
+ *  efi_runtime_service_get()
+ *	find the runtime service for an efi_runtime ioctl, NULL if unknown
+ */
+static efi_runtime_service *efi_runtime_service_get(const unsigned long request)
+{
+	const unsigned int nr = _IOC_NR(request);
+
+	if ((_IOC_TYPE(request) != 'p') ||
+	    (nr >= FWTS_ARRAY_SIZE(efi_runtime_services)) ||
+	    (!efi_runtime_services[nr].name))
+		return NULL;
+
+	return &efi_runtime_services[nr];
+}
+
+/*
+ *  efi_runtime_latency_bucket()
+ *	histogram bucket for a latency in nsecs
+ */
+static inline unsigned int efi_runtime_latency_bucket(const uint64_t nsecs)
+{
+	unsigned int shift;
+
+	if (nsecs < (2 << LATENCY_SUB_BITS))
+		return (unsigned int)nsecs;
+
+	shift = (63 - __builtin_clzll(nsecs)) - LATENCY_SUB_BITS;
+	return (shift << LATENCY_SUB_BITS) + (unsigned int)(nsecs >> shift);
+}
+
+/*
+ *  efi_runtime_latency_bucket_max()
+ *	largest latency in nsecs that lands in a histogram bucket
+ */
+static inline uint64_t efi_runtime_latency_bucket_max(const unsigned int bucket)
+{
+	unsigned int shift;
+	uint64_t mantissa;
+
+	if (bucket < (2 << LATENCY_SUB_BITS))
+		return bucket;
+
+	shift = (bucket >> LATENCY_SUB_BITS) - 1;
+	mantissa = (bucket & ((1 << LATENCY_SUB_BITS) - 1)) + (1 << LATENCY_SUB_BITS);
+
+	return ((mantissa + 1) << shift) - 1;
+}
+
+/*
+ *  efi_runtime_latency_percentile()
+ *	estimate the latency at a given percentile from the histogram
+ */
+static uint64_t efi_runtime_latency_percentile(
+	const efi_runtime_service *service,
+	const unsigned int percent)
+{
+	uint64_t rank = ((service->count * percent) + 99) / 100;
+	uint64_t n = 0;
+	unsigned int i;
+
+	if (rank < 1)
+		rank = 1;
+
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		n += service->hist[i];
+		if (n >= rank) {
+			const uint64_t nsecs = efi_runtime_latency_bucket_max(i);
+
+			if (nsecs < service->min)
+				return service->min;
+			return nsecs > service->max ? service->max : nsecs;
+		}
+	}
+	return service->max;
+}
+
+/*
+ *  fwts_lib_efi_runtime_ioctl()
+ *	issue an efi_runtime ioctl and record how long the
+ *	runtime service took, errno is preserved for the caller
+ */
+int fwts_lib_efi_runtime_ioctl(const int fd, const unsigned long request, void *arg)
+{
+	efi_runtime_service *service = efi_runtime_service_get(request);
+	struct timespec t1, t2;
+	uint64_t nsecs;
+	int ret, saved_errno;
+
+	if (!service)
+		return efi_runtime_ioctl_func(fd, request, arg);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	ret = efi_runtime_ioctl_func(fd, request, arg);
+	saved_errno = errno;
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	nsecs = ((t2.tv_sec - t1.tv_sec) * 1000000000ULL) + t2.tv_nsec - t1.tv_nsec;
+	if (!service->count || (nsecs < service->min))
+		service->min = nsecs;
+	if (nsecs > service->max)
+		service->max = nsecs;
+	if (nsecs > service->threshold * 1000)
+		service->outliers++;
+	service->hist[efi_runtime_latency_bucket(nsecs)]++;
+	service->count++;
+
+	errno = saved_errno;
+	return ret;
+}
+
+/*
+ *  fwts_lib_efi_runtime_ioctl_set()
+ *	set the ioctl backend, e.g. a mock runtime service to
+ *	exercise the tests without firmware, NULL restores the
+ *	efi_runtime device backend
+ */
+void fwts_lib_efi_runtime_ioctl_set(fwts_efi_runtime_ioctl_func func)
+{
+	efi_runtime_ioctl_func = func ? func : efi_runtime_ioctl;
+}
+
+/*
+ *  fwts_lib_efi_runtime_latency_reset()
+ *	forget all the recorded latencies, thresholds are kept
+ */
+void fwts_lib_efi_runtime_latency_reset(void)
+{
+	size_t i;
+
+	for (i = 0; i < FWTS_ARRAY_SIZE(efi_runtime_services); i++) {
+		efi_runtime_service *service = &efi_runtime_services[i];
+
+		service->count = 0;
+		service->min = 0;
+		service->max = 0;
+		service->outliers = 0;
+		memset(service->hist, 0, sizeof(service->hist));
+	}
+}
+
+/*
+ *  fwts_lib_efi_runtime_latency_get()
+ *	get the latency statistics of the runtime service of an
+ *	efi_runtime ioctl
+ */
+int fwts_lib_efi_runtime_latency_get(
+	const unsigned long request,
+	fwts_efi_runtime_latency *latency)
+{
+	const efi_runtime_service *service = efi_runtime_service_get(request);
+
+	if (!service || !latency)
+		return FWTS_ERROR;
+
+	latency->count = service->count;
+	latency->min = service->min;
+	latency->p50 = service->count ? efi_runtime_latency_percentile(service, 50) : 0;
+	latency->p99 = service->count ? efi_runtime_latency_percentile(service, 99) : 0;
+	latency->max = service->max;
+	latency->outliers = service->outliers;
+
+	return FWTS_OK;
+}
+
+/*
+ *  fwts_lib_efi_runtime_latency_threshold()
+ *	set outlier thresholds in microseconds from a comma separated
+ *	list of usecs for all the services or service:usecs for just
+ *	one service, e.g. "5000,SetVariable:50000"
+ */
+int fwts_lib_efi_runtime_latency_threshold(const char *str)
+{
+	char *tmp, *token, *saveptr = NULL;
+
+	if (!str || ((tmp = strdup(str)) == NULL))
+		return FWTS_ERROR;
+
+	for (token = strtok_r(tmp, ",", &saveptr); token; token = strtok_r(NULL, ",", &saveptr)) {
+		char *colon = strchr(token, ':');
+		char *value = colon ? colon + 1 : token;
+		unsigned long long usecs;
+		char *end;
+		size_t i;
+
+		errno = 0;
+		usecs = strtoull(value, &end, 10);
+		if (errno || (end == value) || *end)
+			goto err;
+
+		if (colon)
+			*colon = '\0';
+		for (i = 0; i < FWTS_ARRAY_SIZE(efi_runtime_services); i++) {
+			efi_runtime_service *service = &efi_runtime_services[i];
+
+			if (service->name && (!colon || !strcasecmp(service->name, token))) {
+				service->threshold = usecs;
+				if (colon)
+					break;
+			}
+		}
+		if (colon && (i == FWTS_ARRAY_SIZE(efi_runtime_services)))
+			goto err;
+	}
+	free(tmp);
+	return FWTS_OK;
+err:
+	free(tmp);
+	return FWTS_ERROR;
+}
+
+/*
+ *  fwts_lib_efi_runtime_latency_report()
+ *	log the latencies of the runtime services that have been
+ *	called and warn about any that exceeded their threshold
+ */
+void fwts_lib_efi_runtime_latency_report(fwts_framework *fw)
+{
+	size_t i;
+	bool header = false;
+
+	for (i = 0; i < FWTS_ARRAY_SIZE(efi_runtime_services); i++) {
+		const efi_runtime_service *service = &efi_runtime_services[i];
+
+		if (!service->name || !service->count)
+			continue;
+
+		if (!header) {
+			fwts_log_info_verbatim(fw, "UEFI runtime service latency (usecs):");
+			fwts_log_info_verbatim(fw, "  %-26s %8s %10s %10s %10s %10s",
+				"Service", "Calls", "Min", "P50", "P99", "Max");
+			header = true;
+		}
+		fwts_log_info_verbatim(fw, "  %-26s %8" PRIu64 " %10.1f %10.1f %10.1f %10.1f",
+			service->name, service->count,
+			(double)service->min / 1000.0,
+			(double)efi_runtime_latency_percentile(service, 50) / 1000.0,
+			(double)efi_runtime_latency_percentile(service, 99) / 1000.0,
+			(double)service->max / 1000.0);
+	}
+	if (header)
+		fwts_log_nl(fw);
+
+	for (i = 0; i < FWTS_ARRAY_SIZE(efi_runtime_services); i++) {
+		const efi_runtime_service *service = &efi_runtime_services[i];
+
+		if (!service->name || !service->outliers)
+			continue;
+
+		fwts_warning(fw, "%" PRIu64 " of %" PRIu64 " %s calls took longer "
+			"than %" PRIu64 " usecs, the slowest took %.1f usecs. Slow "
+			"runtime services stall the kernel's EFI runtime work queue.",
+			service->outliers, service->count, service->name,
+			service->threshold, (double)service->max / 1000.0);
+	}
+}
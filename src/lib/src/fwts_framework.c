@@ -22,16 +22,21 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
+#include <errno.h>
 #include <stdbool.h>
 #include <ctype.h>
 #include <time.h>
 #include <getopt.h>
 #include <bsd/string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/utsname.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 
 #include "fwts.h"
 #include "fwts_pm_method.h"
+#include "fwts_efi_module.h"
 
 typedef struct {
 	const char *title;		/* Test category */
@@ -139,6 +144,10 @@ static fwts_option fwts_framework_options[] = {
 	{ "ifv",		"",   0, "Run tests in firmware-vendor modes." },
 	{ "clog",		"",   1, "Specify a coreboot logfile dump" },
 	{ "ebbr",		"",   0, "Run ARM EBBR tests." },
+	{ "uefi-rt-latency",	"",   1, "Warn about UEFI runtime service calls slower than the given usecs, e.g. --uefi-rt-latency=5000,SetVariable:50000" },
+	{ "jobs",		"",   1, "Run up to N read-only tests in parallel worker processes, e.g. --jobs=8." },
+	{ "pci-path",		"",   1, "Path to a copy of the /sys/bus/pci/devices tree to test, e.g. --pci-path=/some/path/devices" },
+	{ "iasl-cache",		"",   1, "Cache iasl disassembly and reassembly results in the given directory, e.g. --iasl-cache=/var/cache/fwts" },
 	{ NULL, NULL, 0, NULL }
 };
 
@@ -180,7 +189,7 @@ void fwts_framework_test_add(
 {
 	fwts_framework_test *new_test;
 
-	if (flags & ~(FWTS_FLAG_RUN_ALL | FWTS_FLAG_ROOT_PRIV)) {
+	if (flags & ~(FWTS_FLAG_RUN_ALL | FWTS_FLAG_ROOT_PRIV | FWTS_FLAG_READ_ONLY)) {
 		fprintf(stderr, "Test %s flags must be a bit field in 0x%x, got 0x%x\n",
 			name, FWTS_FLAG_RUN_ALL, flags);
 		exit(EXIT_FAILURE);
@@ -723,22 +732,257 @@ done:
 	return FWTS_OK;
 }
 
+/*
+ *  What a --jobs worker hands back to the parent, shared memory
+ */
+typedef struct {
+	fwts_results results;		/* test->results */
+	fwts_results total;		/* what the test added to fw->total */
+	fwts_log_level failed_level;	/* fw->failed_level */
+	bool print_summary;		/* fw->print_summary */
+	bool done;			/* worker ran the test to completion */
+} fwts_framework_job_result;
+
+/*
+ *  A read-only test running in a --jobs worker
+ */
+typedef struct {
+	fwts_framework_test *test;
+	pid_t pid;
+	FILE *log;			/* private results log of the worker */
+	FILE *output;			/* stdout of the worker */
+	FILE *progress;			/* stderr of the worker */
+	FILE *summary;			/* failure summary items of the worker */
+	fwts_framework_job_result *result;
+} fwts_framework_job;
+
+/*
+ *  fwts_framework_jobs_log_file()
+ *	workers can only be used when logging plain text without
+ *	line numbers to one log file, return it or NULL if not
+ */
+static fwts_log_file *fwts_framework_jobs_log_file(fwts_framework *fw)
+{
+	if ((fw->jobs < 2) ||
+	    (fw->log_type != LOG_TYPE_PLAINTEXT) ||
+	    (fw->flags & FWTS_FLAG_SHOW_PROGRESS_DIALOG) ||
+	    (strstr(fwts_log_format, "%line") != NULL) ||
+	    (fwts_list_len(&fw->results->log_files) != 1))
+		return NULL;
+
+	return fwts_list_data(fwts_log_file *, fw->results->log_files.head);
+}
+
+/*
+ *  fwts_framework_copy_file()
+ *	append the contents of file from to file to
+ */
+static void fwts_framework_copy_file(FILE *from, FILE *to)
+{
+	char buffer[8192];
+	size_t n;
+
+	rewind(from);
+	while ((n = fread(buffer, 1, sizeof(buffer), from)) > 0)
+		if (fwrite(buffer, 1, n, to) != n)
+			break;
+	fflush(to);
+}
+
+/*
+ *  fwts_framework_job_free()
+ *	free the resources of a job
+ */
+static void fwts_framework_job_free(fwts_framework_job *job)
+{
+	if (job->log)
+		(void)fclose(job->log);
+	if (job->output)
+		(void)fclose(job->output);
+	if (job->progress)
+		(void)fclose(job->progress);
+	if (job->summary)
+		(void)fclose(job->summary);
+	if (job->result)
+		(void)munmap(job->result, sizeof(*job->result));
+	memset(job, 0, sizeof(*job));
+}
+
+/*
+ *  fwts_framework_job_start()
+ *	fork a worker that runs a test with the results log, stdout,
+ *	stderr and failure summary redirected to private buffers
+ */
+static int fwts_framework_job_start(
+	fwts_framework *fw,
+	fwts_log_file *log_file,
+	fwts_framework_job *job,
+	fwts_framework_test *test)
+{
+	fwts_framework_job_result *result;
+
+	memset(job, 0, sizeof(*job));
+	job->test = test;
+	job->log = tmpfile();
+	job->output = tmpfile();
+	job->progress = tmpfile();
+	job->summary = tmpfile();
+	job->result = mmap(NULL, sizeof(*job->result), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (job->result == MAP_FAILED)
+		job->result = NULL;
+	if (!job->log || !job->output || !job->progress || !job->summary || !job->result) {
+		fwts_framework_job_free(job);
+		return FWTS_ERROR;
+	}
+	memset(job->result, 0, sizeof(*job->result));
+
+	/* Don't let the worker flush out buffered output a second time */
+	fflush(stdout);
+	fflush(stderr);
+	fflush(log_file->fp);
+
+	job->pid = fork();
+	if (job->pid < 0) {
+		fwts_framework_job_free(job);
+		return FWTS_ERROR;
+	}
+	if (job->pid > 0)
+		return FWTS_OK;
+
+	/* Worker */
+	result = job->result;
+	log_file->fp = job->log;
+	(void)dup2(fileno(job->output), STDOUT_FILENO);
+	(void)dup2(fileno(job->progress), STDERR_FILENO);
+	fwts_summary_deinit();
+	(void)fwts_summary_init();
+
+	/* Just count what this test adds to the totals */
+	fwts_results_zero(&fw->total);
+	fwts_framework_run_test(fw, test);
+
+	result->results = test->results;
+	result->total = fw->total;
+	result->failed_level = fw->failed_level;
+	result->print_summary = fw->print_summary;
+	result->done = (fwts_summary_save(job->summary) == FWTS_OK);
+
+	fflush(NULL);
+	_exit(EXIT_SUCCESS);
+}
+
+/*
+ *  fwts_framework_job_finish()
+ *	wait for a worker and add its log, output, progress, results
+ *	and failure summary as if the test had just been run here
+ */
+static void fwts_framework_job_finish(fwts_framework *fw, fwts_log_file *log_file, fwts_framework_job *job)
+{
+	fwts_framework_test *test = job->test;
+	fwts_framework_job_result *result = job->result;
+	int status;
+
+	while ((waitpid(job->pid, &status, 0) < 0) && (errno == EINTR))
+		;
+
+	fwts_framework_copy_file(job->log, log_file->fp);
+	fwts_framework_copy_file(job->output, stdout);
+	fwts_framework_copy_file(job->progress, stderr);
+
+	fw->current_major_test = test;
+	test->was_run = true;
+	fw->total_run++;
+
+	if (result->done) {
+		test->results = result->results;
+		fwts_framework_summate_results(&fw->total, &result->total);
+		fw->failed_level = result->failed_level;
+		if (result->print_summary)
+			fw->print_summary = true;
+		rewind(job->summary);
+		(void)fwts_summary_load(fw, job->summary);
+	} else {
+		fwts_log_set_owner(fw->results, test->name);
+		fwts_log_error(fw, "Aborted test, worker process terminated unexpectedly.");
+		fwts_log_set_owner(fw->results, "fwts");
+		fwts_results_zero(&test->results);
+		test->results.aborted = test->ops->total_tests;
+		fw->total.aborted += test->ops->total_tests;
+		if (!(test->flags & FWTS_FLAG_UTILS))
+			fw->print_summary = true;
+	}
+	fwts_framework_job_free(job);
+}
+
 /*
  *  fwts_framework_tests_run()
- *
+ *	run the tests, with --jobs consecutive read-only tests are run
+ *	in parallel worker processes and their output is added to the
+ *	results log in the original test order
  */
 static void fwts_framework_tests_run(fwts_framework *fw, fwts_list *tests_to_run)
 {
 	fwts_list_link *item;
+	fwts_log_file *log_file = fwts_framework_jobs_log_file(fw);
+	fwts_framework_job *jobs = NULL;
+	uint32_t head = 0, running = 0;
+#if defined(FWTS_HAS_ACPI)
+	bool tables_loaded = false;
+#endif
 
 	fw->current_major_test_num = 1;
 	fw->major_tests_total  = fwts_list_len(tests_to_run);
 
+	if (log_file)
+		jobs = calloc(fw->jobs, sizeof(*jobs));
+
 	fwts_list_foreach(item, tests_to_run) {
 		fwts_framework_test *test = fwts_list_data(fwts_framework_test *, item);
+
+		if (jobs && (test->flags & FWTS_FLAG_READ_ONLY) &&
+		    !FWTS_TEST_INTERACTIVE(test->flags)) {
+#if defined(FWTS_HAS_ACPI)
+			/*
+			 *  Load the ACPI tables once for all workers, unless
+			 *  that would log a lack of privilege outside a test
+			 */
+			if (!tables_loaded &&
+			    (fw->acpi_table_path || fw->acpi_table_acpidump_file ||
+			     (geteuid() == 0))) {
+				fwts_acpi_table_info *info;
+
+				(void)fwts_acpi_get_table(fw, 0, &info);
+				tables_loaded = true;
+			}
+#endif
+			if (running == fw->jobs) {
+				fwts_framework_job_finish(fw, log_file, &jobs[head]);
+				head = (head + 1) % fw->jobs;
+				running--;
+			}
+			if (fwts_framework_job_start(fw, log_file,
+			    &jobs[(head + running) % fw->jobs], test) == FWTS_OK) {
+				running++;
+				fw->current_major_test_num++;
+				continue;
+			}
+		}
+
+		/* Serial test, so results of earlier workers go first */
+		for (; running > 0; running--) {
+			fwts_framework_job_finish(fw, log_file, &jobs[head]);
+			head = (head + 1) % fw->jobs;
+		}
 		fwts_framework_run_test(fw, test);
 		fw->current_major_test_num++;
 	}
+
+	for (; running > 0; running--) {
+		fwts_framework_job_finish(fw, log_file, &jobs[head]);
+		head = (head + 1) % fw->jobs;
+	}
+	free(jobs);
 }
 
 /*
@@ -760,31 +1004,19 @@ static fwts_framework_test *fwts_framework_test_find(const char *name)
 
 bool fwts_error_filtered_out(fwts_framework *fw, const char *label)
 {
-	fwts_list_link *item;
-
 	/*
 	 *  Has the user specified errors to discard?  If we find any matches
 	 *  then flag as wanting to filter out.
 	 */
-	if (fwts_list_len(&fw->errors_filter_discard) > 0) {
-		fwts_list_foreach(item, &fw->errors_filter_discard) {
-			if (strcmp(label, fwts_list_data(char *, item)) == 0)
-				return true;	/* Discard */
-		}
-		return false;	/* No matches, won't discard */
-	}
+	if (fwts_list_len(&fw->errors_filter_discard) > 0)
+		return fwts_hash_get(fw->errors_filter_discard_hash, label) != NULL;
 
 	/*
 	 *  Has the user specified errors to keep?  If we find any matches
-	 *  then flag as wanting to keep.
+	 *  then flag as wanting to keep, otherwise discard.
 	 */
-	if (fwts_list_len(&fw->errors_filter_keep) > 0) {
-		fwts_list_foreach(item, &fw->errors_filter_keep) {
-			if (strcmp(label, fwts_list_data(char *, item)) == 0)
-				return false;	/* Don't discard */
-		}
-		return true;	/* Not found, so discard */
-	}
+	if (fwts_list_len(&fw->errors_filter_keep) > 0)
+		return fwts_hash_get(fw->errors_filter_keep_hash, label) == NULL;
 
 	/*
 	 *  User not specified any filters?  Don't discard
@@ -1020,13 +1252,19 @@ static int fwts_framework_skip_test_parse(char *arg)
 	return FWTS_OK;
 }
 
-static int fwts_framework_filter_error_parse(char *arg, fwts_list *list)
+static int fwts_framework_filter_error_parse(char *arg, fwts_list *list, fwts_hash **hash)
 {
 	char *str;
 	char *token;
 
+	if (!*hash && ((*hash = fwts_hash_new(0)) == NULL)) {
+		fprintf(stderr, "Out of memory parsing argument %s\n", arg);
+		return FWTS_ERROR;
+	}
+
 	for (str = arg; (token = strtok(str, ",")) != NULL; str = NULL) {
-		if (fwts_list_append(list, token) == NULL) {
+		if ((fwts_list_append(list, token) == NULL) ||
+		    (!fwts_hash_get(*hash, token) && (fwts_hash_add(*hash, token, token) != FWTS_OK))) {
 			fprintf(stderr, "Out of memory parsing argument %s\n", arg);
 			fwts_list_free_items(list, NULL);
 			return FWTS_ERROR;
@@ -1294,11 +1532,13 @@ int fwts_framework_options_handler(fwts_framework *fw, int argc, char * const ar
 			fw->flags |= FWTS_FLAG_UNSAFE;
 			break;
 		case 34: /* --filter-error-discard */
-			if (fwts_framework_filter_error_parse(optarg, &fw->errors_filter_discard) != FWTS_OK)
+			if (fwts_framework_filter_error_parse(optarg,
+			    &fw->errors_filter_discard, &fw->errors_filter_discard_hash) != FWTS_OK)
 				return FWTS_ERROR;
 			break;
 		case 35: /* --filter-error-keep */
-			if (fwts_framework_filter_error_parse(optarg, &fw->errors_filter_keep) != FWTS_OK)
+			if (fwts_framework_filter_error_parse(optarg,
+			    &fw->errors_filter_keep, &fw->errors_filter_keep_hash) != FWTS_OK)
 				return FWTS_ERROR;
 			break;
 		case 36: /* --acpica-debug */
@@ -1357,6 +1597,30 @@ int fwts_framework_options_handler(fwts_framework *fw, int argc, char * const ar
 			fprintf(stderr, "option not available on this architecture\n");
 			return FWTS_ERROR;
 #endif
+		case 50: /* --uefi-rt-latency */
+			if (fwts_lib_efi_runtime_latency_threshold(optarg) != FWTS_OK) {
+				fprintf(stderr, "--uefi-rt-latency expects a comma separated "
+					"list of usecs or service:usecs, got '%s'.\n", optarg);
+				return FWTS_ERROR;
+			}
+			break;
+		case 51: /* --jobs */
+			if (atoi(optarg) < 1) {
+				fprintf(stderr, "--jobs expects a number of jobs "
+					"greater than 0, got '%s'.\n", optarg);
+				return FWTS_ERROR;
+			}
+			fw->jobs = atoi(optarg);
+			break;
+		case 52: /* --pci-path */
+			fwts_framework_strdup(&fw->pci_dev_path, optarg);
+			break;
+		case 53: /* --iasl-cache */
+			if (fwts_iasl_cache_open(fw, optarg) != FWTS_OK) {
+				fprintf(stderr, "Cannot use %s as an iasl cache directory.\n", optarg);
+				return FWTS_ERROR;
+			}
+			break;
 		}
 		break;
 	case 'a': /* --all */
@@ -1489,6 +1753,7 @@ int fwts_framework_args(const int argc, char **argv)
 	fwts_summary_init();
 
 	fwts_framework_strdup(&fw->lspci, FWTS_LSPCI_PATH);
+	fwts_framework_strdup(&fw->pci_dev_path, FWTS_PCI_DEV_PATH);
 	fwts_framework_strdup(&fw->results_logname, RESULTS_LOG);
 	fwts_framework_strdup(&fw->json_data_path, FWTS_JSON_DATA_PATH);
 
@@ -1623,6 +1888,33 @@ int fwts_framework_args(const int argc, char **argv)
 	fwts_framework_tests_run(fw, &tests_to_run);
 	fwts_log_section_end(fw->results);
 
+	if (!(fw->flags & (FWTS_FLAG_QUIET | FWTS_FLAG_SHOW_PROGRESS_DIALOG))) {
+		unsigned long hits, misses;
+		/* Don't mix the stats into results or the dialog progress written to stdout */
+		const bool results_to_file =
+			(fwts_log_get_filename_type(fw->results_logname) == LOG_FILENAME_TYPE_FILE);
+#if defined(FWTS_HAS_ACPI)
+		unsigned long inits, inits_saved;
+
+		fwts_acpi_session_stats(&inits, &inits_saved);
+		if (results_to_file && (inits_saved > 0))
+			printf("ACPICA initialised %lu time%s, %lu initialisation%s saved\n",
+				inits, inits == 1 ? "" : "s",
+				inits_saved, inits_saved == 1 ? "" : "s");
+
+		fwts_iasl_cache_stats(&hits, &misses);
+		if (results_to_file && (hits + misses > 0))
+			printf("iasl cache: %lu hit%s, %lu miss%s\n",
+				hits, hits == 1 ? "" : "s",
+				misses, misses == 1 ? "" : "es");
+#endif
+		fwts_log_patterns_cache_stats(&hits, &misses);
+		if (results_to_file && (hits + misses > 0))
+			printf("log pattern cache: %lu hit%s, %lu miss%s\n",
+				hits, hits == 1 ? "" : "s",
+				misses, misses == 1 ? "" : "es");
+	}
+
 	if (fw->print_summary) {
 		fwts_log_section_begin(fw->results, "summary");
 		fwts_log_set_owner(fw->results, "summary");
@@ -1640,21 +1932,29 @@ tidy:
 
 tidy_close:
 #if defined(FWTS_HAS_ACPI)
+	(void)fwts_acpi_release();
 	fwts_acpi_free_tables();
 #endif
 	fwts_summary_deinit();
+	fwts_log_patterns_cache_free();
+	fwts_pci_snapshot_release();
+	fwts_iasl_cache_close();
 
 	free(fw->lspci);
+	free(fw->pci_dev_path);
 	free(fw->results_logname);
 	free(fw->clog);
 	free(fw->klog);
 	free(fw->olog);
 	free(fw->json_data_path);
 	free(fw->json_data_file);
+	free(fw->iasl_cache_path);
 	free(fw->fdt);
 
 	fwts_list_free_items(&fw->errors_filter_discard, NULL);
 	fwts_list_free_items(&fw->errors_filter_keep, NULL);
+	fwts_hash_free(fw->errors_filter_discard_hash, NULL);
+	fwts_hash_free(fw->errors_filter_keep_hash, NULL);
 	fwts_list_free_items(&fwts_framework_test_list, free);
 
 	/* Failed tests flagged an error */
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2021 Canonical
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fwts.h"
+
+/*
+ *  Default and minimum number of hash buckets
+ */
+#define HASH_SIZE_DEFAULT	(251)
+
+/*
+ *  fwts_hash_str()
+ *	djb2a string hash
+ */
+uint32_t fwts_hash_str(const char *str)
+{
+	register uint32_t hash = 5381;
+	register int c;
+
+	while ((c = *str++))
+		/* (hash * 33) ^ c */
+		hash = ((hash << 5) + hash) ^ c;
+
+	return hash;
+}
+
+/*
+ *  fwts_hash_new()
+ *	allocate a new hash, size is a hint of the expected
+ *	number of items, the hash grows when it fills up
+ */
+fwts_hash *fwts_hash_new(const size_t size)
+{
+	fwts_hash *hash;
+
+	if ((hash = calloc(1, sizeof(*hash))) == NULL)
+		return NULL;
+
+	hash->size = size > HASH_SIZE_DEFAULT ? size : HASH_SIZE_DEFAULT;
+	if ((hash->table = calloc(hash->size, sizeof(*hash->table))) == NULL) {
+		free(hash);
+		return NULL;
+	}
+	return hash;
+}
+
+/*
+ *  fwts_hash_free()
+ *	free a hash, use data_free() to free the user data
+ *	if it is non-NULL.
+ */
+void fwts_hash_free(fwts_hash *hash, fwts_hash_data_free data_free)
+{
+	size_t i;
+
+	if (!hash)
+		return;
+
+	for (i = 0; i < hash->size; i++) {
+		fwts_hash_node *node, *next;
+
+		for (node = hash->table[i]; node; node = next) {
+			next = node->next;
+			if (node->data && data_free)
+				data_free(node->data);
+			free(node);
+		}
+	}
+	free(hash->table);
+	free(hash);
+}
+
+/*
+ *  fwts_hash_grow()
+ *	double the number of buckets and re-chain the nodes,
+ *	on allocation failure just keep the current table
+ */
+static void fwts_hash_grow(fwts_hash *hash)
+{
+	fwts_hash_node **table;
+	size_t size = (hash->size * 2) + 1;
+	size_t i;
+
+	if ((table = calloc(size, sizeof(*table))) == NULL)
+		return;
+
+	for (i = 0; i < hash->size; i++) {
+		fwts_hash_node *node, *next;
+
+		for (node = hash->table[i]; node; node = next) {
+			const size_t h = node->hash % size;
+
+			next = node->next;
+			node->next = table[h];
+			table[h] = node;
+		}
+	}
+	free(hash->table);
+	hash->table = table;
+	hash->size = size;
+}
+
+/*
+ *  fwts_hash_get()
+ *	find data associated with key, NULL if not found
+ */
+void *fwts_hash_get(fwts_hash *hash, const char *key)
+{
+	fwts_hash_node *node;
+	uint32_t h;
+
+	if (!hash || !key)
+		return NULL;
+
+	h = fwts_hash_str(key);
+	for (node = hash->table[h % hash->size]; node; node = node->next) {
+		if ((node->hash == h) && !strcmp(node->key, key))
+			return node->data;
+	}
+	return NULL;
+}
+
+/*
+ *  fwts_hash_add()
+ *	add key and data to hash, the key is not copied. Does
+ *	not check for duplicates, so look the key up first.
+ */
+int fwts_hash_add(fwts_hash *hash, const char *key, void *data)
+{
+	fwts_hash_node *node;
+	size_t h;
+
+	if (!hash || !key)
+		return FWTS_ERROR;
+
+	if ((node = calloc(1, sizeof(*node))) == NULL)
+		return FWTS_OUT_OF_MEMORY;
+
+	if (hash->count > (hash->size * 2))
+		fwts_hash_grow(hash);
+
+	node->key = key;
+	node->hash = fwts_hash_str(key);
+	node->data = data;
+
+	h = node->hash % hash->size;
+	node->next = hash->table[h];
+	hash->table[h] = node;
+	hash->count++;
+
+	return FWTS_OK;
+}
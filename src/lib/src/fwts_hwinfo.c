@@ -477,60 +477,43 @@ static void fwts_hwinfo_net_dump(fwts_framework *fw, fwts_list *devices)
 
 /*
  *  fwts_hwinfo_pci_get()
- * 	read a specific PCI config based on class code,
- *	retuning matching PCI configs into the configs list
+ * 	get the PCI configs of a specific class code from a
+ *	PCI snapshot, retuning matching PCI configs into the configs list
  */
 static int fwts_hwinfo_pci_get(
 	fwts_framework *fw,
+	fwts_pci_snapshot *snapshot,
 	const uint8_t class_code,
 	fwts_list *configs)
 {
-	DIR *pci;
-	struct dirent *d;
+	size_t i;
 
 	fwts_list_init(configs);
-	if ((pci = opendir(FWTS_PCI_DEV_PATH)) == NULL) {
-		fwts_log_error(fw, "Cannot open %s to scan PCI devices.", FWTS_PCI_DEV_PATH);
+	if (!snapshot)
 		return FWTS_ERROR;
-	}
 
-	while ((d = readdir(pci)) != NULL) {
-		ssize_t	n;
-		int	fd;
+	for (i = 0; i < snapshot->count; i++) {
+		fwts_pci_snapshot_device *device = &snapshot->devices[i];
 		fwts_pci_config *pci_config;
-		uint8_t	config[64];
-		char 	path[PATH_MAX];
-
-		if (d->d_name[0] == '.')
-			continue;
-		snprintf(path, sizeof(path), FWTS_PCI_DEV_PATH "/%s/config", d->d_name);
-
-		if ((fd = open(path, O_RDONLY)) < 0) {
-			fwts_log_error(fw, "Cannot open PCI config from %s.", d->d_name);
-			continue;
-		}
+		size_t n = device->config_len;
 
-		if ((n = read(fd, config, sizeof(config))) < 0) {
-			fwts_log_error(fw, "Cannot read PCI config from %s.", d->d_name);
-			(void)close(fd);
-			continue;
-		}
-		(void)close(fd);
+		if (n > sizeof(pci_config->config))
+			n = sizeof(pci_config->config);
 
-		if (config[FWTS_PCI_CONFIG_CLASS_CODE] != class_code)
+		if ((n <= FWTS_PCI_CONFIG_CLASS_CODE) ||
+		    (device->config[FWTS_PCI_CONFIG_CLASS_CODE] != class_code))
 			continue;
 
 		if ((pci_config = (fwts_pci_config *)calloc(1, sizeof(*pci_config))) == NULL) {
 			fwts_log_error(fw, "Cannot allocate PCI config.");
 			continue;
 		}
-		memcpy(pci_config->config, config, n);
+		memcpy(pci_config->config, device->config, n);
 		pci_config->config_len = n;
-		strlcpy(pci_config->name, d->d_name, sizeof(pci_config->name));
+		strlcpy(pci_config->name, device->name, sizeof(pci_config->name));
 
 		fwts_list_append(configs, pci_config);
 	}
-	(void)closedir(pci);
 
 	return FWTS_OK;
 }
@@ -968,11 +951,15 @@ static void fwts_hwinfo_lists_compare(
  */
 int fwts_hwinfo_get(fwts_framework *fw, fwts_hwinfo *hwinfo)
 {
-	FWTS_UNUSED(fw);
-
-	/* PCI devices */
-	fwts_hwinfo_pci_get(fw, FWTS_PCI_CLASS_CODE_NETWORK_CONTROLLER, &hwinfo->network);
-	fwts_hwinfo_pci_get(fw, FWTS_PCI_CLASS_CODE_DISPLAY_CONTROLLER, &hwinfo->videocard);
+	fwts_pci_snapshot *snapshot;
+	const char *path = fw->pci_dev_path ? fw->pci_dev_path : FWTS_PCI_DEV_PATH;
+
+	/* PCI devices, a new snapshot as H/W may have changed since the last one */
+	if ((snapshot = fwts_pci_snapshot_load(fw, path)) == NULL)
+		fwts_log_error(fw, "Cannot open %s to scan PCI devices.", path);
+	fwts_hwinfo_pci_get(fw, snapshot, FWTS_PCI_CLASS_CODE_NETWORK_CONTROLLER, &hwinfo->network);
+	fwts_hwinfo_pci_get(fw, snapshot, FWTS_PCI_CLASS_CODE_DISPLAY_CONTROLLER, &hwinfo->videocard);
+	fwts_pci_snapshot_free(snapshot);
 	/* Network devices */
 	fwts_hwinfo_net_get(fw, &hwinfo->netdevs);
 	fwts_hwinfo_input_get(fw, &hwinfo->input);
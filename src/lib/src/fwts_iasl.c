@@ -16,11 +16,14 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  *
  */
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <string.h>
@@ -32,13 +35,297 @@
 #include "fwts_iasl_interface.h"
 #include "fwts_acpica.h"
 
+/* acpica headers */
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include "acpi.h"
+#pragma GCC diagnostic error "-Wunused-parameter"
+
+/* Bump when the layout of --iasl-cache entries changes */
+#define FWTS_IASL_CACHE_FORMAT	(1)
+
 /* For ACPICA interface */
-static char *iasl_cached_table_filename[ACPI_MAX_TABLES];
-static char *iasl_cached_table_name[ACPI_MAX_TABLES];
+static char **iasl_cached_table_filename;
+static char **iasl_cached_table_name;
+static int *iasl_cached_table_fd;
+static int cached_size = 0;
 
 static bool iasl_init = false;
 static int cached_max = 0;
 
+/*
+ *  --iasl-cache hit and miss counts, in shared memory so that
+ *  lookups made in forked workers are counted too
+ */
+typedef struct {
+	unsigned long hits;
+	unsigned long misses;
+} fwts_iasl_cache_counts;
+
+static fwts_iasl_cache_counts *iasl_cache_counts;
+
+/*
+ *  fwts_iasl_write_list()
+ *	write a text list as a length and newline separated text,
+ *	a NULL list is written with a zero present flag
+ */
+static int fwts_iasl_write_list(const int fd, fwts_list *list)
+{
+	fwts_list_link *item;
+	uint32_t hdr[2] = { 0, 0 };
+	char *text, *ptr;
+
+	if (list == NULL)
+		return write(fd, hdr, sizeof(hdr)) == sizeof(hdr) ? FWTS_OK : FWTS_ERROR;
+
+	fwts_list_foreach(item, list)
+		hdr[1] += strlen(fwts_text_list_text(item)) + 1;
+	hdr[0] = 1;
+
+	if ((text = malloc((size_t)hdr[1] + 1)) == NULL)
+		return FWTS_ERROR;
+
+	ptr = text;
+	fwts_list_foreach(item, list) {
+		const char *line = fwts_text_list_text(item);
+		const size_t len = strlen(line);
+
+		memcpy(ptr, line, len);
+		ptr += len;
+		*ptr++ = '\n';
+	}
+
+	if ((write(fd, hdr, sizeof(hdr)) != sizeof(hdr)) ||
+	    (write(fd, text, hdr[1]) != (ssize_t)hdr[1])) {
+		free(text);
+		return FWTS_ERROR;
+	}
+	free(text);
+
+	return FWTS_OK;
+}
+
+/*
+ *  fwts_iasl_read_list()
+ *	read back a text list written by fwts_iasl_write_list()
+ */
+static int fwts_iasl_read_list(const int fd, fwts_list **list)
+{
+	uint32_t hdr[2];
+	char *text;
+
+	*list = NULL;
+	if (read(fd, hdr, sizeof(hdr)) != sizeof(hdr))
+		return FWTS_ERROR;
+	if (!hdr[0])
+		return FWTS_OK;
+
+	if ((text = malloc((size_t)hdr[1] + 1)) == NULL)
+		return FWTS_ERROR;
+	if (read(fd, text, hdr[1]) != (ssize_t)hdr[1]) {
+		free(text);
+		return FWTS_ERROR;
+	}
+	text[hdr[1]] = '\0';
+
+	*list = fwts_list_from_text(text);
+	free(text);
+
+	return *list ? FWTS_OK : FWTS_ERROR;
+}
+
+/*
+ *  fwts_iasl_cache_open()
+ *	cache iasl results in directory path, creating it if need be
+ */
+int fwts_iasl_cache_open(fwts_framework *fw, const char *path)
+{
+	struct stat buf;
+
+	if ((mkdir(path, 0755) < 0) && (errno != EEXIST))
+		return FWTS_ERROR;
+	if ((stat(path, &buf) < 0) || !S_ISDIR(buf.st_mode) ||
+	    (access(path, R_OK | W_OK | X_OK) < 0))
+		return FWTS_ERROR;
+
+	if (!iasl_cache_counts) {
+		iasl_cache_counts = mmap(NULL, sizeof(*iasl_cache_counts),
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (iasl_cache_counts == MAP_FAILED) {
+			iasl_cache_counts = NULL;
+			return FWTS_ERROR;
+		}
+	}
+
+	free(fw->iasl_cache_path);
+	if ((fw->iasl_cache_path = strdup(path)) == NULL)
+		return FWTS_ERROR;
+
+	return FWTS_OK;
+}
+
+/*
+ *  fwts_iasl_cache_close()
+ *	release the cache statistics
+ */
+void fwts_iasl_cache_close(void)
+{
+	if (iasl_cache_counts) {
+		(void)munmap(iasl_cache_counts, sizeof(*iasl_cache_counts));
+		iasl_cache_counts = NULL;
+	}
+}
+
+/*
+ *  fwts_iasl_cache_stats()
+ *	report number of --iasl-cache hits and misses
+ */
+void fwts_iasl_cache_stats(unsigned long *hits, unsigned long *misses)
+{
+	*hits = iasl_cache_counts ? iasl_cache_counts->hits : 0;
+	*misses = iasl_cache_counts ? iasl_cache_counts->misses : 0;
+}
+
+/*
+ *  fwts_iasl_cache_add_table()
+ *	add a table to the cache key digest
+ */
+static void fwts_iasl_cache_add_table(
+	fwts_sha256 *ctx,
+	const fwts_acpi_table_info *info)
+{
+	char buf[64];
+
+	snprintf(buf, sizeof(buf), "%4.4s %zu\n", info->name, info->length);
+	fwts_sha256_update(ctx, buf, strlen(buf));
+	fwts_sha256_update(ctx, info->data, info->length);
+}
+
+/*
+ *  fwts_iasl_cache_key()
+ *	fill key with the cache file name for running op on a table,
+ *	this is a digest of the ACPICA version, the operation, the table
+ *	and any external DSDT and SSDT tables iasl is given. Returns
+ *	false if results are not cached.
+ */
+static bool fwts_iasl_cache_key(fwts_framework *fw,
+	const fwts_acpi_table_info *info,
+	const char *op,
+	const bool use_externals,
+	char *key,
+	const size_t key_len)
+{
+	uint8_t digest[FWTS_SHA256_DIGEST_SIZE];
+	fwts_sha256 ctx;
+	char buf[64];
+	size_t n;
+	int i;
+
+	if (!fw->iasl_cache_path || !iasl_cache_counts)
+		return false;
+
+	fwts_sha256_init(&ctx);
+	snprintf(buf, sizeof(buf), "fwts iasl %d %" PRIx32 " %s %d\n",
+		FWTS_IASL_CACHE_FORMAT, (uint32_t)ACPI_CA_VERSION, op, use_externals);
+	fwts_sha256_update(&ctx, buf, strlen(buf));
+	fwts_iasl_cache_add_table(&ctx, info);
+
+	/* The same external tables that fwts_iasl_disassemble_aml() loads */
+	for (i = 0; use_externals && (i < cached_max); i++) {
+		fwts_acpi_table_info *table;
+
+		if (((uint32_t)i == info->index) ||
+		    (iasl_cached_table_filename[i] == NULL) ||
+		    (iasl_cached_table_name[i] == NULL) ||
+		    (strcmp(iasl_cached_table_name[i], "SSDT") &&
+		     strcmp(iasl_cached_table_name[i], "DSDT")))
+			continue;
+		if ((fwts_acpi_get_table(fw, i, &table) != FWTS_OK) || (table == NULL))
+			return false;
+		fwts_iasl_cache_add_table(&ctx, table);
+	}
+	fwts_sha256_final(&ctx, digest);
+
+	n = snprintf(key, key_len, "%s/", fw->iasl_cache_path);
+	for (i = 0; (i < FWTS_SHA256_DIGEST_SIZE) && (n + 3 <= key_len); i++)
+		n += snprintf(key + n, key_len - n, "%2.2x", digest[i]);
+
+	return i == FWTS_SHA256_DIGEST_SIZE;
+}
+
+/*
+ *  fwts_iasl_cache_get()
+ *	look up the results cached in file key, returns FWTS_OK on a hit
+ */
+static int fwts_iasl_cache_get(
+	const char *key,
+	fwts_list **iasl_disassembly,
+	fwts_list **iasl_stdout,
+	fwts_list **iasl_stderr)
+{
+	uint32_t format;
+	int fd, ret = FWTS_ERROR;
+
+	*iasl_disassembly = NULL;
+	*iasl_stdout = NULL;
+	*iasl_stderr = NULL;
+
+	if ((fd = open(key, O_RDONLY)) >= 0) {
+		if ((read(fd, &format, sizeof(format)) == sizeof(format)) &&
+		    (format == FWTS_IASL_CACHE_FORMAT) &&
+		    (fwts_iasl_read_list(fd, iasl_disassembly) == FWTS_OK) &&
+		    (fwts_iasl_read_list(fd, iasl_stdout) == FWTS_OK) &&
+		    (fwts_iasl_read_list(fd, iasl_stderr) == FWTS_OK) &&
+		    (*iasl_disassembly != NULL))
+			ret = FWTS_OK;
+		(void)close(fd);
+	}
+
+	if (ret != FWTS_OK) {
+		fwts_text_list_free(*iasl_disassembly);
+		fwts_text_list_free(*iasl_stdout);
+		fwts_text_list_free(*iasl_stderr);
+		*iasl_disassembly = NULL;
+		*iasl_stdout = NULL;
+		*iasl_stderr = NULL;
+		__sync_fetch_and_add(&iasl_cache_counts->misses, 1);
+	} else {
+		__sync_fetch_and_add(&iasl_cache_counts->hits, 1);
+	}
+
+	return ret;
+}
+
+/*
+ *  fwts_iasl_cache_put()
+ *	cache results in file key, the entry is written to a temporary
+ *	file and renamed so concurrent runs never see a partial entry
+ */
+static void fwts_iasl_cache_put(
+	const char *key,
+	fwts_list *iasl_disassembly,
+	fwts_list *iasl_stdout,
+	fwts_list *iasl_stderr)
+{
+	const uint32_t format = FWTS_IASL_CACHE_FORMAT;
+	char tmpfile[PATH_MAX];
+	bool ok;
+	int fd;
+
+	if (iasl_disassembly == NULL)
+		return;
+
+	snprintf(tmpfile, sizeof(tmpfile), "%s.%d.tmp", key, getpid());
+	if ((fd = open(tmpfile, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) < 0)
+		return;
+
+	ok = (write(fd, &format, sizeof(format)) == sizeof(format)) &&
+	     (fwts_iasl_write_list(fd, iasl_disassembly) == FWTS_OK) &&
+	     (fwts_iasl_write_list(fd, iasl_stdout) == FWTS_OK) &&
+	     (fwts_iasl_write_list(fd, iasl_stderr) == FWTS_OK);
+	if ((close(fd) < 0) || !ok || (rename(tmpfile, key) < 0))
+		(void)unlink(tmpfile);
+}
+
 /*
  *  fwts_iasl_dump_aml_to_file()
  *	write AML data of given length to file amlfile.
@@ -68,12 +355,39 @@ static int fwts_iasl_dump_aml_to_file(
 	return FWTS_OK;
 }
 
+/*
+ *  fwts_iasl_dump_aml_to_memfd()
+ *	write AML data of given length to an anonymous memory
+ *	backed file, return the file descriptor or -1 on failure.
+ *	iasl can open it by name as /proc/self/fd/N, this also
+ *	works in the forked iasl children as they inherit it.
+ */
+static int fwts_iasl_dump_aml_to_memfd(
+	const uint8_t *data,
+	const int length,
+	const char *name)
+{
+	int fd;
+
+	if ((fd = memfd_create(name, MFD_CLOEXEC)) < 0)
+		return -1;
+
+	if (write(fd, data, length) != length) {
+		(void)close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
 /*
  *  fwts_iasl_cache_tables_to_file()
  *	to disassemble an APCPI table we need to dump it
  *	to file. To save effort in saving these to file
  *	multiple times, we dump out all the tables and
- *	cache the references to these.
+ *	cache the references to these. Tables are kept in
+ *	memory backed files where possible and only fall
+ *	back to files in /tmp if these are not available.
  */
 static int fwts_iasl_cache_tables_to_file(fwts_framework *fw)
 {
@@ -81,23 +395,58 @@ static int fwts_iasl_cache_tables_to_file(fwts_framework *fw)
 	char tmpname[PATH_MAX];
 	fwts_acpi_table_info *table;
 
-	for (cached_max = 0; cached_max < ACPI_MAX_TABLES; cached_max++) {
+	for (cached_max = 0; ; cached_max++) {
 		int ret = fwts_acpi_get_table(fw, cached_max, &table);
 		if (ret != FWTS_OK)
 			return ret;
 		if (table == NULL)
-			continue;
+			break;
 
-		snprintf(tmpname, sizeof(tmpname),
-			"/tmp/fwts_tmp_table_%d_%s_%d.dsl",
-			pid, table->name, cached_max);
+		if (cached_max >= cached_size) {
+			int size = cached_size ? cached_size * 2 : 64;
+			char **filenames, **names;
+			int *fds;
+
+			filenames = realloc(iasl_cached_table_filename, size * sizeof(*filenames));
+			if (filenames == NULL) {
+				fwts_log_error(fw, "Cannot allocate cached table file names.");
+				return FWTS_ERROR;
+			}
+			iasl_cached_table_filename = filenames;
+			names = realloc(iasl_cached_table_name, size * sizeof(*names));
+			if (names == NULL) {
+				fwts_log_error(fw, "Cannot allocate cached table names.");
+				return FWTS_ERROR;
+			}
+			iasl_cached_table_name = names;
+			fds = realloc(iasl_cached_table_fd, size * sizeof(*fds));
+			if (fds == NULL) {
+				fwts_log_error(fw, "Cannot allocate cached table file descriptors.");
+				return FWTS_ERROR;
+			}
+			iasl_cached_table_fd = fds;
+			cached_size = size;
+		}
+
+		iasl_cached_table_fd[cached_max] =
+			fwts_iasl_dump_aml_to_memfd(table->data, table->length, table->name);
+		if (iasl_cached_table_fd[cached_max] >= 0)
+			snprintf(tmpname, sizeof(tmpname), "/proc/self/fd/%d",
+				iasl_cached_table_fd[cached_max]);
+		else
+			snprintf(tmpname, sizeof(tmpname),
+				"/tmp/fwts_tmp_table_%d_%s_%d.dsl",
+				pid, table->name, cached_max);
 		iasl_cached_table_filename[cached_max] = strdup(tmpname);
 		iasl_cached_table_name[cached_max] = table->name;
 		if (iasl_cached_table_filename[cached_max] == NULL) {
 			fwts_log_error(fw, "Cannot allocate cached table file name.");
+			if (iasl_cached_table_fd[cached_max] >= 0)
+				(void)close(iasl_cached_table_fd[cached_max]);
 			return FWTS_ERROR;
 		}
-		if (fwts_iasl_dump_aml_to_file(fw, table->data, table->length, tmpname) != FWTS_OK) {
+		if ((iasl_cached_table_fd[cached_max] < 0) &&
+		    (fwts_iasl_dump_aml_to_file(fw, table->data, table->length, tmpname) != FWTS_OK)) {
 			free(iasl_cached_table_filename[cached_max]);
 			iasl_cached_table_filename[cached_max] = NULL;
 			iasl_cached_table_name[cached_max] = NULL;
@@ -115,14 +464,19 @@ void fwts_iasl_deinit(void)
 	int i;
 
 	for (i = 0; i < cached_max; i++) {
-		if (iasl_cached_table_filename[i]) {
+		if (iasl_cached_table_fd[i] >= 0)
+			(void)close(iasl_cached_table_fd[i]);
+		else if (iasl_cached_table_filename[i])
 			(void)unlink(iasl_cached_table_filename[i]);
-			free(iasl_cached_table_filename[i]);
-		}
-		iasl_cached_table_filename[i] = NULL;
-		iasl_cached_table_name[i] = NULL;
+		free(iasl_cached_table_filename[i]);
 	}
-	memset(iasl_cached_table_filename, 0, sizeof(iasl_cached_table_filename));
+	free(iasl_cached_table_filename);
+	free(iasl_cached_table_name);
+	free(iasl_cached_table_fd);
+	iasl_cached_table_filename = NULL;
+	iasl_cached_table_name = NULL;
+	iasl_cached_table_fd = NULL;
+	cached_size = 0;
 	cached_max = 0;
 }
 
@@ -137,8 +491,6 @@ int fwts_iasl_init(fwts_framework *fw)
 	cached_max = 0;
 	fwts_iasl_deinit();	/* Ensure it is clean */
 
-	memset(iasl_cached_table_filename, 0, sizeof(iasl_cached_table_filename));
-
 	ret = fwts_iasl_cache_tables_to_file(fw);
 	if (ret != FWTS_OK)
 		return ret;
@@ -182,8 +534,10 @@ int fwts_iasl_disassemble(fwts_framework *fw,
 	fwts_list **iasl_output)
 {
 	char tmpfile[PATH_MAX];
+	char key[PATH_MAX];
 	int pid = getpid();
 	int ret;
+	bool cached;
 
 	if (!iasl_init)
 		return FWTS_ERROR;
@@ -192,6 +546,17 @@ int fwts_iasl_disassemble(fwts_framework *fw,
 
 	*iasl_output = NULL;
 
+	cached = fwts_iasl_cache_key(fw, info, "disassemble", use_externals, key, sizeof(key));
+	if (cached) {
+		fwts_list *iasl_stdout, *iasl_stderr;
+
+		if (fwts_iasl_cache_get(key, iasl_output, &iasl_stdout, &iasl_stderr) == FWTS_OK) {
+			fwts_text_list_free(iasl_stdout);
+			fwts_text_list_free(iasl_stderr);
+			return FWTS_OK;
+		}
+	}
+
 	snprintf(tmpfile, sizeof(tmpfile),
 		"/tmp/fwts_iasl_disassemble_%d_%s_%d.dsl",
 		pid, info->name, info->index);
@@ -202,10 +567,44 @@ int fwts_iasl_disassemble(fwts_framework *fw,
 	*iasl_output = fwts_file_open_and_read(tmpfile);
 	(void)unlink(tmpfile);
 
+	if (cached)
+		fwts_iasl_cache_put(key, *iasl_output, NULL, NULL);
+
 	return *iasl_output ? FWTS_OK : FWTS_ERROR;
 }
 
 
+/*
+ *  fwts_iasl_disassemble_all_cached()
+ *	disassemble a table to a file for --disassemble-aml, using
+ *	the same cache entries as fwts_iasl_disassemble()
+ */
+static int fwts_iasl_disassemble_all_cached(
+	fwts_framework *fw,
+	const fwts_acpi_table_info *info,
+	const char *filename)
+{
+	fwts_list *iasl_output;
+	fwts_list_link *item;
+	FILE *fp;
+
+	if (!fw->iasl_cache_path)
+		return fwts_iasl_disassemble_to_file(fw, info, true, filename);
+
+	if (fwts_iasl_disassemble(fw, info, true, &iasl_output) != FWTS_OK)
+		return FWTS_ERROR;
+
+	if ((fp = fopen(filename, "w")) == NULL) {
+		fwts_text_list_free(iasl_output);
+		return FWTS_ERROR;
+	}
+	fwts_list_foreach(item, iasl_output)
+		fprintf(fp, "%s\n", fwts_text_list_text(item));
+	fwts_text_list_free(iasl_output);
+
+	return fclose(fp) ? FWTS_ERROR : FWTS_OK;
+}
+
 /*
  *  fwts_iasl_disassemble_all_to_file()
  * 	Disassemble DSDT and SSDT tables to separate files.
@@ -242,7 +641,7 @@ int fwts_iasl_disassemble_all_to_file(
 		if (info && info->has_aml) {
 			snprintf(filename, sizeof(filename), "%s%s%d.dsl",
 				pathname, info->name, j);
-			if (fwts_iasl_disassemble_to_file(fw, info, true, filename) != FWTS_OK)
+			if (fwts_iasl_disassemble_all_cached(fw, info, filename) != FWTS_OK)
 				fprintf(stderr, "Could not disassemble %s\n", info->name);
 			else
 				printf("Disassembled %s to %s\n", info->name, filename);
@@ -251,6 +650,15 @@ int fwts_iasl_disassemble_all_to_file(
 	}
 	fwts_iasl_deinit();
 
+	/* Don't mix the stats into results written to stdout */
+	if (iasl_cache_counts && fw->results_logname &&
+	    (fwts_log_get_filename_type(fw->results_logname) == LOG_FILENAME_TYPE_FILE))
+		printf("iasl cache: %lu hit%s, %lu miss%s\n",
+			iasl_cache_counts->hits,
+			iasl_cache_counts->hits == 1 ? "" : "s",
+			iasl_cache_counts->misses,
+			iasl_cache_counts->misses == 1 ? "" : "es");
+
 	return FWTS_OK;
 }
 
@@ -267,8 +675,10 @@ int fwts_iasl_reassemble(fwts_framework *fw,
 	fwts_list **iasl_stderr)
 {
 	char tmpfile[PATH_MAX];
+	char key[PATH_MAX];
 	char *stdout_output = NULL, *stderr_output = NULL;
 	int pid = getpid();
+	bool cached;
 
 	if ((!iasl_init) ||
 	    (iasl_disassembly == NULL) ||
@@ -277,6 +687,11 @@ int fwts_iasl_reassemble(fwts_framework *fw,
 	    (info == NULL))
 		return FWTS_ERROR;
 
+	cached = fwts_iasl_cache_key(fw, info, "reassemble", true, key, sizeof(key));
+	if (cached &&
+	    (fwts_iasl_cache_get(key, iasl_disassembly, iasl_stdout, iasl_stderr) == FWTS_OK))
+		return FWTS_OK;
+
 	fwts_acpica_set_fwts_framework(fw);
 	*iasl_disassembly = NULL;
 	snprintf(tmpfile, sizeof(tmpfile), "/tmp/fwts_iasl_reassemble_%d.dsl", pid);
@@ -310,9 +725,156 @@ int fwts_iasl_reassemble(fwts_framework *fw,
 	*iasl_stderr = fwts_list_from_text(stderr_output);
 	free(stdout_output);
 
+	if (cached)
+		fwts_iasl_cache_put(key, *iasl_disassembly, *iasl_stdout, *iasl_stderr);
+
 	return FWTS_OK;
 }
 
+/*
+ *  A table being reassembled in a worker process, the worker
+ *  hands its results back through the memory backed file fd
+ */
+typedef struct {
+	fwts_acpi_table_info *info;	/* table being reassembled */
+	pid_t pid;			/* worker, -1 if reassembled in the parent */
+	int fd;				/* worker results */
+} fwts_iasl_job;
+
+/*
+ *  fwts_iasl_job_start()
+ *	fork a worker to reassemble a table, if a worker cannot be
+ *	started the table is reassembled later by fwts_iasl_job_finish()
+ */
+static void fwts_iasl_job_start(
+	fwts_framework *fw,
+	fwts_iasl_job *job,
+	fwts_acpi_table_info *info)
+{
+	job->info = info;
+	job->pid = -1;
+
+	if ((job->fd = memfd_create("fwts_iasl_job", MFD_CLOEXEC)) < 0)
+		return;
+
+	fflush(stdout);
+	fflush(stderr);
+
+	job->pid = fork();
+	if (job->pid < 0) {
+		(void)close(job->fd);
+		job->fd = -1;
+		return;
+	}
+	if (job->pid == 0) {
+		fwts_list *iasl_disassembly = NULL,
+			  *iasl_stdout = NULL,
+			  *iasl_stderr = NULL;
+		int32_t ret;
+
+		ret = fwts_iasl_reassemble(fw, info,
+			&iasl_disassembly, &iasl_stdout, &iasl_stderr);
+
+		if ((write(job->fd, &ret, sizeof(ret)) != sizeof(ret)) ||
+		    (fwts_iasl_write_list(job->fd, iasl_disassembly) != FWTS_OK) ||
+		    (fwts_iasl_write_list(job->fd, iasl_stdout) != FWTS_OK) ||
+		    (fwts_iasl_write_list(job->fd, iasl_stderr) != FWTS_OK))
+			_exit(EXIT_FAILURE);
+		_exit(EXIT_SUCCESS);
+	}
+}
+
+/*
+ *  fwts_iasl_job_finish()
+ *	wait for a worker to complete and pass its results to func
+ */
+static int fwts_iasl_job_finish(
+	fwts_framework *fw,
+	fwts_iasl_job *job,
+	const int n,
+	fwts_iasl_reassemble_func func)
+{
+	fwts_list *iasl_disassembly = NULL,
+		  *iasl_stdout = NULL,
+		  *iasl_stderr = NULL;
+	int32_t ret = FWTS_ERROR;
+	int status;
+
+	if (job->pid < 0) {
+		ret = fwts_iasl_reassemble(fw, job->info,
+			&iasl_disassembly, &iasl_stdout, &iasl_stderr);
+	} else if ((waitpid(job->pid, &status, 0) == job->pid) &&
+		   WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_SUCCESS) &&
+		   (lseek(job->fd, 0, SEEK_SET) == 0) &&
+		   (read(job->fd, &ret, sizeof(ret)) == sizeof(ret))) {
+		if ((fwts_iasl_read_list(job->fd, &iasl_disassembly) != FWTS_OK) ||
+		    (fwts_iasl_read_list(job->fd, &iasl_stdout) != FWTS_OK) ||
+		    (fwts_iasl_read_list(job->fd, &iasl_stderr) != FWTS_OK))
+			ret = FWTS_ERROR;
+	}
+	if (job->fd >= 0)
+		(void)close(job->fd);
+
+	ret = func(fw, job->info, n, ret,
+		iasl_disassembly, iasl_stdout, iasl_stderr);
+
+	fwts_text_list_free(iasl_disassembly);
+	fwts_text_list_free(iasl_stdout);
+	fwts_text_list_free(iasl_stderr);
+
+	return ret;
+}
+
+/*
+ *  fwts_iasl_reassemble_tables()
+ *	reassemble count tables, running up to --jobs (default one per
+ *	CPU) reassemblies at once in worker processes. func is called
+ *	with the results of each table in the order of tables[]
+ */
+int fwts_iasl_reassemble_tables(fwts_framework *fw,
+	fwts_acpi_table_info *tables[],
+	const int count,
+	fwts_iasl_reassemble_func func)
+{
+	fwts_iasl_job *jobs;
+	int max_jobs, started, finished, ret = FWTS_OK;
+
+	if ((!iasl_init) || (tables == NULL) || (func == NULL))
+		return FWTS_ERROR;
+	if (count < 1)
+		return FWTS_OK;
+
+	max_jobs = fw->jobs ? (int)fw->jobs : fwts_cpu_enumerate();
+	if (max_jobs < 1)
+		max_jobs = 1;
+	if (max_jobs > count)
+		max_jobs = count;
+
+	if ((jobs = calloc(max_jobs, sizeof(*jobs))) == NULL)
+		return FWTS_ERROR;
+
+	for (started = 0, finished = 0; finished < count; finished++) {
+		/* Keep the workers busy, then collect the oldest */
+		for (; (started < count) && (started - finished < max_jobs); started++) {
+			fwts_iasl_job *job = &jobs[started % max_jobs];
+
+			if (max_jobs > 1) {
+				fwts_iasl_job_start(fw, job, tables[started]);
+			} else {
+				job->info = tables[started];
+				job->pid = -1;
+				job->fd = -1;
+			}
+		}
+
+		if (fwts_iasl_job_finish(fw, &jobs[finished % max_jobs], finished, func) != FWTS_OK)
+			ret = FWTS_ERROR;
+	}
+	free(jobs);
+
+	return ret;
+}
+
 const char *fwts_iasl_exception_level(uint8_t level)
 {
 	return fwts_iasl_exception_level__(level);
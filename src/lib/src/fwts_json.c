@@ -25,21 +25,63 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "fwts.h"
 
+/*
+ *  Parsed objects, keys and strings are allocated from an
+ *  arena of blocks that is freed in one go when the root
+ *  object of the parsed tree is put.
+ */
+#define JSON_ARENA_BLOCK_SIZE	(64 * 1024)
+#define JSON_ARENA_ALIGN	(sizeof(max_align_t))
+
+typedef struct json_arena_block {
+	struct json_arena_block *next;	/* next block in arena */
+	size_t size;			/* usable bytes in block */
+	size_t used;			/* bytes allocated from block */
+	max_align_t data[];		/* block memory */
+} json_arena_block;
+
+typedef struct json_arena_index {
+	struct json_arena_index *next;	/* next key index */
+	fwts_hash *index;		/* key index of a parsed object */
+} json_arena_index;
+
+struct json_arena {
+	json_arena_block *blocks;	/* most recently allocated block first */
+	json_arena_index *indexes;	/* key indexes built on parsed objects */
+	json_object *root;		/* root object of the parsed tree */
+};
+
+/*
+ *  Objects with at least this many keys get a key index
+ *  the first time a key is looked up
+ */
+#define JSON_INDEX_THRESHOLD	(16)
+
 /*
  *  json file information
  */
 typedef struct {
-	FILE *fp;		/* File pointer */
 	const char *filename;	/* Name of file */
+	const char *buf;	/* mmap'd or read in file contents */
+	size_t len;		/* Length of file contents */
+	size_t pos;		/* Parser position in buf */
 	int linenum;		/* Parser line number */
 	int charnum;		/* Parser char position */
 	int error_reported;	/* Error count */
+	json_arena *arena;	/* Arena parsed objects are allocated from */
+	json_object **stack;	/* Items of arrays and objects being parsed */
+	size_t stack_len;	/* Number of items on stack */
+	size_t stack_size;	/* Allocated size of stack */
 } json_file;
 
 /*
@@ -67,18 +109,102 @@ typedef enum {
  */
 typedef struct {
 	json_token_type type;	/* token type */
-	long offset;		/* offset in file for re-winding */
 	union {
-		char *str;	/* token string value */
+		char *str;	/* token string value, allocated in the arena */
 		int  intval;	/* token integer value */
 	} u;
 } json_token;
 
+/*
+ *  json parser state, one token of lookahead is used
+ *  rather than rewinding the input
+ */
+typedef struct {
+	json_file *jfile;	/* input */
+	json_token lookahead;	/* token pushed back by json_unget_token() */
+	bool have_lookahead;	/* true if lookahead is valid */
+} json_parser;
+
+/*
+ *  json_arena_new()
+ *	allocate an empty arena
+ */
+static json_arena *json_arena_new(void)
+{
+	return calloc(1, sizeof(json_arena));
+}
+
+/*
+ *  json_arena_free()
+ *	free an arena and all the memory allocated from it
+ */
+static void json_arena_free(json_arena *arena)
+{
+	json_arena_block *block, *next;
+	json_arena_index *index;
+
+	if (!arena)
+		return;
+
+	/* The index list itself is allocated from the arena */
+	for (index = arena->indexes; index; index = index->next)
+		fwts_hash_free(index->index, NULL);
+
+	for (block = arena->blocks; block; block = next) {
+		next = block->next;
+		free(block);
+	}
+	free(arena);
+}
+
+/*
+ *  json_arena_alloc()
+ *	allocate zeroed memory from an arena, NULL if out of memory
+ */
+static void *json_arena_alloc(json_arena *arena, size_t size)
+{
+	json_arena_block *block = arena->blocks;
+	void *ptr;
+
+	size = (size + JSON_ARENA_ALIGN - 1) & ~(JSON_ARENA_ALIGN - 1);
+
+	if (!block || (block->size - block->used < size)) {
+		const size_t block_size = size > JSON_ARENA_BLOCK_SIZE ?
+			size : JSON_ARENA_BLOCK_SIZE;
+
+		block = calloc(1, sizeof(*block) + block_size);
+		if (!block)
+			return NULL;
+		block->size = block_size;
+		block->next = arena->blocks;
+		arena->blocks = block;
+	}
+	ptr = (char *)block->data + block->used;
+	block->used += size;
+
+	return ptr;
+}
+
+/*
+ *  json_arena_strdup()
+ *	duplicate a string into an arena
+ */
+static char *json_arena_strdup(json_arena *arena, const char *str)
+{
+	const size_t len = strlen(str) + 1;
+	char *new_str;
+
+	new_str = json_arena_alloc(arena, len);
+	if (new_str)
+		memcpy(new_str, str, len);
+	return new_str;
+}
+
 /*
  *  json_token_string()
  *	convert json token to a human readable string
  */
-char *json_token_string(json_token *jtoken)
+static char *json_token_string(json_token *jtoken)
 {
 	static char tmp[64];
 
@@ -110,20 +236,52 @@ char *json_token_string(json_token *jtoken)
 	return "<illegal token>";
 }
 
+/*
+ *  json_getc()
+ *	get next input character, EOF at end of input
+ */
+static inline int json_getc(json_file *jfile)
+{
+	if (jfile->pos >= jfile->len)
+		return EOF;
+	jfile->charnum++;
+	return (unsigned char)jfile->buf[jfile->pos++];
+}
+
 /*
  *  json_get_string()
- *	parse a literal string
+ *	parse a literal string, the opening quote has already
+ *	been consumed
  */
-json_token_type json_get_string(json_file *jfile, json_token *token)
+static json_token_type json_get_string(json_file *jfile, json_token *token)
 {
-	char buffer[4096];
+	const char *end;
+	char *str;
 	size_t i = 0;
 
+	/*
+	 *  The unescaped string is never longer than the raw input
+	 *  up to the closing quote, so find that to size the string
+	 */
+	for (end = jfile->buf + jfile->pos; end < jfile->buf + jfile->len; end++) {
+		if (*end == '"')
+			break;
+		if ((*end == '\\') && (end + 1 < jfile->buf + jfile->len))
+			end++;
+	}
+
+	str = json_arena_alloc(jfile->arena, (end - (jfile->buf + jfile->pos)) + 1);
+	if (!str) {
+		fprintf(stderr, "json parser: out of memory allocating %zd byte string\n",
+			end - (jfile->buf + jfile->pos));
+		token->u.str = NULL;
+		return token_error;
+	}
+
 	for (;;) {
 		int ch;
 
-		ch = fgetc(jfile->fp);
-		jfile->charnum++;
+		ch = json_getc(jfile);
 		if (ch == EOF) {
 			fprintf(stderr, "json_parser: unexpected EOF in literal string\n");
 			token->u.str = NULL;
@@ -131,7 +289,7 @@ json_token_type json_get_string(json_file *jfile, json_token *token)
 		}
 
 		if (ch == '\\') {
-			ch = fgetc(jfile->fp);
+			ch = json_getc(jfile);
 			switch (ch) {
 			case '\\':
 			case '"':
@@ -156,137 +314,63 @@ json_token_type json_get_string(json_file *jfile, json_token *token)
 				fprintf(stderr, "json parser: escaped hex values not supported\n");
 				ch = '?';
 				break;
+			case EOF:
+				fprintf(stderr, "json_parser: unexpected EOF in literal string\n");
+				token->u.str = NULL;
+				return token_error;
 			}
-			jfile->charnum++;
 		} else if (ch == '"') {
-			buffer[i] = '\0';
-			token->u.str = strdup(buffer);
-			if (!token->u.str) {
-				fprintf(stderr, "json parser: out of memory allocating %zd byte string\n", i);
-				break;
-			}
+			str[i] = '\0';
+			token->u.str = str;
 			return token_string;
 		}
-		buffer[i] = ch;
-		i++;
-		if (i >= sizeof(buffer)) {
-			fprintf(stderr, "json parser: string too long, maximum size %zd bytes\n", sizeof(buffer) - 1);
-			break;
-		}
+		str[i++] = ch;
 	}
-
-	token->u.str = NULL;
-	return token_error;
 }
 
 /*
  *  json_get_int()
  *	parse a simple integer
  */
-json_token_type json_get_int(json_file *jfile, json_token *token)
+static json_token_type json_get_int(json_file *jfile, json_token *token)
 {
-	char buffer[64];
+	long val = 0;
 	size_t i = 0;
 
-	for (;;) {
-		int ch;
-
-		ch = fgetc(jfile->fp);
-		if (!isdigit(ch)) {
-			(void)ungetc(ch, jfile->fp);
-			buffer[i] = '\0';
-			token->u.intval = atoi(buffer);
-			return token_int;
-		}
+	while ((jfile->pos < jfile->len) && isdigit((unsigned char)jfile->buf[jfile->pos])) {
+		val = (val * 10) + (jfile->buf[jfile->pos] - '0');
+		jfile->pos++;
 		jfile->charnum++;
-		buffer[i] = ch;
-		i++;
-		if (i >= sizeof(buffer)) {
-			fprintf(stderr, "json parser: integer too long, maximum size %zd bytes\n", sizeof(buffer) - 1);
-			break;
-		}
-	}
-
-	token->u.str = NULL;
-	return token_error;
-}
-
-/*
- *  json_unget_token()
- *  	push file pointer back to point before the token
- *	to unpush the token
- */
-int json_unget_token(json_file *jfile, json_token *token)
-{
-	return fseek(jfile->fp, token->offset, SEEK_SET);
-}
-
-/*
- *  json_get_keyword()
- *	get a keyword
- */
-int json_get_keyword(json_file *jfile, json_token *token)
-{
-	char buffer[32];
-	size_t i = 0;
-
-	token->u.str = NULL;
-	*buffer = '\0';
-
-	for (;;) {
-		int ch;
-
-		ch = fgetc(jfile->fp);
-		jfile->charnum++;
-		if (ch == EOF) {
-			fprintf(stderr, "json_parser: unexpected EOF in keyword string\n");
-			return token_error;
-		}
-		if (ch < 'a' || ch > 'z')
-			break;
-
-		buffer[i] = ch;
-		i++;
-		if (i >= sizeof(buffer)) {
-			fprintf(stderr, "json parser: keyword too long, maximum size %zd bytes\n", sizeof(buffer) - 1);
+		if (++i >= 64) {
+			fprintf(stderr, "json parser: integer too long, maximum size %zd bytes\n", i - 1);
+			token->u.str = NULL;
 			return token_error;
 		}
 	}
-	if (!strcmp(buffer, "true"))
-		return token_true;
-	if (!strcmp(buffer, "false"))
-		return token_false;
-	if (!strcmp(buffer, "null"))
-		return token_null;
-	return token_error;
-}
-
-/*
- *  json_free_token()
- *	free any heap allocated members in token when required
- */
-void json_free_token(json_token *token)
-{
-	if (token->type == token_string) {
-		free(token->u.str);
-		token->u.str = NULL;
-	}
+	token->u.intval = (int)val;
+	return token_int;
 }
 
 /*
  *  json_get_token()
  *	read next input character(s) and return a matching token
  */
-json_token_type json_get_token(json_file *jfile, json_token *token)
+static json_token_type json_get_token(json_parser *parser, json_token *token)
 {
+	json_file *jfile = parser->jfile;
+
+	if (parser->have_lookahead) {
+		*token = parser->lookahead;
+		parser->have_lookahead = false;
+		return token->type;
+	}
+
 	(void)memset(token, 0, sizeof(*token));
 
-	token->offset = ftell(jfile->fp);
 	for (;;) {
 		int ch;
 
-		ch = fgetc(jfile->fp);
-		jfile->charnum++;
+		ch = json_getc(jfile);
 
 		switch (ch) {
 		case '\n':
@@ -321,6 +405,9 @@ json_token_type json_get_token(json_file *jfile, json_token *token)
 			token->type = json_get_string(jfile, token);
 			return token->type;
 		case '0'...'9':
+			/* Push back the first digit */
+			jfile->pos--;
+			jfile->charnum--;
 			token->type = json_get_int(jfile, token);
 			return token->type;
 		case 'a'...'z':
@@ -332,10 +419,16 @@ json_token_type json_get_token(json_file *jfile, json_token *token)
 			return token->type;
 		}
 	}
+}
 
-	/* Should never reach here */
-	token->type = token_error;
-	return token->type;
+/*
+ *  json_unget_token()
+ *	push a token back so the next json_get_token() returns it
+ */
+static void json_unget_token(json_parser *parser, json_token *token)
+{
+	parser->lookahead = *token;
+	parser->have_lookahead = true;
 }
 
 /*
@@ -343,7 +436,7 @@ json_token_type json_get_token(json_file *jfile, json_token *token)
  *	very simple parser error message, report where in the file
  *	the parsing error occurred.
  */
-void json_parse_error_where(json_file *jfile)
+static void json_parse_error_where(json_file *jfile)
 {
 	if (jfile->error_reported == 0)
 		fprintf(stderr, "json_parser: aborted at line %d, char %d of file %s\n",
@@ -351,17 +444,79 @@ void json_parse_error_where(json_file *jfile)
 	jfile->error_reported++;
 }
 
-json_object *json_parse_object(json_file *jfile);
+/*
+ *  json_parse_push()
+ *	push an array or object item on the parser stack, the
+ *	stack grows geometrically. Returns -1 if out of memory.
+ */
+static int json_parse_push(json_file *jfile, json_object *obj)
+{
+	if (jfile->stack_len >= jfile->stack_size) {
+		const size_t size = jfile->stack_size ? jfile->stack_size * 2 : 256;
+		json_object **stack;
+
+		stack = realloc(jfile->stack, size * sizeof(*stack));
+		if (!stack)
+			return -1;
+		jfile->stack = stack;
+		jfile->stack_size = size;
+	}
+	jfile->stack[jfile->stack_len++] = obj;
+	return 0;
+}
+
+/*
+ *  json_parse_pop()
+ *	move the items pushed since base into obj, the items
+ *	array is allocated from the arena at its final size
+ */
+static int json_parse_pop(json_file *jfile, json_object *obj, const size_t base)
+{
+	const size_t n = jfile->stack_len - base;
+	json_object **items = NULL;
+
+	if (n) {
+		items = json_arena_alloc(jfile->arena, n * sizeof(*items));
+		if (!items)
+			return -1;
+		memcpy(items, jfile->stack + base, n * sizeof(*items));
+	}
+	obj->u.ptr = items;
+	obj->length = (int)n;
+	obj->size = (int)n;
+	jfile->stack_len = base;
+	return 0;
+}
+
+/*
+ *  json_parse_new()
+ *	allocate a new json object of a given type from the arena
+ */
+static json_object *json_parse_new(json_file *jfile, const json_type type)
+{
+	json_object *obj;
+
+	obj = json_arena_alloc(jfile->arena, sizeof(*obj));
+	if (!obj)
+		return NULL;
+	obj->type = type;
+	obj->arena = jfile->arena;
+	return obj;
+}
+
+static json_object *json_parse_object(json_parser *parser);
 
 /*
  *  json_parse_array()
  *	parse a json array
  */
-json_object *json_parse_array(json_file *jfile)
+static json_object *json_parse_array(json_parser *parser)
 {
+	json_file *jfile = parser->jfile;
+	const size_t base = jfile->stack_len;
 	json_object *array_obj;
 
-	array_obj = json_object_new_array();
+	array_obj = json_parse_new(jfile, type_array);
 	if (!array_obj) {
 		fprintf(stderr, "json_parser: out of memory allocating a json array object\n");
 		json_parse_error_where(jfile);
@@ -372,140 +527,121 @@ json_object *json_parse_array(json_file *jfile)
 		json_object *obj;
 		json_token token;
 
-		obj = json_parse_object(jfile);
+		obj = json_parse_object(parser);
 		if (!obj) {
 			json_parse_error_where(jfile);
-			json_object_put(array_obj);
 			return NULL;
 		}
-		if (json_object_array_add(array_obj, obj) < 0) {
-			json_object_put(array_obj);
-			json_object_put(obj);
+		if (json_parse_push(jfile, obj) < 0)
 			return NULL;
-		}
 
-		switch (json_get_token(jfile, &token)) {
+		switch (json_get_token(parser, &token)) {
 		case token_rbracket:
+			if (json_parse_pop(jfile, array_obj, base) < 0)
+				return NULL;
 			return array_obj;
 		case token_comma:
 			continue;
 		default:
-			if (json_unget_token(jfile, &token) != 0) {
-				fprintf(stderr, "json_parser: failed to unget a token\n");
-				json_object_put(array_obj);
-				json_free_token(&token);
-				return NULL;
-			}
-			json_free_token(&token);
+			json_unget_token(parser, &token);
 			break;
 		}
 	}
-	return array_obj;
 }
 
 /*
  *  json_parse_object()
  *	parse a json object (simplified fwts json format only)
  */
-json_object *json_parse_object(json_file *jfile)
+static json_object *json_parse_object(json_parser *parser)
 {
+	json_file *jfile = parser->jfile;
+	const size_t base = jfile->stack_len;
 	json_token token;
 	json_object *obj, *val_obj;
 
-	if (json_get_token(jfile, &token) != token_lbrace) {
+	if (json_get_token(parser, &token) != token_lbrace) {
 		fprintf(stderr, "json_parser: expecting '{', got %s instead\n", json_token_string(&token));
-		json_free_token(&token);
 		return NULL;
 	}
 
-	obj = json_object_new_object();
+	obj = json_parse_new(jfile, type_object);
 	if (!obj)
 		goto err_nomem;
 
 	for (;;) {
 		char *key = NULL;
 
-		switch (json_get_token(jfile, &token)) {
+		switch (json_get_token(parser, &token)) {
 		case token_rbrace:
-			json_free_token(&token);
-			return obj;
+			goto done;
 		case token_string:
-			key = strdup(token.u.str);
-			if (!key)
-				goto err_nomem;
-			json_free_token(&token);
+			key = token.u.str;
 			break;
 		default:
 			fprintf(stderr, "json_parser: expecting } or key literal string, got %s instead\n", json_token_string(&token));
-			goto err_free;
+			return NULL;
 		}
 
-		json_free_token(&token);
-		if (json_get_token(jfile, &token) != token_colon) {
+		if (json_get_token(parser, &token) != token_colon) {
 			fprintf(stderr, "json_parser: expecting ':', got %s instead\n", json_token_string(&token));
-			free(key);
-			goto err_free;
+			return NULL;
 		}
-		switch (json_get_token(jfile, &token)) {
+		val_obj = NULL;
+		switch (json_get_token(parser, &token)) {
 		case token_string:
-			val_obj = json_object_new_string(token.u.str);
-			if (!val_obj) {
-				free(key);
+			val_obj = json_parse_new(jfile, type_string);
+			if (!val_obj)
 				goto err_nomem;
-			}
-			json_object_object_add(obj, key, val_obj);
+			val_obj->u.ptr = token.u.str;
 			break;
 		case token_int:
-			val_obj = json_object_new_int(token.u.intval);
-			if (!val_obj) {
-				free(key);
+			val_obj = json_parse_new(jfile, type_int);
+			if (!val_obj)
 				goto err_nomem;
-			}
-			json_object_object_add(obj, key, val_obj);
+			val_obj->u.intval = token.u.intval;
 			break;
 		case token_lbracket:
-			val_obj = json_parse_array(jfile);
-			if (!val_obj) {
-				free(key);
+			val_obj = json_parse_array(parser);
+			if (!val_obj)
 				goto err_nomem;
-			}
-			json_object_object_add(obj, key, val_obj);
 			break;
 		case token_lbrace:
 			fprintf(stderr, "json_parser: nested objects not supported\n");
-			free(key);
-			goto err_free;
+			return NULL;
 		case token_true:
 		case token_false:
 		case token_null:
 			fprintf(stderr, "json_parser: tokens %s not supported\n", json_token_string(&token));
-			free(key);
-			goto err_free;
+			return NULL;
 		default:
 			fprintf(stderr, "json_parser: unexpected token %s\n", json_token_string(&token));
 		}
-		free(key);
+		if (val_obj) {
+			val_obj->key = key;
+			if (json_parse_push(jfile, val_obj) < 0)
+				goto err_nomem;
+		}
 
-		json_free_token(&token);
-		switch (json_get_token(jfile, &token)) {
+		switch (json_get_token(parser, &token)) {
 		case token_comma:
-			json_free_token(&token);
 			continue;
 		case token_rbrace:
-			json_free_token(&token);
-			return obj;
+			goto done;
 		default:
 			fprintf(stderr, "json_parser: expected , or }, got %s instead\n", json_token_string(&token));
-			goto err_free;
+			return NULL;
 		}
 	}
 
+done:
+	if (json_parse_pop(jfile, obj, base) < 0)
+		goto err_nomem;
+	return obj;
+
 err_nomem:
 	fprintf(stderr, "json_parser: out of memory allocating a json object\n");
 	json_parse_error_where(jfile);
-err_free:
-	free(obj);
-	json_free_token(&token);
 	return NULL;
 }
 
@@ -513,25 +649,81 @@ err_free:
  *  json_object_from_file()
  *	parse a simplified fwts json file and convert it into
  *	a json object, return NULL if parsing failed or ran
- *	out of memory
+ *	out of memory. The file is mmap'd and parsed in place,
+ *	the parsed tree is allocated from one arena and must be
+ *	freed by calling json_object_put() on the returned object.
  */
 json_object *json_object_from_file(const char *filename)
 {
-	json_object *obj;
+	json_object *obj = NULL;
+	json_parser parser;
 	json_file jfile;
+	struct stat buf;
+	void *mem = MAP_FAILED;
+	char *data = NULL;
+	int fd;
 
+	(void)memset(&jfile, 0, sizeof(jfile));
 	jfile.filename = filename;
 	jfile.linenum = 1;
-	jfile.charnum = 0;
-	jfile.error_reported = 0;
 
-	jfile.fp = fopen(filename, "r");
-	if (!jfile.fp)
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &buf) < 0) {
+		(void)close(fd);
 		return NULL;
+	}
 
-	obj = json_parse_object(&jfile);
+	if (buf.st_size > 0)
+		mem = mmap(NULL, (size_t)buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mem != MAP_FAILED) {
+		jfile.buf = mem;
+		jfile.len = (size_t)buf.st_size;
+	} else {
+		/* Can't mmap, e.g. not a regular file, so read it in blocks */
+		size_t size = 0;
+		ssize_t n;
+
+		for (;;) {
+			if (jfile.len == size) {
+				char *tmp;
+
+				size = size ? size * 2 : 65536;
+				tmp = realloc(data, size);
+				if (!tmp)
+					goto out;
+				data = tmp;
+			}
+			n = read(fd, data + jfile.len, size - jfile.len);
+			if (n < 0)
+				goto out;
+			if (n == 0)
+				break;
+			jfile.len += (size_t)n;
+		}
+		jfile.buf = data;
+	}
+
+	jfile.arena = json_arena_new();
+	if (!jfile.arena)
+		goto out;
+
+	parser.jfile = &jfile;
+	parser.have_lookahead = false;
+
+	obj = json_parse_object(&parser);
+	if (obj)
+		jfile.arena->root = obj;
+	else
+		json_arena_free(jfile.arena);
+out:
+	free(jfile.stack);
+	if (mem != MAP_FAILED)
+		(void)munmap(mem, (size_t)buf.st_size);
+	free(data);
+	(void)close(fd);
 
-	fclose(jfile.fp);
 	return obj;
 }
 
@@ -623,7 +815,9 @@ json_object *json_object_new_array(void)
 /*
  *  json_object_array_add_item()
  *	add an object to another object, return 0 if succeeded,
- *	non-zero if failed
+ *	non-zero if failed. Objects in a parsed tree are arena
+ *	allocated, so parsed and heap allocated objects can't be
+ *	mixed.
  */
 static int json_object_array_add_item(json_object *obj, json_object *item)
 {
@@ -631,10 +825,27 @@ static int json_object_array_add_item(json_object *obj, json_object *item)
 
 	if (obj->length < 0)
 		return -1;
-	obj_ptr = realloc(obj->u.ptr, sizeof(json_object *) * (obj->length + 1));
-	if (!obj_ptr)
+	if (obj->arena != item->arena)
 		return -1;
-	obj->u.ptr = (void *)obj_ptr;
+
+	if (obj->length >= obj->size) {
+		const int size = obj->size ? obj->size * 2 : 8;
+
+		if (obj->arena) {
+			obj_ptr = json_arena_alloc(obj->arena, sizeof(json_object *) * size);
+			if (!obj_ptr)
+				return -1;
+			if (obj->length)
+				memcpy(obj_ptr, obj->u.ptr, sizeof(json_object *) * obj->length);
+		} else {
+			obj_ptr = realloc(obj->u.ptr, sizeof(json_object *) * size);
+			if (!obj_ptr)
+				return -1;
+		}
+		obj->u.ptr = (void *)obj_ptr;
+		obj->size = size;
+	}
+	obj_ptr = (json_object **)obj->u.ptr;
 	obj_ptr[obj->length] = item;
 	obj->length++;
 	return 0;
@@ -654,6 +865,57 @@ int json_object_array_add(json_object *obj, json_object *item)
 }
 
 
+/*
+ *  json_object_index_free()
+ *	free the key index of a heap allocated object, indexes
+ *	of parsed objects are freed along with their arena
+ */
+static void json_object_index_free(json_object *obj)
+{
+	if (!obj->arena)
+		fwts_hash_free(obj->index, NULL);
+	obj->index = NULL;
+}
+
+/*
+ *  json_object_index()
+ *	build a key index of an object, the first of any duplicate
+ *	keys is indexed to match a linear search. Returns NULL if the
+ *	index can't be built.
+ */
+static fwts_hash *json_object_index(json_object *obj)
+{
+	json_object **obj_ptr = (json_object **)obj->u.ptr;
+	json_arena_index *arena_index = NULL;
+	fwts_hash *index;
+	int i;
+
+	if (obj->arena) {
+		arena_index = json_arena_alloc(obj->arena, sizeof(*arena_index));
+		if (!arena_index)
+			return NULL;
+	}
+	index = fwts_hash_new(obj->length);
+	if (!index)
+		return NULL;
+
+	for (i = 0; i < obj->length; i++) {
+		if (!obj_ptr[i]->key || fwts_hash_get(index, obj_ptr[i]->key))
+			continue;
+		if (fwts_hash_add(index, obj_ptr[i]->key, obj_ptr[i]) != FWTS_OK) {
+			fwts_hash_free(index, NULL);
+			return NULL;
+		}
+	}
+
+	if (arena_index) {
+		arena_index->index = index;
+		arena_index->next = obj->arena->indexes;
+		obj->arena->indexes = arena_index;
+	}
+	return index;
+}
+
 /*
  *  json_object_object_add()
  *	add a key/valyue object to a json object, return NULL if failed
@@ -664,10 +926,19 @@ void json_object_object_add(json_object *obj, const char *key, json_object *valu
 		return;
 	if (obj->type != type_object)
 		return;
-	value->key = strdup(key);
+	if (value->arena)
+		value->key = json_arena_strdup(value->arena, key);
+	else
+		value->key = strdup(key);
 	if (!value->key)
 		return;
-	json_object_array_add_item(obj, value);
+	if ((json_object_array_add_item(obj, value) == 0) &&
+	    obj->index && !fwts_hash_get(obj->index, value->key)) {
+		if (fwts_hash_add(obj->index, value->key, value) != FWTS_OK) {
+			/* Can't keep the index complete, so drop it */
+			json_object_index_free(obj);
+		}
+	}
 }
 
 /*
@@ -706,7 +977,9 @@ const char *json_object_get_string(json_object *obj)
 
 /*
  *  json_object_put()
- *	free a json object and all sub-objects
+ *	free a json object and all sub-objects. A parsed tree is
+ *	freed in one go by putting its root object, putting any
+ *	other object in a parsed tree does nothing.
  */
 void json_object_put(json_object *obj)
 {
@@ -716,8 +989,15 @@ void json_object_put(json_object *obj)
 	if (!obj)
 		return;
 
+	if (obj->arena) {
+		if (obj->arena->root == obj)
+			json_arena_free(obj->arena);
+		return;
+	}
+
 	if (obj->key)
 		free(obj->key);
+	json_object_index_free(obj);
 
 	switch (obj->type) {
 	case type_array:
@@ -1027,7 +1307,8 @@ char *json_object_to_json_string(json_object *obj)
 /*
  *  json_object_object_get()
  *	return value from key/value pair from an object, returns
- *	NULL if it can't be found
+ *	NULL if it can't be found. Large objects are looked up
+ *	using a key index, small ones with a linear search.
  */
 json_object *json_object_object_get(json_object *obj, const char *key)
 {
@@ -1039,6 +1320,11 @@ json_object *json_object_object_get(json_object *obj, const char *key)
 	if (obj->type != type_object)
 		return NULL;
 
+	if (!obj->index && (obj->length >= JSON_INDEX_THRESHOLD))
+		obj->index = json_object_index(obj);
+	if (obj->index)
+		return fwts_hash_get(obj->index, key);
+
 	obj_ptr = (json_object **)obj->u.ptr;
 	for (i = 0; i < obj->length; i++) {
 		if (obj_ptr[i]->key && !strcmp(obj_ptr[i]->key, key))
@@ -27,6 +27,9 @@
 #include <sys/stat.h>
 #include <regex.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <inttypes.h>
 
 #include "fwts.h"
 
@@ -86,6 +89,280 @@ fwts_list *fwts_klog_read(void)
 	return list;
 }
 
+/*
+ *  fwts_klog_kmsg_append()
+ *	convert a /dev/kmsg record "pri,seq,ts_usec,flags;message"
+ *	into klogctl style "<pri>[ secs.usecs] message" lines and append
+ *	them to the list, the record is modified. Escaped newlines in the
+ *	message start a new line, other \xHH escapes are decoded in place.
+ */
+static int fwts_klog_kmsg_append(fwts_list *list, char *record, uint64_t *seq)
+{
+	char *msg, *src, *dst, *line, *end;
+	unsigned long pri;
+	unsigned long long ts;
+	char prefix[48];
+
+	if ((msg = strchr(record, ';')) == NULL)
+		return FWTS_OK;
+	*msg++ = '\0';
+	/* Continuation lines (" KEY=value" dictionary) are ignored */
+	if ((end = strchr(msg, '\n')) != NULL)
+		*end = '\0';
+
+	if (sscanf(record, "%lu,%" SCNu64 ",%llu", &pri, seq, &ts) != 3)
+		return FWTS_OK;
+
+	snprintf(prefix, sizeof(prefix), "<%lu>[%5llu.%06llu] ",
+		pri, ts / 1000000ULL, ts % 1000000ULL);
+
+	for (src = dst = msg; *src; ) {
+		unsigned int ch;
+
+		if ((src[0] == '\\') && (src[1] == 'x') &&
+		    isxdigit((unsigned char)src[2]) && isxdigit((unsigned char)src[3]) &&
+		    (sscanf(src + 2, "%2x", &ch) == 1)) {
+			*dst++ = (char)ch;
+			src += 4;
+		} else {
+			*dst++ = *src++;
+		}
+	}
+	*dst = '\0';
+
+	for (line = msg; line; line = end) {
+		char *text;
+
+		if ((end = strchr(line, '\n')) != NULL)
+			*end++ = '\0';
+		if ((text = malloc(strlen(prefix) + strlen(line) + 1)) == NULL)
+			return FWTS_OUT_OF_MEMORY;
+		strcpy(text, prefix);
+		strcat(text, line);
+		if (fwts_list_append(list, text) == NULL) {
+			free(text);
+			return FWTS_OUT_OF_MEMORY;
+		}
+	}
+	return FWTS_OK;
+}
+
+/*
+ *  fwts_klog_cursor_kmsg_read()
+ *	read all records past the cursor from /dev/kmsg
+ */
+static fwts_list *fwts_klog_cursor_kmsg_read(fwts_klog_cursor *cursor)
+{
+	fwts_list *list;
+	char record[8192];
+
+	if ((list = fwts_list_new()) == NULL)
+		return NULL;
+
+	for (;;) {
+		ssize_t n;
+		uint64_t seq = UINT64_MAX;
+
+		n = read(cursor->fd, record, sizeof(record) - 1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			/*
+			 *  Records overwritten before we read them, carry on,
+			 *  the gap in sequence numbers says how many were lost
+			 *  unless no record has been read yet to compare with
+			 */
+			if (errno == EPIPE) {
+				if (!cursor->seq_valid)
+					cursor->lost++;
+				continue;
+			}
+			/* EAGAIN, nothing more to read */
+			break;
+		}
+		if (n == 0)
+			break;
+		record[n] = '\0';
+
+		if (fwts_klog_kmsg_append(list, record, &seq) != FWTS_OK) {
+			fwts_list_free(list, free);
+			return NULL;
+		}
+		if (seq == UINT64_MAX)
+			continue;
+		if (cursor->seq_valid && (seq > cursor->seq))
+			cursor->lost += seq - cursor->seq;
+		cursor->seq = seq + 1;
+		cursor->seq_valid = true;
+	}
+	return list;
+}
+
+/*
+ *  fwts_klog_cursor_file_read()
+ *	read all complete lines past the cursor offset from a
+ *	kernel log dump file
+ */
+static fwts_list *fwts_klog_cursor_file_read(fwts_klog_cursor *cursor)
+{
+	struct stat buf;
+	fwts_list *list;
+	char *text, *last;
+	ssize_t n;
+	size_t len;
+
+	if (fstat(cursor->fd, &buf) < 0)
+		return NULL;
+
+	/* File truncated or rotated, start again from the beginning */
+	if (buf.st_size < cursor->offset)
+		cursor->offset = 0;
+
+	len = (size_t)(buf.st_size - cursor->offset);
+	if ((text = malloc(len + 1)) == NULL)
+		return NULL;
+	n = pread(cursor->fd, text, len, cursor->offset);
+	if (n < 0) {
+		free(text);
+		return NULL;
+	}
+	text[n] = '\0';
+
+	/* Leave any partially written last line for the next read */
+	if ((last = strrchr(text, '\n')) == NULL) {
+		*text = '\0';
+	} else {
+		*(last + 1) = '\0';
+		cursor->offset += (last + 1) - text;
+	}
+
+	list = fwts_list_from_text(text);
+	free(text);
+
+	return list;
+}
+
+/*
+ *  fwts_klog_cursor_open()
+ *	open a kernel log cursor positioned at the current end of
+ *	the log. If filename is NULL the live kernel log is used via
+ *	/dev/kmsg, falling back to klogctl() snapshots if /dev/kmsg is
+ *	not readable, otherwise filename is a kernel log dump to tail.
+ */
+fwts_klog_cursor *fwts_klog_cursor_open(const char *filename)
+{
+	fwts_klog_cursor *cursor;
+
+	if ((cursor = calloc(1, sizeof(*cursor))) == NULL)
+		return NULL;
+
+	if (filename) {
+		struct stat buf;
+
+		if ((cursor->fd = open(filename, O_RDONLY)) < 0)
+			goto err;
+		if (fstat(cursor->fd, &buf) < 0) {
+			(void)close(cursor->fd);
+			goto err;
+		}
+		cursor->offset = buf.st_size;
+		return cursor;
+	}
+
+	if ((cursor->fd = open("/dev/kmsg", O_RDONLY | O_NONBLOCK)) >= 0) {
+		if (lseek(cursor->fd, 0, SEEK_END) >= 0) {
+			cursor->kmsg = true;
+			return cursor;
+		}
+		(void)close(cursor->fd);
+		cursor->fd = -1;
+	}
+
+	/* No /dev/kmsg, so diff against a snapshot of the log */
+	if ((cursor->klog = fwts_klog_read()) == NULL)
+		goto err;
+
+	return cursor;
+err:
+	free(cursor);
+	return NULL;
+}
+
+/*
+ *  fwts_klog_cursor_read()
+ *	return the kernel log lines added since the cursor was opened
+ *	or last read and advance the cursor past them. The list must be
+ *	freed with fwts_klog_free().
+ */
+fwts_list *fwts_klog_cursor_read(fwts_klog_cursor *cursor)
+{
+	fwts_list *klog, *klog_diff, *list;
+	fwts_list_link *item;
+
+	if (cursor == NULL)
+		return NULL;
+
+	if (cursor->kmsg)
+		return fwts_klog_cursor_kmsg_read(cursor);
+	if (cursor->fd >= 0)
+		return fwts_klog_cursor_file_read(cursor);
+
+	if ((klog = fwts_klog_read()) == NULL)
+		return NULL;
+	if ((klog_diff = fwts_klog_find_changes(cursor->klog, klog)) == NULL) {
+		fwts_klog_free(klog);
+		return NULL;
+	}
+	if ((list = fwts_list_new()) == NULL) {
+		fwts_list_free(klog_diff, NULL);
+		fwts_klog_free(klog);
+		return NULL;
+	}
+	fwts_list_foreach(item, klog_diff) {
+		if (fwts_text_list_append(list, fwts_list_data(char *, item)) == NULL) {
+			fwts_klog_free(list);
+			list = NULL;
+			break;
+		}
+	}
+	fwts_list_free(klog_diff, NULL);
+	fwts_klog_free(cursor->klog);
+	cursor->klog = klog;
+
+	return list;
+}
+
+/*
+ *  fwts_klog_cursor_close()
+ *	close and free a kernel log cursor
+ */
+void fwts_klog_cursor_close(fwts_klog_cursor *cursor)
+{
+	if (cursor == NULL)
+		return;
+
+	if (cursor->fd >= 0)
+		(void)close(cursor->fd);
+	fwts_klog_free(cursor->klog);
+	free(cursor);
+}
+
+/*
+ *  fwts_klog_cursor_check_lost()
+ *	warn about kernel log records that were overwritten before
+ *	they could be read through the cursor since the last check
+ */
+void fwts_klog_cursor_check_lost(fwts_framework *fw, fwts_klog_cursor *cursor)
+{
+	if ((cursor == NULL) || (cursor->lost == 0))
+		return;
+
+	fwts_log_warning(fw, "klog records lost: %" PRIu64 " kernel log record%s "
+		"overwritten before being read, the kernel log checks may be incomplete.",
+		cursor->lost, cursor->lost == 1 ? " was" : "s were");
+	cursor->lost = 0;
+}
+
 char *fwts_klog_remove_timestamp(char *text)
 {
 	return fwts_log_remove_timestamp(text);
@@ -170,6 +447,16 @@ int fwts_klog_regex_find(fwts_framework *fw, fwts_list *klog, char *pattern)
     return fwts_log_regex_find(fw, klog, pattern, true);
 }
 
+/*
+ * fwts_klog_regex_find_all()
+ *	scan a kernel log list of lines for a table of n regex
+ *	patterns compiled with fwts_log_regex_compile() in one pass
+ */
+int fwts_klog_regex_find_all(fwts_framework *fw, fwts_list *klog, fwts_log_regex *regexes, const int n)
+{
+	return fwts_log_regex_find_all(fw, klog, regexes, n, true);
+}
+
 /*
  * fwts_klog_write()
  *	write a message to the kernel log
@@ -30,22 +30,111 @@
 
 #define MAX_JSON_STACK	(64)
 
+/*
+ *  The json log is written out as it is logged rather than built
+ *  as a json object tree and written on close. The layout is the
+ *  same as json_object_to_json_string() of the equivalent tree:
+ *  each section is an object at an even indent holding one array,
+ *  keyed by the section name, of records and nested sections.
+ */
 typedef struct {
-	json_object	*obj;
-	json_object	*log;
+	int		indent;		/* indent level of the section object */
+	int		count;		/* number of items in the section array */
 } fwts_log_json_stack_t;
 
 static fwts_log_json_stack_t json_stack[MAX_JSON_STACK];
 static int json_stack_index = 0;
 
 /*
- *  fwts_log_out_of_memory_json()
- *	handle out of memory from json objects
+ *  fwts_log_indent_json()
+ *	write 2 spaces per indent level, up to 80 spaces
+ */
+static void fwts_log_indent_json(FILE *fp, const int indent)
+{
+	const int n = (indent + indent) > 80 ? 80 : indent + indent;
+
+	fprintf(fp, "%*s", n, "");
+}
+
+/*
+ *  fwts_log_string_json()
+ *	write a quoted string, escaping the same characters as
+ *	json_object_to_json_string()
+ */
+static void fwts_log_string_json(FILE *fp, const char *str)
+{
+	const char *ptr;
+
+	fputc('"', fp);
+	for (ptr = str; *ptr; ptr++) {
+		int esc;
+
+		switch (*ptr) {
+		case '"':
+			esc = '"';
+			break;
+		case '\b':
+			esc = 'b';
+			break;
+		case '\f':
+			esc = 'f';
+			break;
+		case '\n':
+			esc = 'n';
+			break;
+		case '\r':
+			esc = 'r';
+			break;
+		case '\t':
+			esc = 't';
+			break;
+		default:
+			esc = 0;
+			break;
+		}
+		if (esc) {
+			fputc('\\', fp);
+			fputc(esc, fp);
+		} else {
+			fputc(*ptr, fp);
+		}
+	}
+	fputc('"', fp);
+}
+
+/*
+ *  fwts_log_field_json()
+ *	write a key and string value of a log record
+ */
+static void fwts_log_field_json(
+	FILE *fp,
+	const int indent,
+	const bool first,
+	const char *key,
+	const char *value)
+{
+	fputs(first ? "\n" : ",\n", fp);
+	fwts_log_indent_json(fp, indent);
+	fprintf(fp, "\"%s\":", key);
+	fwts_log_string_json(fp, value);
+}
+
+/*
+ *  fwts_log_item_json()
+ *	start a new item in the current section array,
+ *	returns the indent level of the item
  */
-static void fwts_log_out_of_memory_json(void)
+static int fwts_log_item_json(FILE *fp)
 {
-	fprintf(stderr, "Out of memory allocating a json object.\n");
-	exit(EXIT_FAILURE);
+	fwts_log_json_stack_t *section = &json_stack[json_stack_index - 1];
+	const int indent = section->indent + 2;
+
+	if (section->count++) {
+		fputc('\n', fp);
+		fwts_log_indent_json(fp, indent);
+		fputc(',', fp);
+	}
+	return indent;
 }
 
 /*
@@ -61,13 +150,12 @@ static int fwts_log_print_json(
 	const char *prefix,
 	const char *buffer)
 {
+	FILE *fp = log_file->fp;
 	char tmpbuf[4096];
 	struct tm tm;
 	time_t now;
-	json_object *header;
-	json_object *json_log = (json_object*)json_stack[json_stack_index-1].log;
-	json_object *obj;
 	char *str;
+	int indent;
 
 	FWTS_UNUSED(prefix);
 
@@ -77,58 +165,50 @@ static int fwts_log_print_json(
 	if (field & (LOG_NEWLINE | LOG_SEPARATOR | LOG_DEBUG))
 		return 0;
 
+	if (json_stack_index < 1)
+		return 0;
+
 	time(&now);
 	localtime_r(&now, &tm);
 
-	if ((header = json_object_new_object()) == NULL)
-		fwts_log_out_of_memory_json();
+	indent = fwts_log_item_json(fp);
+	fwts_log_indent_json(fp, indent);
+	fputc('\n', fp);
+	fwts_log_indent_json(fp, indent);
+	fputc('{', fp);
 
-	if ((obj = json_object_new_int(log_file->line_number)) == NULL)
-		fwts_log_out_of_memory_json();
-	json_object_object_add(header, "line_num", obj);
+	fputc('\n', fp);
+	fwts_log_indent_json(fp, indent + 1);
+	fprintf(fp, "\"line_num\":%d", (int)log_file->line_number);
 
 	snprintf(tmpbuf, sizeof(tmpbuf), "%2.2d/%2.2d/%-2.2d",
 		tm.tm_mday, tm.tm_mon + 1, (tm.tm_year+1900) % 100);
-	if ((obj = json_object_new_string(tmpbuf)) == NULL)
-		fwts_log_out_of_memory_json();
-	json_object_object_add(header, "date", obj);
+	fwts_log_field_json(fp, indent + 1, false, "date", tmpbuf);
 
 	snprintf(tmpbuf, sizeof(tmpbuf), "%2.2d:%2.2d:%2.2d",
 		tm.tm_hour, tm.tm_min, tm.tm_sec);
-	if ((obj = json_object_new_string(tmpbuf)) == NULL)
-		fwts_log_out_of_memory_json();
-	json_object_object_add(header, "time", obj);
+	fwts_log_field_json(fp, indent + 1, false, "time", tmpbuf);
 
-	if ((obj = json_object_new_string(fwts_log_field_to_str_full(field))) == NULL)
-		fwts_log_out_of_memory_json();
-	json_object_object_add(header, "field_type", obj);
+	fwts_log_field_json(fp, indent + 1, false, "field_type",
+		fwts_log_field_to_str_full(field));
 
 	str = fwts_log_level_to_str(level);
 	if (!strcmp(str, " "))
 		str = "None";
-	if ((obj = json_object_new_string(str)) == NULL)
-		fwts_log_out_of_memory_json();
-	json_object_object_add(header, "level", obj);
-
-	if ((obj = json_object_new_string(*status ? status : "None")) == NULL)
-		fwts_log_out_of_memory_json();
-	json_object_object_add(header, "status", obj);
+	fwts_log_field_json(fp, indent + 1, false, "level", str);
 
-	if ((obj = json_object_new_string(label && *label ? label : "None")) == NULL)
-		fwts_log_out_of_memory_json();
-	json_object_object_add(header, "failure_label", obj);
+	fwts_log_field_json(fp, indent + 1, false, "status",
+		*status ? status : "None");
+	fwts_log_field_json(fp, indent + 1, false, "failure_label",
+		label && *label ? label : "None");
+	fwts_log_field_json(fp, indent + 1, false, "log_text", buffer);
 
-	/* Redundant really
-	if ((obj = json_object_new_string(log->owner)) == NULL)
-		fwts_log_out_of_memory_json();
-	json_object_object_add(header, "owner", obj);
-	*/
+	fputc('\n', fp);
+	fwts_log_indent_json(fp, indent);
+	fputc('}', fp);
+	fwts_log_indent_json(fp, indent);
+	fflush(fp);
 
-	if ((obj = json_object_new_string(buffer)) == NULL)
-		fwts_log_out_of_memory_json();
-	json_object_object_add(header, "log_text", obj);
-
-	json_object_array_add(json_log, header);
 	log_file->line_number++;	/* This is academic really */
 
 	return 0;
@@ -159,42 +239,37 @@ static void fwts_log_newline_json(fwts_log_file *log_file)
 
 static void fwts_log_section_begin_json(fwts_log_file *log_file, const char *name)
 {
-	json_object *json_obj;
-	json_object *json_log;
-
-	FWTS_UNUSED(log_file);
-
-	if ((json_obj = json_object_new_object()) == NULL)
-		fwts_log_out_of_memory_json();
-
-	if ((json_log = json_object_new_array()) == NULL)
-		fwts_log_out_of_memory_json();
+	FILE *fp = log_file->fp;
+	int indent = 0;
 
-	/*
-	 * unfortunately json_object_object_add can fail on
-	 * a strdup, but it doesn't check this and doesn't
-	 * tell us about this either. Bit lame really.
-	 */
-	json_object_object_add(json_obj, name, json_log);
-
-
-	if (json_stack_index > 0)
-		if (json_object_array_add(json_stack[json_stack_index-1].log, json_obj) != 0)
-			fwts_log_out_of_memory_json();
-
-	if (json_stack_index < MAX_JSON_STACK) {
-		json_stack[json_stack_index].obj = json_obj;
-		json_stack[json_stack_index].log = json_log;
-		json_stack_index++;
-	} else  {
+	if (json_stack_index >= MAX_JSON_STACK) {
 		fprintf(stderr, "json log stack overflow pushing section %s.\n", name);
 		exit(EXIT_FAILURE);
 	}
+
+	if (json_stack_index > 0)
+		indent = fwts_log_item_json(fp);
+
+	/* Section object holding the named section array */
+	fwts_log_indent_json(fp, indent);
+	fputc('\n', fp);
+	fwts_log_indent_json(fp, indent);
+	fputs("{\n", fp);
+	fwts_log_indent_json(fp, indent + 1);
+	fprintf(fp, "\"%s\":\n", name);
+	fwts_log_indent_json(fp, indent + 1);
+	fputc('[', fp);
+	fflush(fp);
+
+	json_stack[json_stack_index].indent = indent;
+	json_stack[json_stack_index].count = 0;
+	json_stack_index++;
 }
 
 static void fwts_log_section_end_json(fwts_log_file *log_file)
 {
-	FWTS_UNUSED(log_file);
+	FILE *fp = log_file->fp;
+	int indent;
 
 	if (json_stack_index > 0)
 		json_stack_index--;
@@ -202,38 +277,32 @@ static void fwts_log_section_end_json(fwts_log_file *log_file)
 		fprintf(stderr, "json log stack underflow.\n");
 		exit(EXIT_FAILURE);
 	}
+
+	indent = json_stack[json_stack_index].indent;
+	fputc('\n', fp);
+	fwts_log_indent_json(fp, indent + 1);
+	fputs("]\n", fp);
+	fwts_log_indent_json(fp, indent);
+	fputc('}', fp);
+	fwts_log_indent_json(fp, indent);
+	fflush(fp);
 }
 
 static void fwts_log_open_json(fwts_log_file *log_file)
 {
+	json_stack_index = 0;
 	fwts_log_section_begin_json(log_file, "fwts");
 }
 
 static void fwts_log_close_json(fwts_log_file *log_file)
 {
-	char *str;
+	/* Close any sections left open as well as the top level one */
+	while (json_stack_index > 0)
+		fwts_log_section_end_json(log_file);
 
-	fwts_log_section_end_json(log_file);
-
-#ifdef JSON_C_TO_STRING_PRETTY
-	str = json_object_to_json_string_ext(
-		json_stack[0].obj, JSON_C_TO_STRING_PRETTY);
-#else
-	str = json_object_to_json_string(json_stack[0].obj);
-#endif
-	if (str == NULL) {
-		/* Let's not make this bail out as user may be logging to other files too */
-		fprintf(stderr, "Cannot turn json object to text for output. Empty json output\n");
-	} else {
-		size_t len = strlen(str);
-
-		fwrite(str, 1, len, log_file->fp);
-		fwrite("\n", 1, 1, log_file->fp);
-		fflush(log_file->fp);
-		log_file->line_number++;
-	}
-	json_object_put(json_stack[0].obj);
-	free(str);
+	fwrite("\n", 1, 1, log_file->fp);
+	fflush(log_file->fp);
+	log_file->line_number++;
 }
 
 fwts_log_ops fwts_log_json_ops = {
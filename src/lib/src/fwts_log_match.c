@@ -0,0 +1,644 @@
+/*
+ * Copyright (C) 2021 Canonical
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <ctype.h>
+#include <regex.h>
+
+#include "fwts.h"
+
+/*
+ *  Multi-pattern log line matcher.
+ *
+ *  All the string patterns and a required literal taken from each
+ *  regex pattern are loaded into one Aho-Corasick automaton so a
+ *  log line is scanned just once. String hits are definite matches,
+ *  literal hits select the regex patterns that need a regexec().
+ *  Regex patterns without a usable literal are always checked. The
+ *  lowest pattern index that matches wins, so the result is the
+ *  same as walking the pattern table in order.
+ */
+
+/*
+ *  Regex literals shorter than this don't filter
+ *  enough lines to be worth a prefilter
+ */
+#define MATCH_LITERAL_MIN	(3)
+
+#define MATCH_NONE		(INT_MAX)
+
+typedef struct {
+	int next;		/* next edge from the same state, -1 = end */
+	int target;		/* state this edge goes to */
+	unsigned char ch;	/* edge character */
+} match_edge;
+
+typedef struct {
+	int next;		/* next output of the same state, -1 = end */
+	int index;		/* regex pattern index */
+} match_output;
+
+typedef struct {
+	int edges;		/* first edge, -1 = none */
+	int fail;		/* failure link */
+	int regex_outputs;	/* regex patterns prefiltered by this state, -1 = none */
+	int regex_link;		/* next state on the fail chain with regex outputs, -1 = none */
+	int min_string;		/* lowest string pattern matched here or on the fail chain */
+} match_state;
+
+struct fwts_log_matcher {
+	fwts_log_pattern *patterns;	/* the pattern table being matched */
+	int count;			/* number of patterns */
+
+	match_state *states;
+	int n_states;
+	int max_states;
+	match_edge *edges;
+	int n_edges;
+	int max_edges;
+	match_output *outputs;
+	int n_outputs;
+	int max_outputs;
+	int root[256];			/* dense transitions from the root state */
+
+	int *unfiltered;		/* regex patterns with no literal, in table order */
+	int n_unfiltered;
+
+	int *candidates;		/* per line scratch, regex patterns to check */
+	unsigned int *stamp;		/* per pattern, last line it was made a candidate */
+	unsigned int generation;	/* current line number for stamp */
+};
+
+/*
+ *  match_grow()
+ *	grow an array geometrically so it has room for one more item
+ */
+static bool match_grow(void **array, int *max, const int n, const size_t size)
+{
+	void *tmp;
+	int new_max;
+
+	if (n < *max)
+		return true;
+
+	new_max = *max ? *max * 2 : 64;
+	if ((tmp = realloc(*array, (size_t)new_max * size)) == NULL)
+		return false;
+	*array = tmp;
+	*max = new_max;
+
+	return true;
+}
+
+/*
+ *  match_state_new()
+ *	add a new empty state, return the state index or -1 on failure
+ */
+static int match_state_new(fwts_log_matcher *matcher)
+{
+	match_state *state;
+
+	if (!match_grow((void **)&matcher->states, &matcher->max_states,
+	    matcher->n_states, sizeof(match_state)))
+		return -1;
+
+	state = &matcher->states[matcher->n_states];
+	state->edges = -1;
+	state->fail = 0;
+	state->regex_outputs = -1;
+	state->regex_link = -1;
+	state->min_string = MATCH_NONE;
+
+	return matcher->n_states++;
+}
+
+/*
+ *  match_edge_find()
+ *	find the goto transition from state on ch, -1 if none
+ */
+static inline int match_edge_find(const fwts_log_matcher *matcher, const int state, const unsigned char ch)
+{
+	int e;
+
+	if (state == 0)
+		return matcher->root[ch];
+
+	for (e = matcher->states[state].edges; e != -1; e = matcher->edges[e].next)
+		if (matcher->edges[e].ch == ch)
+			return matcher->edges[e].target;
+
+	return -1;
+}
+
+/*
+ *  match_add_keyword()
+ *	add a keyword to the trie, return the final state or -1 on failure
+ */
+static int match_add_keyword(fwts_log_matcher *matcher, const char *keyword)
+{
+	const unsigned char *ptr;
+	int state = 0;
+
+	for (ptr = (const unsigned char *)keyword; *ptr; ptr++) {
+		int next = match_edge_find(matcher, state, *ptr);
+
+		if (next == -1) {
+			if ((next = match_state_new(matcher)) < 0)
+				return -1;
+			if (state == 0) {
+				matcher->root[*ptr] = next;
+			} else {
+				match_edge *edge;
+
+				if (!match_grow((void **)&matcher->edges, &matcher->max_edges,
+				    matcher->n_edges, sizeof(match_edge)))
+					return -1;
+				edge = &matcher->edges[matcher->n_edges];
+				edge->ch = *ptr;
+				edge->target = next;
+				edge->next = matcher->states[state].edges;
+				matcher->states[state].edges = matcher->n_edges++;
+			}
+		}
+		state = next;
+	}
+	return state;
+}
+
+/*
+ *  match_regex_skip_bracket()
+ *	skip over a [...] bracket expression, ptr points to the '['
+ *	return pointer past the closing ']' or NULL if malformed
+ */
+static const char *match_regex_skip_bracket(const char *ptr)
+{
+	ptr++;
+	if (*ptr == '^')
+		ptr++;
+	if (*ptr == ']')
+		ptr++;
+
+	while (*ptr && *ptr != ']') {
+		if ((*ptr == '[') && (ptr[1] == ':' || ptr[1] == '.' || ptr[1] == '=')) {
+			const char delim = ptr[1];
+
+			for (ptr += 2; *ptr && !(ptr[0] == delim && ptr[1] == ']'); ptr++)
+				;
+			if (!*ptr)
+				return NULL;
+			ptr += 2;
+			continue;
+		}
+		ptr++;
+	}
+	return *ptr ? ptr + 1 : NULL;
+}
+
+/*
+ *  match_regex_skip_group()
+ *	skip over a (...) group, ptr points to the '('
+ *	return pointer past the closing ')' or NULL if malformed
+ */
+static const char *match_regex_skip_group(const char *ptr)
+{
+	int depth = 0;
+
+	while (*ptr) {
+		switch (*ptr) {
+		case '\\':
+			if (!ptr[1])
+				return NULL;
+			ptr += 2;
+			break;
+		case '[':
+			if ((ptr = match_regex_skip_bracket(ptr)) == NULL)
+				return NULL;
+			break;
+		case '(':
+			depth++;
+			ptr++;
+			break;
+		case ')':
+			ptr++;
+			if (--depth == 0)
+				return ptr;
+			break;
+		default:
+			ptr++;
+			break;
+		}
+	}
+	return NULL;
+}
+
+/*
+ *  match_regex_skip_quantifier()
+ *	skip a quantifier at ptr if there is one, set optional if
+ *	it allows the preceding atom to be absent and set quantified
+ *	if there was a quantifier. Return NULL if malformed.
+ */
+static const char *match_regex_skip_quantifier(const char *ptr, bool *optional, bool *quantified)
+{
+	*optional = false;
+	*quantified = true;
+
+	switch (*ptr) {
+	case '*':
+	case '?':
+		*optional = true;
+		return ptr + 1;
+	case '+':
+		return ptr + 1;
+	case '{':
+		/* {m}, {m,} and {m,n}, treat all of them as optional */
+		*optional = true;
+		ptr = strchr(ptr, '}');
+		return ptr ? ptr + 1 : NULL;
+	default:
+		*quantified = false;
+		return ptr;
+	}
+}
+
+/*
+ *  match_regex_literal()
+ *	find the longest run of literal characters that any line
+ *	matching the extended regex must contain. This is
+ *	conservative, anything not understood ends the current
+ *	run. Returns false if there is no usable literal.
+ */
+static bool match_regex_literal(const char *regex, char *literal, const size_t len)
+{
+	const char *ptr = regex;
+	char *run;
+	size_t run_len = 0, best_len = 0;
+
+	if ((run = malloc(len)) == NULL)
+		return false;
+
+	*literal = '\0';
+
+	while (*ptr) {
+		bool optional, quantified;
+		char ch;
+
+		switch (*ptr) {
+		case '|':
+			/* top level alternation, no single literal is required */
+			free(run);
+			return false;
+		case '\\':
+			ch = ptr[1];
+			if (!ch || isalnum((unsigned char)ch) || ch == '<' || ch == '>' ||
+			    ch == '`' || ch == '\'') {
+				/* backreferences, word and class escapes */
+				ptr += ch ? 2 : 1;
+				run_len = 0;
+				if ((ptr = match_regex_skip_quantifier(ptr, &optional, &quantified)) == NULL)
+					goto malformed;
+				continue;
+			}
+			ptr += 2;
+			break;
+		case '[':
+			run_len = 0;
+			if ((ptr = match_regex_skip_bracket(ptr)) == NULL)
+				goto malformed;
+			if ((ptr = match_regex_skip_quantifier(ptr, &optional, &quantified)) == NULL)
+				goto malformed;
+			continue;
+		case '(':
+			run_len = 0;
+			if ((ptr = match_regex_skip_group(ptr)) == NULL)
+				goto malformed;
+			if ((ptr = match_regex_skip_quantifier(ptr, &optional, &quantified)) == NULL)
+				goto malformed;
+			continue;
+		case '{':
+			/* stray interval, don't guess what it means */
+			goto malformed;
+		case '.':
+		case '^':
+		case '$':
+		case ')':
+		case '*':
+		case '+':
+		case '?':
+			/* wildcards, anchors and stray operators end the run */
+			run_len = 0;
+			ptr++;
+			if ((ptr = match_regex_skip_quantifier(ptr, &optional, &quantified)) == NULL)
+				goto malformed;
+			continue;
+		default:
+			ch = *ptr++;
+			if ((unsigned char)ch >= 0x80) {
+				/* part of a multibyte character, keep it simple */
+				run_len = 0;
+				if ((ptr = match_regex_skip_quantifier(ptr, &optional, &quantified)) == NULL)
+					goto malformed;
+				continue;
+			}
+			break;
+		}
+
+		/* ch is a literal, check if it is quantified */
+		if ((ptr = match_regex_skip_quantifier(ptr, &optional, &quantified)) == NULL)
+			goto malformed;
+
+		if (!optional)
+			run[run_len++] = ch;
+		if (run_len > best_len) {
+			memcpy(literal, run, run_len);
+			literal[run_len] = '\0';
+			best_len = run_len;
+		}
+		if (quantified)
+			run_len = 0;
+	}
+	free(run);
+
+	return best_len >= MATCH_LITERAL_MIN;
+
+malformed:
+	free(run);
+	*literal = '\0';
+	return false;
+}
+
+/*
+ *  match_build_links()
+ *	breadth first walk of the trie to fill in the failure
+ *	links, the regex output links and the lowest string
+ *	pattern index matched at each state
+ */
+static bool match_build_links(fwts_log_matcher *matcher)
+{
+	int *queue, head = 0, tail = 0;
+	int ch;
+
+	if ((queue = calloc((size_t)matcher->n_states, sizeof(int))) == NULL)
+		return false;
+
+	for (ch = 0; ch < 256; ch++) {
+		const int s = matcher->root[ch];
+
+		if (s > 0) {
+			matcher->states[s].fail = 0;
+			queue[tail++] = s;
+		}
+	}
+
+	while (head < tail) {
+		const int r = queue[head++];
+		int e;
+
+		for (e = matcher->states[r].edges; e != -1; e = matcher->edges[e].next) {
+			const int s = matcher->edges[e].target;
+			const unsigned char c = matcher->edges[e].ch;
+			int f = matcher->states[r].fail;
+			int next;
+
+			while ((next = match_edge_find(matcher, f, c)) == -1)
+				f = matcher->states[f].fail;
+
+			matcher->states[s].fail = next;
+			queue[tail++] = s;
+		}
+
+		/* parents are done before children, so the fail state is complete */
+		{
+			match_state *state = &matcher->states[r];
+			const match_state *fail = &matcher->states[state->fail];
+
+			if (fail->min_string < state->min_string)
+				state->min_string = fail->min_string;
+			state->regex_link = (fail->regex_outputs != -1) ?
+				state->fail : fail->regex_link;
+		}
+	}
+	free(queue);
+
+	return true;
+}
+
+/*
+ *  fwts_log_matcher_new()
+ *	build a multi-pattern matcher for a pattern table of count
+ *	items, return NULL if it can't be built and the caller
+ *	should match patterns one at a time
+ */
+fwts_log_matcher *fwts_log_matcher_new(fwts_log_pattern *patterns, const int count)
+{
+	fwts_log_matcher *matcher;
+	int i, ch;
+
+	if ((matcher = calloc(1, sizeof(*matcher))) == NULL)
+		return NULL;
+
+	matcher->patterns = patterns;
+	matcher->count = count;
+
+	if ((matcher->unfiltered = calloc((size_t)count + 1, sizeof(int))) == NULL)
+		goto fail;
+	if ((matcher->candidates = calloc((size_t)count + 1, sizeof(int))) == NULL)
+		goto fail;
+	if ((matcher->stamp = calloc((size_t)count + 1, sizeof(unsigned int))) == NULL)
+		goto fail;
+
+	for (ch = 0; ch < 256; ch++)
+		matcher->root[ch] = -1;
+	if (match_state_new(matcher) < 0)
+		goto fail;
+
+	for (i = 0; i < count; i++) {
+		fwts_log_pattern *pattern = &patterns[i];
+		int state;
+
+		if (pattern->compare_mode == FWTS_COMPARE_REGEX) {
+			const size_t len = strlen(pattern->pattern) + 1;
+			char *literal;
+			match_output *output;
+
+			/* a regex that failed to compile never matches */
+			if (!pattern->compiled_ok)
+				continue;
+
+			if ((literal = malloc(len)) == NULL)
+				goto fail;
+			if (!match_regex_literal(pattern->pattern, literal, len)) {
+				free(literal);
+				matcher->unfiltered[matcher->n_unfiltered++] = i;
+				continue;
+			}
+			state = match_add_keyword(matcher, literal);
+			free(literal);
+			if (state < 0)
+				goto fail;
+
+			if (!match_grow((void **)&matcher->outputs, &matcher->max_outputs,
+			    matcher->n_outputs, sizeof(match_output)))
+				goto fail;
+			output = &matcher->outputs[matcher->n_outputs];
+			output->index = i;
+			output->next = matcher->states[state].regex_outputs;
+			matcher->states[state].regex_outputs = matcher->n_outputs++;
+		} else {
+			/* string and unknown compare modes both use strstr() */
+			if ((state = match_add_keyword(matcher, pattern->pattern)) < 0)
+				goto fail;
+			if (i < matcher->states[state].min_string)
+				matcher->states[state].min_string = i;
+		}
+	}
+
+	/* missing root transitions loop back to the root */
+	for (ch = 0; ch < 256; ch++)
+		if (matcher->root[ch] == -1)
+			matcher->root[ch] = 0;
+
+	if (!match_build_links(matcher))
+		goto fail;
+
+	return matcher;
+
+fail:
+	fwts_log_matcher_free(matcher);
+	return NULL;
+}
+
+/*
+ *  fwts_log_matcher_free()
+ *	free a matcher
+ */
+void fwts_log_matcher_free(fwts_log_matcher *matcher)
+{
+	if (!matcher)
+		return;
+
+	free(matcher->states);
+	free(matcher->edges);
+	free(matcher->outputs);
+	free(matcher->unfiltered);
+	free(matcher->candidates);
+	free(matcher->stamp);
+	free(matcher);
+}
+
+static int match_int_cmp(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+ *  match_regexec()
+ *	run a compiled regex pattern against line
+ */
+static bool match_regexec(fwts_framework *fw, fwts_log_pattern *pattern, const char *line)
+{
+	const int ret = regexec(&pattern->compiled, line, 0, NULL, 0);
+
+	if (!ret)
+		return true;
+
+	if (ret != REG_NOMATCH) {
+		char msg[1024];
+
+		regerror(ret, &pattern->compiled, msg, sizeof(msg));
+		fwts_log_info(fw, "regular expression engine error: %s.", msg);
+	}
+	return false;
+}
+
+/*
+ *  fwts_log_matcher_match()
+ *	find the first pattern in the table that matches line,
+ *	return the pattern index or -1 if nothing matches
+ */
+int fwts_log_matcher_match(fwts_framework *fw, fwts_log_matcher *matcher, const char *line)
+{
+	const unsigned char *ptr;
+	int best = matcher->states[0].min_string;
+	int n_candidates = 0;
+	int state = 0;
+	int i, j;
+
+	if (++matcher->generation == 0) {
+		/* wrapped, so old stamps could look current */
+		memset(matcher->stamp, 0, sizeof(unsigned int) * (size_t)matcher->count);
+		matcher->generation = 1;
+	}
+
+	for (ptr = (const unsigned char *)line; *ptr; ptr++) {
+		int s, next;
+
+		while ((next = match_edge_find(matcher, state, *ptr)) == -1)
+			state = matcher->states[state].fail;
+		state = next;
+
+		if (matcher->states[state].min_string < best)
+			best = matcher->states[state].min_string;
+
+		s = (matcher->states[state].regex_outputs != -1) ?
+			state : matcher->states[state].regex_link;
+		for (; s != -1; s = matcher->states[s].regex_link) {
+			int o;
+
+			for (o = matcher->states[s].regex_outputs; o != -1; o = matcher->outputs[o].next) {
+				const int index = matcher->outputs[o].index;
+
+				if ((index < best) && (matcher->stamp[index] != matcher->generation)) {
+					matcher->stamp[index] = matcher->generation;
+					matcher->candidates[n_candidates++] = index;
+				}
+			}
+		}
+	}
+
+	/*
+	 *  Check the regex candidates that come before the best
+	 *  string match, merging in the unfiltered regex patterns
+	 */
+	if (n_candidates > 1)
+		qsort(matcher->candidates, n_candidates, sizeof(int), match_int_cmp);
+
+	i = 0;
+	j = 0;
+	for (;;) {
+		int index;
+
+		if ((i < n_candidates) &&
+		    ((j >= matcher->n_unfiltered) || (matcher->candidates[i] < matcher->unfiltered[j])))
+			index = matcher->candidates[i++];
+		else if (j < matcher->n_unfiltered)
+			index = matcher->unfiltered[j++];
+		else
+			break;
+
+		if (index >= best)
+			break;
+		if (match_regexec(fw, &matcher->patterns[index], line))
+			return index;
+	}
+
+	return best == MATCH_NONE ? -1 : best;
+}
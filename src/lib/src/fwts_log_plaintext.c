@@ -27,74 +27,226 @@
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <time.h>
+#include <ctype.h>
 
 #include "fwts.h"
 
 /*
- *  fwts_log_header_plaintext()
- *	format up a tabulated log heading
+ *  Log format string compiled into a list of ops, recompiled
+ *  whenever fwts_log_format changes
  */
-static int fwts_log_header_plaintext(
-	fwts_log_file *log_file,
-	char *buffer,
-	const int len,
-	const fwts_log_field field,
-	const fwts_log_level level)
+typedef enum {
+	LOG_OP_LITERAL,		/* literal text from the format */
+	LOG_OP_LINE,		/* %line */
+	LOG_OP_DATE,		/* %date */
+	LOG_OP_TIME,		/* %time */
+	LOG_OP_FIELD,		/* %field */
+	LOG_OP_LEVEL,		/* %level */
+	LOG_OP_OWNER		/* %owner */
+} fwts_log_op_type;
+
+typedef struct {
+	fwts_log_op_type type;
+	const char *str;	/* literal text */
+	size_t len;		/* literal text length */
+} fwts_log_op;
+
+static fwts_log_op *log_ops;		/* compiled format */
+static size_t log_ops_count;		/* number of compiled ops */
+static const char *log_ops_format;	/* format the ops were compiled from */
+
+/* Date and time strings, only re-formatted when the second changes */
+static time_t log_time_now = (time_t)-1;
+static char log_date[40];
+static char log_time[40];
+
+/*
+ *  fwts_log_compile_plaintext()
+ *	compile fwts_log_format into log_ops, each op consumes at
+ *	least one char of the format so strlen() + 1 ops is plenty
+ */
+static void fwts_log_compile_plaintext(void)
 {
+	static const struct {
+		const char *token;
+		const size_t len;
+		const fwts_log_op_type type;
+	} tokens[] = {
+		{ "line",	4,	LOG_OP_LINE },
+		{ "date",	4,	LOG_OP_DATE },
+		{ "time",	4,	LOG_OP_TIME },
+		{ "field",	5,	LOG_OP_FIELD },
+		{ "level",	5,	LOG_OP_LEVEL },
+		{ "owner",	5,	LOG_OP_OWNER },
+	};
 	const char *ptr;
-	int n = 0;
-	struct tm tm;
-	time_t now;
+	fwts_log_op *ops;
+	size_t n = 0;
 
-	time(&now);
-	localtime_r(&now, &tm);
+	if ((ops = calloc(strlen(fwts_log_format) + 1, sizeof(*ops))) == NULL)
+		return;	/* Unlikely, just use the old format */
 
 	for (ptr = fwts_log_format; *ptr; ) {
 		if (*ptr == '%') {
+			size_t i;
+
+			/* Tokens may follow each other but only in this order */
 			ptr++;
-			if (!strncmp(ptr, "line", 4)) {
-				n += snprintf(buffer + n, len - n,
-					"%5.5" PRIu32, log_file->line_number);
-				ptr += 4;
+			for (i = 0; i < FWTS_ARRAY_SIZE(tokens); i++) {
+				if (!strncmp(ptr, tokens[i].token, tokens[i].len)) {
+					ops[n].type = tokens[i].type;
+					ops[n].str = ptr;
+					ops[n].len = tokens[i].len;
+					ptr += tokens[i].len;
+					n++;
+				}
 			}
-			if (!strncmp(ptr, "date", 4)) {
-				n += snprintf(buffer + n, len - n,
-					"%2.2d/%2.2d/%-2.2d",
-					tm.tm_mday, tm.tm_mon + 1, (tm.tm_year+1900) % 100);
-				ptr += 4;
+		} else {
+			if (!n || (ops[n - 1].type != LOG_OP_LITERAL) ||
+			    (ops[n - 1].str + ops[n - 1].len != ptr)) {
+				ops[n].type = LOG_OP_LITERAL;
+				ops[n].str = ptr;
+				ops[n].len = 0;
+				n++;
 			}
-			if (!strncmp(ptr, "time", 4)) {
-				n += snprintf(buffer + n, len - n,
-					"%2.2d:%2.2d:%2.2d",
+			ops[n - 1].len++;
+			ptr++;
+		}
+	}
+
+	free(log_ops);
+	log_ops = ops;
+	log_ops_count = n;
+	log_ops_format = fwts_log_format;
+}
+
+/*
+ *  fwts_log_append_plaintext()
+ *	append str to buffer without exceeding len bytes, the buffer
+ *	is not nul terminated. Returns the new untruncated length.
+ */
+static inline size_t fwts_log_append_plaintext(
+	char *buffer,
+	const size_t len,
+	const size_t n,
+	const char *str,
+	const size_t str_len)
+{
+	if (n < len)
+		memcpy(buffer + n, str, (len - n) < str_len ? (len - n) : str_len);
+
+	return n + str_len;
+}
+
+/*
+ *  fwts_log_header_plaintext()
+ *	format up a tabulated log heading into at most len bytes
+ *	of buffer, returns the untruncated length of the heading
+ */
+static size_t fwts_log_header_plaintext(
+	fwts_log_file *log_file,
+	char *buffer,
+	const size_t len,
+	const fwts_log_field field,
+	const fwts_log_level level)
+{
+	size_t i, n = 0;
+
+	if (log_ops_format != fwts_log_format)
+		fwts_log_compile_plaintext();
+
+	for (i = 0; i < log_ops_count; i++) {
+		const fwts_log_op *op = &log_ops[i];
+		const char *str;
+		char tmp[16], *ptr;
+		uint32_t val;
+		size_t str_len;
+		time_t now;
+
+		switch (op->type) {
+		case LOG_OP_LITERAL:
+			n = fwts_log_append_plaintext(buffer, len, n, op->str, op->len);
+			break;
+		case LOG_OP_LINE:
+			/* Same as "%5.5" PRIu32 */
+			ptr = tmp + sizeof(tmp);
+			val = log_file->line_number;
+			do {
+				*--ptr = '0' + (val % 10);
+				val /= 10;
+			} while (val || (ptr > tmp + sizeof(tmp) - 5));
+			n = fwts_log_append_plaintext(buffer, len, n, ptr, tmp + sizeof(tmp) - ptr);
+			break;
+		case LOG_OP_DATE:
+		case LOG_OP_TIME:
+			time(&now);
+			if (now != log_time_now) {
+				struct tm tm;
+
+				localtime_r(&now, &tm);
+				snprintf(log_date, sizeof(log_date), "%2.2d/%2.2d/%-2.2d",
+					tm.tm_mday, tm.tm_mon + 1, (tm.tm_year+1900) % 100);
+				snprintf(log_time, sizeof(log_time), "%2.2d:%2.2d:%2.2d",
 					tm.tm_hour, tm.tm_min, tm.tm_sec);
-				ptr += 4;
+				log_time_now = now;
 			}
-			if (!strncmp(ptr, "field", 5)) {
-				n += snprintf(buffer + n, len - n, "%s",
-					fwts_log_field_to_str(field));
-				ptr += 5;
+			str = (op->type == LOG_OP_DATE) ? log_date : log_time;
+			n = fwts_log_append_plaintext(buffer, len, n, str, strlen(str));
+			break;
+		case LOG_OP_FIELD:
+			str = fwts_log_field_to_str(field);
+			n = fwts_log_append_plaintext(buffer, len, n, str, strlen(str));
+			break;
+		case LOG_OP_LEVEL:
+			str = fwts_log_level_to_str(level);
+			n = fwts_log_append_plaintext(buffer, len, n, str, *str ? 1 : 0);
+			break;
+		case LOG_OP_OWNER:
+			/* No owner, so the token is just literal text */
+			if (!log_file->log->owner) {
+				n = fwts_log_append_plaintext(buffer, len, n, op->str, op->len);
+				break;
 			}
-			if (!strncmp(ptr, "level", 5)) {
-				n += snprintf(buffer + n, len - n, "%1.1s",
-					fwts_log_level_to_str(level));
-				ptr += 5;
-			}
-			if (!strncmp(ptr,"owner", 5) && log_file->log->owner) {
-				n += snprintf(buffer + n, len - n, "%-15.15s", log_file->log->owner);
-				ptr += 5;
-			}
-		} else {
-			n += snprintf(buffer+n, len-n, "%c", *ptr);
-			ptr++;
+			/* Same as "%-15.15s" */
+			str = log_file->log->owner;
+			str_len = strnlen(str, 15);
+			n = fwts_log_append_plaintext(buffer, len, n, str, str_len);
+			n = fwts_log_append_plaintext(buffer, len, n, "               ", 15 - str_len);
+			break;
 		}
 	}
 	return n;
 }
 
+/*
+ *  fwts_log_line_plaintext()
+ *	write a line of text with a log heading with the current
+ *	line number, the heading is re-formatted into header
+ */
+static void fwts_log_line_plaintext(
+	fwts_log_file *log_file,
+	const fwts_log_field field,
+	const fwts_log_level level,
+	char *header,
+	const size_t header_len,
+	const char *text,
+	const size_t text_len)
+{
+	if (!(field & LOG_NO_FIELDS)) {
+		fwts_log_header_plaintext(log_file, header, header_len, field, level);
+		fwrite(header, 1, header_len, log_file->fp);
+	}
+	fwrite(text, 1, text_len, log_file->fp);
+	fwrite("\n", 1, 1, log_file->fp);
+	fflush(log_file->fp);
+	log_file->line_number++;
+}
 
 /*
  *  fwts_log_print()
- *	print to a log
+ *	print to a log, the text is tidied up and broken into
+ *	lines in place in tmpbuf just after the heading, using
+ *	the same rules as fwts_format_text()
  */
 static int fwts_log_print_plaintext(
 	fwts_log_file *log_file,
@@ -106,12 +258,9 @@ static int fwts_log_print_plaintext(
 	const char *buffer)
 {
 	char tmpbuf[8192];
-	int n = 0;
-	int header_len;
-	int len = 0;
-
-	fwts_list *lines;
-	fwts_list_link *item;
+	char *text, *textptr, *linestart, *lastspace;
+	size_t header_len, text_len, n, linelen, width;
+	int len;
 
 	FWTS_UNUSED(status);
 	FWTS_UNUSED(label);
@@ -121,35 +270,69 @@ static int fwts_log_print_plaintext(
 
 	/* This is a pain, we neen to find out how big the leading log
 	   message is, so format one up. */
-	n = header_len = fwts_log_header_plaintext(log_file, tmpbuf, sizeof(tmpbuf), field, level);
-	n += snprintf(tmpbuf + n, sizeof(tmpbuf) - n, "%s%s", prefix, buffer);
+	header_len = fwts_log_header_plaintext(log_file, tmpbuf, sizeof(tmpbuf) - 1, field, level);
+	if (header_len > sizeof(tmpbuf) - 1)
+		header_len = sizeof(tmpbuf) - 1;
+	text = tmpbuf + header_len;
+	text_len = strlen(prefix);
+	n = fwts_log_append_plaintext(text, sizeof(tmpbuf) - 1 - header_len, 0, prefix, text_len);
+	text_len = strlen(buffer);
+	n = fwts_log_append_plaintext(text, sizeof(tmpbuf) - 1 - header_len, n, buffer, text_len);
+	len = header_len + n;
+	text[n < sizeof(tmpbuf) - 1 - header_len ? n : sizeof(tmpbuf) - 1 - header_len] = '\0';
 
-	/* Break text into multi-lines if necessary */
-	if (field & LOG_VERBATUM)
-		lines = fwts_list_from_text(tmpbuf + header_len);
-	else
-		lines = fwts_format_text(tmpbuf + header_len, log_file->line_width - header_len);
+	if (field & LOG_VERBATUM) {
+		/* Break text at each newline */
+		for (textptr = text; *textptr; ) {
+			linestart = textptr;
+			while (*textptr && *textptr != '\n')
+				textptr++;
+			fwts_log_line_plaintext(log_file, field, level,
+				tmpbuf, header_len, linestart, textptr - linestart);
+			len += (textptr - linestart) + 1;
+			if (*textptr == '\n')
+				textptr++;
+		}
+		return len;
+	}
 
-	if (!lines)
-		return 0;
-	len = n;
+	/* Collapse runs of whitespace into a single space */
+	for (textptr = linestart = text; *textptr; ) {
+		if (isspace(*textptr)) {
+			while (*textptr && isspace(*textptr))
+				textptr++;
+			*linestart++ = ' ';
+		} else
+			*linestart++ = *textptr++;
+	}
+	*linestart = '\0';
+
+	/* Break text into multi-lines if necessary */
+	width = log_file->line_width - header_len;
+	linelen = 0;
+	lastspace = NULL;
+	for (textptr = linestart = text; *textptr; textptr++, linelen++) {
+		/* find line break points */
+		if (isspace(*textptr) ||
+		    ((lastspace != NULL) && (*(textptr-1) != '/') && (*textptr == '/')) ||
+		    (*textptr == ':') ||
+		    (*textptr == ';') ||
+		    (*textptr == ','))
+			lastspace = textptr;
 
-	fwts_list_foreach(item, lines) {
-		char *text = fwts_text_list_text(item);
+		if ((linelen >= width) && (lastspace != NULL)) {
+			fwts_log_line_plaintext(log_file, field, level,
+				tmpbuf, header_len, linestart, lastspace - linestart);
+			len += (lastspace - linestart) + 1;
 
-		if (!(field & LOG_NO_FIELDS)) {
-			/* Re-format up a log heading with current line number which
-	 		   may increment with multiple line log messages */
-			fwts_log_header_plaintext(log_file, tmpbuf, sizeof(tmpbuf), field, level);
-			fwrite(tmpbuf, 1, header_len, log_file->fp);
+			linestart = lastspace + ((isspace(*lastspace)) ? 1 : 0);
+			linelen = textptr - linestart;
+			lastspace = NULL;
 		}
-		fwrite(text, 1, strlen(text), log_file->fp);
-		fwrite("\n", 1, 1, log_file->fp);
-		fflush(log_file->fp);
-		log_file->line_number++;
-		len += strlen(text) + 1;
 	}
-	fwts_text_list_free(lines);
+	fwts_log_line_plaintext(log_file, field, level,
+		tmpbuf, header_len, linestart, textptr - linestart);
+	len += (textptr - linestart) + 1;
 
 	return len;
 }
@@ -160,7 +343,7 @@ static int fwts_log_print_plaintext(
  */
 static void fwts_log_underline_plaintext(fwts_log_file *log_file, const int ch)
 {
-	int n;
+	size_t n;
 	char *buffer;
 	size_t width = log_file->line_width + 1;
 
@@ -174,7 +357,8 @@ static void fwts_log_underline_plaintext(fwts_log_file *log_file, const int ch)
 	/* Write in leading optional line prefix */
 	n = fwts_log_header_plaintext(log_file, buffer, width, LOG_SEPARATOR, LOG_LEVEL_NONE);
 
-	memset(buffer + n, ch, width  - n);
+	if (n < width)
+		memset(buffer + n, ch, width  - n);
 	buffer[width - 1] = '\n';
 
 	fwrite(buffer, 1, width, log_file->fp);
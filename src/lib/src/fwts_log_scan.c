@@ -29,6 +29,24 @@
 
 #include "fwts.h"
 
+/*
+ *  Compiled pattern tables, cached for the lifetime of the
+ *  process since klog, olog, clog and the s3/s4 cycles load
+ *  the same json tables over and over
+ */
+typedef struct {
+        char *json_data_path;           /* json file the table was loaded from */
+        char *table;                    /* table name in the json file */
+        char *label;                    /* unique label prefix */
+        struct timespec mtime;          /* json file modification time */
+        off_t size;                     /* json file size */
+        fwts_log_patterns *patterns;    /* the compiled table */
+} fwts_log_patterns_cache_item;
+
+static fwts_list log_patterns_cache = FWTS_LIST_INIT;
+static unsigned long log_patterns_cache_hits;
+static unsigned long log_patterns_cache_misses;
+
 /*
  *  fwts_log_free()
  *  free log list
@@ -38,6 +56,24 @@ void fwts_log_free(fwts_list *log)
 	fwts_text_list_free(log);
 }
 
+/*
+ *  fwts_log_lines()
+ *	return an array of the lines in a log, must be freed with free()
+ */
+static char **fwts_log_lines(fwts_list *log)
+{
+        fwts_list_link *item;
+        char **lines;
+        int i = 0;
+
+        if ((lines = calloc(fwts_list_len(log) + 1, sizeof(char *))) == NULL)
+                return NULL;
+        fwts_list_foreach(item, log)
+                lines[i++] = fwts_list_data(char *, item);
+
+        return lines;
+}
+
 /*
  *  fwts_log_find_changes()
  *      find new lines added to log, clone them from new list
@@ -45,7 +81,7 @@ void fwts_log_free(fwts_list *log)
  */
 fwts_list *fwts_log_find_changes(fwts_list *log_old, fwts_list *log_new)
 {
-        fwts_list_link *l_old, *l_new = NULL;
+        fwts_list_link *l_new = NULL;
         fwts_list *log_diff;
 
         if (log_new == NULL) {
@@ -55,31 +91,45 @@ fwts_list *fwts_log_find_changes(fwts_list *log_old, fwts_list *log_new)
         if ((log_diff = fwts_list_new()) == NULL)
                 return NULL;
 
-        if (log_old == NULL) {
+        if (log_old == NULL || log_old->tail == NULL) {
                 /* Nothing in old log, so clone all of new list */
                 l_new = log_new->head;
         } else {
-                fwts_list_link *l_old_last = NULL;
-
-                /* Clone just the new differences */
-
-                /* Find last item in old log */
-                fwts_list_foreach(l_old, log_old)
-                        l_old_last = l_old;
-
-                if (l_old_last) {
-                        /* And now look for that last line in the new log */
-                        char *old = fwts_list_data(char *, l_old_last);
-                        fwts_list_foreach(l_new, log_new) {
-                                const char *new = fwts_list_data(char *, l_new);
+                char **old_lines, **new_lines;
+                int i, j, n;
+
+                /*
+                 *  The new log starts with some tail of the old log, find
+                 *  the longest run of leading new lines that matches the end
+                 *  of the old log. Just matching the old log's last line is
+                 *  not enough when lines repeat.
+                 */
+                old_lines = fwts_log_lines(log_old);
+                new_lines = fwts_log_lines(log_new);
+                if (!old_lines || !new_lines) {
+                        free(old_lines);
+                        free(new_lines);
+                        fwts_list_free(log_diff, NULL);
+                        return NULL;
+                }
 
-                                if (!strcmp(new, old)) {
-                                        /* Found last line that matches, bump to next */
-                                        l_new = l_new->next;
+                n = fwts_list_len(log_new) < fwts_list_len(log_old) ?
+                        fwts_list_len(log_new) : fwts_list_len(log_old);
+                for (i = n - 1; i >= 0; i--) {
+                        for (j = 0; j <= i; j++) {
+                                if (strcmp(new_lines[i - j],
+                                           old_lines[fwts_list_len(log_old) - 1 - j]))
                                         break;
-                                }
                         }
+                        if (j > i)
+                                break;
                 }
+                free(old_lines);
+                free(new_lines);
+
+                /* Skip over the i + 1 lines already in the old log */
+                for (l_new = log_new->head; l_new && i >= 0; i--)
+                        l_new = l_new->next;
         }
 
         /* Clone the new unique lines to the log_diff list */
@@ -124,7 +174,9 @@ int fwts_log_scan(fwts_framework *fw,
         char *prev;
         fwts_list_link *item;
         fwts_list *log_reduced;
+        fwts_hash *log_seen;
         int i;
+        int ret = FWTS_ERROR;
         char *newline = NULL;
 
         *match = 0;
@@ -135,6 +187,15 @@ int fwts_log_scan(fwts_framework *fw,
         if ((log_reduced = fwts_list_new()) == NULL)
                 return FWTS_ERROR;
 
+        /*
+         *  Index of the timestamp stripped lines already in the
+         *  reduced log, the reduced log keeps first-seen order
+         */
+        if ((log_seen = fwts_hash_new(fwts_list_len(log))) == NULL) {
+                fwts_list_free(log_reduced, NULL);
+                return FWTS_ERROR;
+        }
+
         /*
          *  Form a reduced log by stripping out repeated warnings
          */
@@ -149,34 +210,22 @@ int fwts_log_scan(fwts_framework *fw,
                 if (progress_func  && ((i % 25) == 0))
                         progress_func(fw, 50 * i / fwts_list_len(log));
                 if (*newline) {
-                        bool matched = false;
-                        fwts_list_link *l;
-                        fwts_list_foreach(l, log_reduced) {
-                                char *line;
-                                log_reduced_item *reduced = fwts_list_data(log_reduced_item *, l);
-
-                                if (remove_timestamp)
-                                        line = fwts_log_remove_timestamp(reduced->line);
-                                else
-                                        line = reduced->line;
-
-                                if (strcmp(newline, line) == 0) {
-                                        reduced->repeated++;
-                                        matched = true;
-                                        break;
-                                }
-                        }
-                        if (!matched) {
-                                log_reduced_item *new;
+                        log_reduced_item *reduced = fwts_hash_get(log_seen, newline);
 
-                                if ((new = calloc(1, sizeof(log_reduced_item))) == NULL) {
-                                        fwts_list_free(log_reduced, free);
-                                        return FWTS_ERROR;
+                        if (reduced) {
+                                reduced->repeated++;
+                        } else {
+                                if ((reduced = calloc(1, sizeof(log_reduced_item))) == NULL)
+                                        goto out;
+                                reduced->line = fwts_list_data(char *, item);
+                                reduced->repeated = 0;
+
+                                if (fwts_list_append(log_reduced, reduced) == NULL) {
+                                        free(reduced);
+                                        goto out;
                                 }
-                                new->line = fwts_list_data(char *, item);
-                                new->repeated = 0;
-
-                                fwts_list_append(log_reduced, new);
+                                if (fwts_hash_add(log_seen, newline, reduced) != FWTS_OK)
+                                        goto out;
                         }
                 }
                 i++;
@@ -201,9 +250,12 @@ int fwts_log_scan(fwts_framework *fw,
         if (progress_func)
                 progress_func(fw, 100);
 
+        ret = FWTS_OK;
+out:
+        fwts_hash_free(log_seen, NULL);
         fwts_list_free(log_reduced, free);
 
-        return FWTS_OK;
+        return ret;
 }
 
 char *fwts_log_unique_label(const char *str, const char *label)
@@ -241,19 +293,15 @@ char *fwts_log_unique_label(const char *str, const char *label)
         return buffer;
 }
 
-void fwts_log_scan_patterns(fwts_framework *fw,
-        char *line,
-        int  repeated,
-        char *prevline,
-        void *private,
-        int *errors,
-        const char *name,
-        const char *advice)
+/*
+ *  fwts_log_find_pattern()
+ *	find the first pattern in the table that matches line
+ *	without the multi-pattern matcher, NULL if none match
+ */
+static fwts_log_pattern *fwts_log_find_pattern(fwts_framework *fw,
+        fwts_log_pattern *pattern,
+        const char *line)
 {
-        fwts_log_pattern *pattern = (fwts_log_pattern *)private;
-
-        FWTS_UNUSED(prevline);
-
         while (pattern->pattern != NULL) {
                 bool matched = false;
                 switch (pattern->compare_mode) {
@@ -277,24 +325,50 @@ void fwts_log_scan_patterns(fwts_framework *fw,
                         break;
                 }
 
-                if (matched) {
-                        if (pattern->level == LOG_LEVEL_INFO)
-                                fwts_log_info(fw, "%s message: %s", name, line);
-                        else {
-                                fwts_failed(fw, pattern->level, pattern->label,
-                                        "%s %s message: %s", fwts_log_level_to_str(pattern->level), name, line);
-                                fwts_error_inc(fw, pattern->label, errors);
-                        }
-                        if (repeated)
-                                fwts_log_info(fw, "Message repeated %d times.", repeated);
+                if (matched)
+                        return pattern;
+                pattern++;
+        }
+        return NULL;
+}
 
-                        if ((pattern->advice) != NULL && (*pattern->advice))
-                                fwts_advice(fw, "%s", pattern->advice);
-                        else
-                                fwts_advice(fw, "%s", advice);
-                        return;
+void fwts_log_scan_patterns(fwts_framework *fw,
+        char *line,
+        int  repeated,
+        char *prevline,
+        void *private,
+        int *errors,
+        const char *name,
+        const char *advice)
+{
+        fwts_log_patterns *patterns = (fwts_log_patterns *)private;
+        fwts_log_pattern *pattern;
+
+        FWTS_UNUSED(prevline);
+
+        if (patterns->matcher) {
+                const int index = fwts_log_matcher_match(fw, patterns->matcher, line);
+
+                pattern = (index < 0) ? NULL : &patterns->patterns[index];
+        } else {
+                pattern = fwts_log_find_pattern(fw, patterns->patterns, line);
+        }
+
+        if (pattern) {
+                if (pattern->level == LOG_LEVEL_INFO)
+                        fwts_log_info(fw, "%s message: %s", name, line);
+                else {
+                        fwts_failed(fw, pattern->level, pattern->label,
+                                "%s %s message: %s", fwts_log_level_to_str(pattern->level), name, line);
+                        fwts_error_inc(fw, pattern->label, errors);
                 }
-                pattern++;
+                if (repeated)
+                        fwts_log_info(fw, "Message repeated %d times.", repeated);
+
+                if ((pattern->advice) != NULL && (*pattern->advice))
+                        fwts_advice(fw, "%s", pattern->advice);
+                else
+                        fwts_advice(fw, "%s", advice);
         }
 }
 
@@ -347,25 +421,47 @@ nullobj:
 	return NULL;
 }
 
-int fwts_log_check(fwts_framework *fw,
-        const char *table,
-        fwts_log_scan_func fwts_log_scan_patterns_func,
-        fwts_log_progress_func progress,
-        fwts_list *log,
-        int *errors,
+/*
+ *  fwts_log_patterns_free()
+ *	free a pattern table loaded by fwts_log_patterns_load()
+ */
+void fwts_log_patterns_free(fwts_log_patterns *table)
+{
+        int i;
+
+        if (!table)
+                return;
+
+        fwts_log_matcher_free(table->matcher);
+        for (i = 0; i < table->count; i++) {
+                if (table->patterns[i].compiled_ok)
+                        regfree(&table->patterns[i].compiled);
+                if (table->patterns[i].label)
+                        free(table->patterns[i].label);
+        }
+        free(table->patterns);
+        json_object_put(table->objs);
+        free(table);
+}
+
+/*
+ *  fwts_log_patterns_load()
+ *	load a pattern table from the json data, compile the regex
+ *	patterns and build the multi-pattern matcher. Labels that are
+ *	not specified are generated using the label prefix. Returns
+ *	NULL on failure, free with fwts_log_patterns_free()
+ */
+fwts_log_patterns *fwts_log_patterns_load(fwts_framework *fw,
         const char *json_data_path,
-        const char *label,
-        bool remove_timestamp)
+        const char *table,
+        const char *label)
 {
-        int ret = FWTS_ERROR;
         int n;
         int i;
         int fd;
-        json_object *log_objs;
         json_object *log_table;
         fwts_log_pattern *patterns;
-
-	*errors = 0;
+        fwts_log_patterns *table_patterns;
 
         /*
          * json_object_from_file() can fail when files aren't readable
@@ -373,26 +469,32 @@ int fwts_log_check(fwts_framework *fw,
          */
         if ((fd = open(json_data_path, O_RDONLY)) < 0) {
                 fwts_log_error(fw, "Cannot read file %s, check the path and check that the file exists, you may need to specify -j or -J.", json_data_path);
-                return FWTS_ERROR;
+                return NULL;
         }
         (void)close(fd);
 
-        log_objs = json_object_from_file(json_data_path);
-        if (FWTS_JSON_ERROR(log_objs)) {
+        if ((table_patterns = calloc(1, sizeof(fwts_log_patterns))) == NULL) {
+                fwts_log_error(fw, "Cannot allocate pattern table.");
+                return NULL;
+        }
+
+        table_patterns->objs = json_object_from_file(json_data_path);
+        if (FWTS_JSON_ERROR(table_patterns->objs)) {
                 fwts_log_error(fw, "Cannot load log data from %s.", json_data_path);
-                return FWTS_ERROR;
+                free(table_patterns);
+                return NULL;
         }
 
 #if JSON_HAS_GET_EX
-        if (!json_object_object_get_ex(log_objs, table, &log_table)) {
+        if (!json_object_object_get_ex(table_patterns->objs, table, &log_table)) {
                 fwts_log_error(fw, "Cannot fetch log table object '%s' from %s.", table, json_data_path);
-                goto fail_put;
+                goto fail;
         }
 #else
-        log_table = json_object_object_get(log_objs, table);
+        log_table = json_object_object_get(table_patterns->objs, table);
         if (FWTS_JSON_ERROR(log_table)) {
                 fwts_log_error(fw, "Cannot fetch log table object '%s' from %s.", table, json_data_path);
-                goto fail_put;
+                goto fail;
         }
 #endif
 
@@ -401,8 +503,10 @@ int fwts_log_check(fwts_framework *fw,
         /* Last entry is null to indicate end, so alloc n+1 items */
         if ((patterns = calloc(n+1, sizeof(fwts_log_pattern))) == NULL) {
                 fwts_log_error(fw, "Cannot allocate pattern table.");
-                goto fail_put;
+                goto fail;
         }
+        table_patterns->patterns = patterns;
+        table_patterns->count = n;
 
         /* Now fetch json objects and compile regex */
         for (i = 0; i < n; i++) {
@@ -451,44 +555,247 @@ int fwts_log_check(fwts_framework *fw,
                         }
                 }
         }
+
+        /* Build the matcher once, if this fails fall back to matching each pattern in turn */
+        table_patterns->matcher = fwts_log_matcher_new(patterns, n);
+
+        return table_patterns;
+
+fail:
+        fwts_log_patterns_free(table_patterns);
+        return NULL;
+}
+
+static void fwts_log_patterns_cache_item_free(void *data)
+{
+        fwts_log_patterns_cache_item *item = (fwts_log_patterns_cache_item *)data;
+
+        fwts_log_patterns_free(item->patterns);
+        free(item->json_data_path);
+        free(item->table);
+        free(item->label);
+        free(item);
+}
+
+/*
+ *  fwts_log_patterns_get()
+ *	get a compiled pattern table, re-using a cached copy if the
+ *	json file has not changed since it was loaded. The table is
+ *	owned by the cache, do not free it.
+ */
+fwts_log_patterns *fwts_log_patterns_get(fwts_framework *fw,
+        const char *json_data_path,
+        const char *table,
+        const char *label)
+{
+        struct stat buf;
+        fwts_list_link *link;
+        fwts_log_patterns_cache_item *item = NULL;
+
+        /* Can't stat it, so let the loader report the problem */
+        if (stat(json_data_path, &buf) < 0)
+                return fwts_log_patterns_load(fw, json_data_path, table, label);
+
+        fwts_list_foreach(link, &log_patterns_cache) {
+                fwts_log_patterns_cache_item *cached =
+                        fwts_list_data(fwts_log_patterns_cache_item *, link);
+
+                if (!strcmp(cached->json_data_path, json_data_path) &&
+                    !strcmp(cached->table, table) &&
+                    !strcmp(cached->label, label)) {
+                        item = cached;
+                        break;
+                }
+        }
+
+        if (item && item->patterns &&
+            (item->size == buf.st_size) &&
+            (item->mtime.tv_sec == buf.st_mtim.tv_sec) &&
+            (item->mtime.tv_nsec == buf.st_mtim.tv_nsec)) {
+                log_patterns_cache_hits++;
+                return item->patterns;
+        }
+        log_patterns_cache_misses++;
+
+        if (!item) {
+                if ((item = calloc(1, sizeof(*item))) == NULL)
+                        return fwts_log_patterns_load(fw, json_data_path, table, label);
+
+                item->json_data_path = strdup(json_data_path);
+                item->table = strdup(table);
+                item->label = strdup(label);
+                if (!item->json_data_path || !item->table || !item->label ||
+                    (fwts_list_append(&log_patterns_cache, item) == NULL)) {
+                        fwts_log_patterns_cache_item_free(item);
+                        return fwts_log_patterns_load(fw, json_data_path, table, label);
+                }
+        } else {
+                /* json file changed, so reload it */
+                fwts_log_patterns_free(item->patterns);
+        }
+
+        item->mtime = buf.st_mtim;
+        item->size = buf.st_size;
+        item->patterns = fwts_log_patterns_load(fw, json_data_path, table, label);
+
+        return item->patterns;
+}
+
+/*
+ *  fwts_log_patterns_put()
+ *	release a pattern table from fwts_log_patterns_get(), only
+ *	tables that could not be cached are actually freed
+ */
+void fwts_log_patterns_put(fwts_log_patterns *patterns)
+{
+        fwts_list_link *link;
+
+        if (!patterns)
+                return;
+
+        fwts_list_foreach(link, &log_patterns_cache) {
+                fwts_log_patterns_cache_item *cached =
+                        fwts_list_data(fwts_log_patterns_cache_item *, link);
+
+                if (cached->patterns == patterns)
+                        return;
+        }
+        fwts_log_patterns_free(patterns);
+}
+
+/*
+ *  fwts_log_patterns_cache_stats()
+ *	get the pattern table cache hit and miss counts
+ */
+void fwts_log_patterns_cache_stats(unsigned long *hits, unsigned long *misses)
+{
+        *hits = log_patterns_cache_hits;
+        *misses = log_patterns_cache_misses;
+}
+
+/*
+ *  fwts_log_patterns_cache_free()
+ *	free all the cached pattern tables
+ */
+void fwts_log_patterns_cache_free(void)
+{
+        fwts_list_free_items(&log_patterns_cache, fwts_log_patterns_cache_item_free);
+        fwts_list_init(&log_patterns_cache);
+}
+
+int fwts_log_check(fwts_framework *fw,
+        const char *table,
+        fwts_log_scan_func fwts_log_scan_patterns_func,
+        fwts_log_progress_func progress,
+        fwts_list *log,
+        int *errors,
+        const char *json_data_path,
+        const char *label,
+        bool remove_timestamp)
+{
+        int ret;
+        fwts_log_patterns *patterns;
+
+	*errors = 0;
+
+        if ((patterns = fwts_log_patterns_get(fw, json_data_path, table, label)) == NULL)
+                return FWTS_ERROR;
+
         /* We've now collected up the scan patterns, lets scan the log for errors */
         ret = fwts_log_scan(fw, log, fwts_log_scan_patterns_func, progress, patterns, errors, remove_timestamp);
 
-fail:
+        fwts_log_patterns_put(patterns);
+
+        return ret;
+}
+
+/*
+ *  fwts_log_regex_compile()
+ *	compile a table of n regex patterns once so the log can
+ *	be searched for them many times, patterns that fail to
+ *	compile are reported and never match
+ */
+int fwts_log_regex_compile(fwts_framework *fw, fwts_log_regex *regexes, const int n)
+{
+        int i, ret = FWTS_OK;
+
         for (i = 0; i < n; i++) {
-                if (patterns[i].compiled_ok)
-                        regfree(&patterns[i].compiled);
-                if (patterns[i].label)
-                        free(patterns[i].label);
+                int rc;
+
+                regexes[i].count = 0;
+                rc = regcomp(&regexes[i].compiled, regexes[i].pattern, REG_EXTENDED);
+                if (rc) {
+                        fwts_log_error(fw, "Regex %s failed to compile: %d.", regexes[i].pattern, rc);
+                        regexes[i].compiled_ok = false;
+                        ret = FWTS_ERROR;
+                } else {
+                        regexes[i].compiled_ok = true;
+                }
         }
-        free(patterns);
-fail_put:
-        json_object_put(log_objs);
-
         return ret;
 }
 
+/*
+ *  fwts_log_regex_free()
+ *	free a table of n regex patterns compiled with fwts_log_regex_compile()
+ */
+void fwts_log_regex_free(fwts_log_regex *regexes, const int n)
+{
+        int i;
+
+        for (i = 0; i < n; i++) {
+                if (regexes[i].compiled_ok)
+                        regfree(&regexes[i].compiled);
+                regexes[i].compiled_ok = false;
+        }
+}
+
+typedef struct {
+        fwts_log_regex *regexes;
+        int n;
+} fwts_log_regex_table;
+
 static void fwts_log_regex_find_callback(fwts_framework *fw, char *line, int repeated,
-        char *prev, void *pattern, int *match)
+        char *prev, void *private, int *match)
 {
-        int rc;
-        regex_t compiled;
+        fwts_log_regex_table *table = (fwts_log_regex_table *)private;
+        int i;
 
         FWTS_UNUSED(fw);
         FWTS_UNUSED(repeated);
         FWTS_UNUSED(prev);
 
-        rc = regcomp(&compiled, (char *)pattern, REG_EXTENDED);
-        if (rc) {
-                fwts_log_error(fw, "Regex %s failed to compile: %d.", (char *)pattern, rc);
-        } else {
-                rc = regexec(&compiled, line, 0, NULL, 0);
-                regfree(&compiled);
-                if (!rc)
+        for (i = 0; i < table->n; i++) {
+                fwts_log_regex *regex = &table->regexes[i];
+
+                if (regex->compiled_ok && !regexec(&regex->compiled, line, 0, NULL, 0)) {
+                        regex->count++;
                         (*match)++;
+                        if (regex->lines)
+                                fwts_list_append(regex->lines, line);
+                }
         }
 }
 
+/*
+ * fwts_log_regex_find_all()
+ *      scan a log list of lines for a table of n compiled regex
+ *      patterns in one pass, the number of matching lines for each
+ *      pattern is returned in its count field and the matching
+ *      lines are appended to its lines list if it is not NULL
+ */
+int fwts_log_regex_find_all(fwts_framework *fw, fwts_list *log, fwts_log_regex *regexes, const int n, bool remove_timestamp)
+{
+        fwts_log_regex_table table = { regexes, n };
+        int found = 0;
+        int i;
+
+        for (i = 0; i < n; i++)
+                regexes[i].count = 0;
+
+        return fwts_log_scan(fw, log, fwts_log_regex_find_callback, NULL, &table, &found, remove_timestamp);
+}
+
 /*
  * fwts_log_regex_find()
  *      scan a log list of lines for a given regex pattern
@@ -496,9 +803,14 @@ static void fwts_log_regex_find_callback(fwts_framework *fw, char *line, int rep
  */
 int fwts_log_regex_find(fwts_framework *fw, fwts_list *log, char *pattern, bool remove_timestamp)
 {
-        int found = 0;
+        fwts_log_regex regex;
+
+        memset(&regex, 0, sizeof(regex));
+        regex.pattern = pattern;
 
-        fwts_log_scan(fw, log, fwts_log_regex_find_callback, NULL, pattern, &found, remove_timestamp);
+        if (fwts_log_regex_compile(fw, &regex, 1) == FWTS_OK)
+                fwts_log_regex_find_all(fw, log, &regex, 1, remove_timestamp);
+        fwts_log_regex_free(&regex, 1);
 
-        return found;
+        return regex.count;
 }
@@ -30,20 +30,19 @@
 #include "fwts.h"
 
 /*
- *  fwts_fwts_memory_map_entry_compare()
- *	callback used to sort memory_map entries on start address
+ *  fwts_memory_map_entry_compare()
+ *	qsort callback used to sort memory_map entries on start address
  */
-static int fwts_fwts_memory_map_entry_compare(void *data1, void *data2)
+static int fwts_memory_map_entry_compare(const void *data1, const void *data2)
 {
-        fwts_memory_map_entry *entry1 = (fwts_memory_map_entry *)data1;
-        fwts_memory_map_entry *entry2 = (fwts_memory_map_entry *)data2;
-
-	if (entry1->start_address < entry2->start_address)
-		return -1;
-	else if (entry1->start_address > entry2->start_address)
-		return 1;
-	else
-		return 0;
+	const fwts_memory_map_entry *entry1 = (const fwts_memory_map_entry *)data1;
+	const fwts_memory_map_entry *entry2 = (const fwts_memory_map_entry *)data2;
+
+	if (entry1->start_address != entry2->start_address)
+		return entry1->start_address < entry2->start_address ? -1 : 1;
+	if (entry1->end_address != entry2->end_address)
+		return entry1->end_address < entry2->end_address ? -1 : 1;
+	return entry1->type - entry2->type;
 }
 
 /*
@@ -93,75 +92,182 @@ static char *fwts_memory_map_type_to_str(const int type)
 
 /*
  *  fwts_register_memory_map_line()
- *	add memory_map line entry into a list ordered on start address
+ *	add memory_map line entry, entries are sorted once loading is complete
  */
-static int fwts_register_memory_map_line(fwts_list *memory_map_list, const uint64_t start, const uint64_t end, const int type)
+static int fwts_register_memory_map_line(fwts_memory_map *memory_map, const uint64_t start, const uint64_t end, const int type)
 {
 	fwts_memory_map_entry *entry;
 
-	if ((entry = calloc(1, sizeof(fwts_memory_map_entry))) == NULL)
-		return FWTS_ERROR;
+	if (memory_map->entries_count == memory_map->entries_size) {
+		size_t size = memory_map->entries_size ? memory_map->entries_size * 2 : 64;
 
+		if ((entry = realloc(memory_map->entries, size * sizeof(*entry))) == NULL)
+			return FWTS_ERROR;
+		memory_map->entries = entry;
+		memory_map->entries_size = size;
+	}
+
+	entry = &memory_map->entries[memory_map->entries_count++];
 	entry->start_address = start;
 	entry->end_address   = end;
 	entry->type          = type;
 
-	if (fwts_list_add_ordered(memory_map_list, entry, fwts_fwts_memory_map_entry_compare) == NULL)
-		return FWTS_ERROR;
-
 	return FWTS_OK;
 }
 
 /*
- *  fwts_memory_map_type()
- *	figure out memory region type on a given memory address
+ *  fwts_memory_map_index()
+ *	sort the loaded entries and coalesce them into sorted, disjoint
+ *	regions for binary searching. End addresses are inclusive. Where
+ *	entries overlap, the entry with the lowest start address wins.
  */
-int fwts_memory_map_type(fwts_list *memory_map_list, const uint64_t memory)
+static int fwts_memory_map_index(fwts_memory_map *memory_map)
 {
-	fwts_list_link *item;
+	size_t i, n = 0;
+
+	if (memory_map->entries_count == 0)
+		return FWTS_OK;
+
+	qsort(memory_map->entries, memory_map->entries_count,
+		sizeof(*memory_map->entries), fwts_memory_map_entry_compare);
 
-	fwts_list_foreach(item, memory_map_list) {
-		fwts_memory_map_entry *entry = fwts_list_data(fwts_memory_map_entry*, item);
-		if (entry->start_address <= memory && entry->end_address > memory)
-			return entry->type;
+	/* Each entry adds at most one region */
+	if ((memory_map->regions = calloc(memory_map->entries_count,
+	    sizeof(*memory_map->regions))) == NULL)
+		return FWTS_ERROR;
+
+	for (i = 0; i < memory_map->entries_count; i++) {
+		const fwts_memory_map_entry *entry = &memory_map->entries[i];
+		uint64_t start = entry->start_address;
+
+		if (entry->end_address < start)
+			continue;
+
+		if (n > 0) {
+			fwts_memory_map_entry *last = &memory_map->regions[n - 1];
+
+			/* Already covered by earlier entries? */
+			if (last->end_address >= entry->end_address)
+				continue;
+			/* Clip the part that is covered */
+			if (start <= last->end_address)
+				start = last->end_address + 1;
+			/* Adjacent to a region of the same type, extend it */
+			if ((start == last->end_address + 1) && (last->type == entry->type)) {
+				last->end_address = entry->end_address;
+				continue;
+			}
+		}
+		memory_map->regions[n].start_address = start;
+		memory_map->regions[n].end_address = entry->end_address;
+		memory_map->regions[n].type = entry->type;
+		n++;
 	}
+	memory_map->regions_count = n;
 
-	return FWTS_MEMORY_MAP_UNKNOWN;
+	return FWTS_OK;
 }
 
-fwts_memory_map_entry *fwts_memory_map_info(fwts_list *memory_map_list, const uint64_t memory)
+/*
+ *  fwts_memory_map_region_find()
+ *	binary search for the first region that ends at or after memory,
+ *	returns regions_count if there is none
+ */
+static size_t fwts_memory_map_region_find(fwts_memory_map *memory_map, const uint64_t memory)
 {
-	fwts_list_link *item;
+	size_t lo = 0, hi = memory_map->regions_count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
 
-	fwts_list_foreach(item, memory_map_list) {
-		fwts_memory_map_entry *entry = fwts_list_data(fwts_memory_map_entry*, item);
-		if (entry->start_address <= memory && entry->end_address > memory)
-			return entry;
+		if (memory_map->regions[mid].end_address < memory)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+	return lo;
+}
+
+/*
+ *  fwts_memory_map_info()
+ *	find the memory region containing a given memory address,
+ *	NULL if it is not in the memory map
+ */
+fwts_memory_map_entry *fwts_memory_map_info(fwts_memory_map *memory_map, const uint64_t memory)
+{
+	size_t i;
+
+	if (memory_map == NULL)
+		return NULL;
+
+	i = fwts_memory_map_region_find(memory_map, memory);
+	if ((i < memory_map->regions_count) &&
+	    (memory_map->regions[i].start_address <= memory))
+		return &memory_map->regions[i];
+
 	return NULL;
 }
 
+/*
+ *  fwts_memory_map_type()
+ *	figure out memory region type on a given memory address
+ */
+int fwts_memory_map_type(fwts_memory_map *memory_map, const uint64_t memory)
+{
+	fwts_memory_map_entry *entry = fwts_memory_map_info(memory_map, memory);
+
+	return entry ? entry->type : FWTS_MEMORY_MAP_UNKNOWN;
+}
+
+/*
+ *  fwts_memory_map_overlaps()
+ *	find all the memory regions that intersect [start, end), sets
+ *	regions to the first one and returns how many there are
+ */
+size_t fwts_memory_map_overlaps(
+	fwts_memory_map *memory_map,
+	const uint64_t start,
+	const uint64_t end,
+	fwts_memory_map_entry **regions)
+{
+	size_t i, n;
+
+	*regions = NULL;
+	if ((memory_map == NULL) || (start >= end))
+		return 0;
+
+	i = fwts_memory_map_region_find(memory_map, start);
+	for (n = i; n < memory_map->regions_count; n++)
+		if (memory_map->regions[n].start_address >= end)
+			break;
+
+	if (n > i)
+		*regions = &memory_map->regions[i];
+
+	return n - i;
+}
+
 /*
  *  fwts_memory_map_is_reserved()
  *	determine if a memory region is marked as reserved or not.
  */
-fwts_bool fwts_memory_map_is_reserved(fwts_list *memory_map_list, const uint64_t memory)
+fwts_bool fwts_memory_map_is_reserved(fwts_memory_map *memory_map, const uint64_t memory)
 {
 	int result = FWTS_MEMORY_MAP_UNKNOWN;
 
 	/* when we don't have FWTS_MEMORY_MAP info, assume all is fair */
-	if (memory_map_list == NULL)
+	if (memory_map == NULL)
 		return FWTS_TRUE;
 
 	/* when we have FWTS_MEMORY_MAP info list empty, then assume all is fair */
-	if (memory_map_list->len == 0)
+	if (memory_map->entries_count == 0)
 		return FWTS_TRUE;
 
 	/* bios data area is always reserved */
 	if ((memory >= 640 * 1024) && (memory <= 1024*1024))
 		return FWTS_TRUE;
 
-	result = fwts_memory_map_type(memory_map_list, memory);
+	result = fwts_memory_map_type(memory_map, memory);
 
 	if (result == FWTS_MEMORY_MAP_RESERVED)
 		return FWTS_TRUE;
@@ -179,7 +285,7 @@ static void fwts_memory_map_dmesg_info(void *data, void *private)
 {
 	char *str;
 	char *line = (char *)data;
-	fwts_list *memory_map_list = (fwts_list *)private;
+	fwts_memory_map *memory_map = (fwts_memory_map *)private;
 
 	if ((str = strstr(line,"BIOS-memory_map:")) != NULL) {
 		uint64_t start;
@@ -192,147 +298,147 @@ static void fwts_memory_map_dmesg_info(void *data, void *private)
 			str += 3;
 			end = strtoull(str, NULL, 16) - 1;
 
-			fwts_register_memory_map_line(memory_map_list, start, end, fwts_memory_map_str_to_type(line));
+			fwts_register_memory_map_line(memory_map, start, end, fwts_memory_map_str_to_type(line));
 		}
 	}
 }
 
-/*
- *  fwts_memory_map_dump_info()
- *	callback to dump FWTS_MEMORY_MAP region
- */
-static void fwts_memory_map_dump_info(void *data, void *private)
-{
-	fwts_memory_map_entry *entry = (fwts_memory_map_entry *)data;
-	fwts_framework *fw = (fwts_framework *)private;
-
-	fwts_log_info_verbatim(fw, "0x%16.16" PRIx64 " - 0x%16.16" PRIx64 " %s",
-			entry->start_address, entry->end_address,
-			fwts_memory_map_type_to_str(entry->type));
-}
-
 /*
  *  fwts_memory_map_table_dump()
  *	dump FWTS_MEMORY_MAP region
  */
-void fwts_memory_map_table_dump(fwts_framework *fw, fwts_list *memory_map_list)
+void fwts_memory_map_table_dump(fwts_framework *fw, fwts_memory_map *memory_map)
 {
+	size_t i;
+
 	fwts_log_info_verbatim(fw, "Memory Map Layout");
 	fwts_log_info_verbatim(fw, "-----------------");
 
-	fwts_list_iterate(memory_map_list, fwts_memory_map_dump_info, fw);
+	for (i = 0; i < memory_map->entries_count; i++) {
+		fwts_memory_map_entry *entry = &memory_map->entries[i];
+
+		fwts_log_info_verbatim(fw, "0x%16.16" PRIx64 " - 0x%16.16" PRIx64 " %s",
+				entry->start_address, entry->end_address,
+				fwts_memory_map_type_to_str(entry->type));
+	}
 }
 
 /*
  *  fwts_memory_map_table_load_from_klog()
  *	load memory_map data from the kernel log
  */
-fwts_list *fwts_memory_map_table_load_from_klog(fwts_framework *fw)
+fwts_memory_map *fwts_memory_map_table_load_from_klog(fwts_framework *fw)
 {
 	fwts_list *klog;
-	fwts_list *memory_map_list;
+	fwts_memory_map *memory_map;
 
 	FWTS_UNUSED(fw);
 
 	if ((klog = fwts_klog_read()) == NULL)
 		return NULL;
 
-	if ((memory_map_list = fwts_list_new()) == NULL) {
+	if ((memory_map = calloc(1, sizeof(*memory_map))) == NULL) {
 		fwts_klog_free(klog);
 		return NULL;
 	}
 
-	fwts_list_iterate(klog, fwts_memory_map_dmesg_info, memory_map_list);
+	fwts_list_iterate(klog, fwts_memory_map_dmesg_info, memory_map);
 	fwts_klog_free(klog);
 
-	return memory_map_list;
+	if (fwts_memory_map_index(memory_map) != FWTS_OK) {
+		fwts_memory_map_table_free(memory_map);
+		return NULL;
+	}
+
+	return memory_map;
 }
 
 /*
  *  fwts_memory_map_table_read_entry()
  *	load individual memory_map entry from /sys/firmware/memmap/
  */
-static fwts_memory_map_entry *fwts_memory_map_table_read_entry(const char *which)
+static int fwts_memory_map_table_read_entry(fwts_memory_map *memory_map, const char *which)
 {
 	char path[PATH_MAX];
 	char *data;
-	fwts_memory_map_entry *entry;
-
-	if ((entry = calloc(1, sizeof(fwts_memory_map_entry))) == NULL)
-		return NULL;
+	uint64_t start = 0, end = 0;
 
 	snprintf(path, sizeof(path), "/sys/firmware/memmap/%s/start", which);
-	if ((data = fwts_get(path)) == NULL) {
-		free(entry);
-		return NULL;
-	}
-	sscanf(data, "0x%" SCNx64, &entry->start_address);
+	if ((data = fwts_get(path)) == NULL)
+		return FWTS_ERROR;
+	sscanf(data, "0x%" SCNx64, &start);
 	free(data);
 
 	snprintf(path, sizeof(path), "/sys/firmware/memmap/%s/end", which);
-	if ((data = fwts_get(path)) == NULL) {
-		free(entry);
-		return NULL;
-	}
-	sscanf(data, "0x%" SCNx64, &entry->end_address);
+	if ((data = fwts_get(path)) == NULL)
+		return FWTS_ERROR;
+	sscanf(data, "0x%" SCNx64, &end);
 	free(data);
 
 	snprintf(path, sizeof(path), "/sys/firmware/memmap/%s/type", which);
-	if ((data = fwts_get(path)) == NULL) {
-		free(entry);
-		return NULL;
+	if ((data = fwts_get(path)) == NULL)
+		return FWTS_ERROR;
+	if (fwts_register_memory_map_line(memory_map, start, end,
+	    fwts_memory_map_str_to_type(data)) != FWTS_OK) {
+		free(data);
+		return FWTS_ERROR;
 	}
-	entry->type = fwts_memory_map_str_to_type(data);
 	free(data);
 
-	return entry;
+	return FWTS_OK;
 }
 
 /*
  *  fwts_memory_map_table_load()
  *	load memory_map table from /sys/firmware/memmap/
  */
-fwts_list *fwts_memory_map_table_load(fwts_framework *fw)
+fwts_memory_map *fwts_memory_map_table_load(fwts_framework *fw)
 {
 	DIR *dir;
 	struct dirent *directory;
-	fwts_list *memory_map_list;
+	fwts_memory_map *memory_map;
 
 	/* Try to load from /sys/firmware/memmap, but if we fail, try
 	   scanning the kernel log as a fallback */
 	if ((dir = opendir("/sys/firmware/memmap/")) == NULL)
 		return fwts_memory_map_table_load_from_klog(fw);
 
-	if ((memory_map_list = fwts_list_new()) == NULL) {
+	if ((memory_map = calloc(1, sizeof(*memory_map))) == NULL) {
 		(void)closedir(dir);
 		return NULL;
 	}
 
 	while ((directory = readdir(dir)) != NULL) {
 		if (strncmp(directory->d_name, ".", 1)) {
-			fwts_memory_map_entry *entry;
-
-			entry = fwts_memory_map_table_read_entry(directory->d_name);
-			if (!entry) {
-				fwts_memory_map_table_free(memory_map_list);
+			if (fwts_memory_map_table_read_entry(memory_map, directory->d_name) != FWTS_OK) {
+				fwts_memory_map_table_free(memory_map);
 				(void)closedir(dir);
 				return NULL;
 			}
-			fwts_list_add_ordered(memory_map_list, entry, fwts_fwts_memory_map_entry_compare);
 		}
 	}
 	(void)closedir(dir);
 
-	return memory_map_list;
+	if (fwts_memory_map_index(memory_map) != FWTS_OK) {
+		fwts_memory_map_table_free(memory_map);
+		return NULL;
+	}
+
+	return memory_map;
 }
 
 /*
  *  fwts_memory_map_table_free()
- *	free memory_map list
+ *	free memory_map
  */
-void fwts_memory_map_table_free(fwts_list *memory_map_list)
+void fwts_memory_map_table_free(fwts_memory_map *memory_map)
 {
-	fwts_list_free(memory_map_list, free);
+	if (!memory_map)
+		return;
+
+	free(memory_map->entries);
+	free(memory_map->regions);
+	free(memory_map);
 }
 
 const char *fwts_memory_map_name(const int type)
@@ -18,9 +18,28 @@
  */
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <bsd/string.h>
 
 #include "fwts.h"
 
+/* Size of PCI Express extended config space */
+#define PCI_CONFIG_SIZE_MAX	(4096)
+
+/* Maximum number of capabilities in config and extended config space */
+#define PCI_CAPS_MAX		(48)
+#define PCI_EXT_CAPS_MAX	(960)
+
+/* Snapshot shared by the tests, loaded on first use */
+static fwts_pci_snapshot *pci_snapshot;
+
 /*
  *  class_code, subclass_code --> description mapping
  */
@@ -152,3 +171,388 @@ const char *fwts_pci_description(const uint8_t class_code, const uint8_t subclas
 
 	return "Unknown";
 }
+
+/*
+ *  fwts_pci_snapshot_read_config()
+ *	read up to PCI_CONFIG_SIZE_MAX bytes of config space of a device
+ */
+static int fwts_pci_snapshot_read_config(
+	fwts_framework *fw,
+	const char *path,
+	fwts_pci_snapshot_device *device)
+{
+	char filename[PATH_MAX];
+	uint8_t config[PCI_CONFIG_SIZE_MAX];
+	size_t len = 0;
+	int fd;
+
+	snprintf(filename, sizeof(filename), "%s/%s/config", path, device->name);
+	if ((fd = open(filename, O_RDONLY)) < 0) {
+		fwts_log_warning(fw, "Could not open config from PCI device %s.", device->name);
+		return FWTS_ERROR;
+	}
+	while (len < sizeof(config)) {
+		ssize_t n = read(fd, config + len, sizeof(config) - len);
+
+		if (n < 0) {
+			fwts_log_warning(fw, "Could not read config from PCI device %s.", device->name);
+			(void)close(fd);
+			return FWTS_ERROR;
+		}
+		if (n == 0)
+			break;
+		len += n;
+	}
+	(void)close(fd);
+
+	if ((device->config = malloc(len ? len : 1)) == NULL)
+		return FWTS_ERROR;
+	memcpy(device->config, config, len);
+	device->config_len = len;
+
+	return FWTS_OK;
+}
+
+/*
+ *  fwts_pci_snapshot_caps()
+ *	walk and cache the capability and extended capability chains
+ */
+static int fwts_pci_snapshot_caps(fwts_pci_snapshot_device *device)
+{
+	const uint8_t *config = device->config;
+	fwts_pci_capability caps[PCI_CAPS_MAX];
+	fwts_pci_capability ext_caps[PCI_EXT_CAPS_MAX];
+	size_t n = 0;
+	uint16_t offset;
+
+	if (device->config_len > FWTS_PCI_CONFIG_TYPE0_CAPABILITIES_POINTER) {
+		offset = ((config[FWTS_PCI_CONFIG_HEADER_TYPE] & 0x7f) ==
+			  FWTS_PCI_CONFIG_HEADER_TYPE_CARDBUS_BRIDGE) ?
+			config[FWTS_PCI_CONFIG_TYPE2_CAPABILITY_POINTER] :
+			config[FWTS_PCI_CONFIG_TYPE0_CAPABILITIES_POINTER];
+
+		while ((offset != FWTS_PCI_CAPABILITIES_LAST_ID) &&
+		       (offset + 1U < device->config_len) && (n < PCI_CAPS_MAX)) {
+			caps[n].id = config[offset];
+			caps[n].offset = offset;
+			n++;
+			offset = config[offset + FWTS_PCI_CAPABILITIES_NEXT_POINTER];
+		}
+	}
+	if (n) {
+		if ((device->caps = calloc(n, sizeof(*device->caps))) == NULL)
+			return FWTS_ERROR;
+		memcpy(device->caps, caps, n * sizeof(*caps));
+		device->caps_count = n;
+	}
+
+	/* Extended capabilities start at 0x100 and are only seen with 4K config space */
+	n = 0;
+	for (offset = 0x100; (offset >= 0x100) && (offset + 4U <= device->config_len) &&
+	     (n < PCI_EXT_CAPS_MAX); ) {
+		const uint32_t header = config[offset] |
+			(config[offset + 1] << 8) |
+			(config[offset + 2] << 16) |
+			((uint32_t)config[offset + 3] << 24);
+
+		if ((header == 0) || (header == 0xffffffff))
+			break;
+		ext_caps[n].id = header & 0xffff;
+		ext_caps[n].offset = offset;
+		n++;
+		offset = (header >> 20) & 0xffc;
+	}
+	if (n) {
+		if ((device->ext_caps = calloc(n, sizeof(*device->ext_caps))) == NULL)
+			return FWTS_ERROR;
+		memcpy(device->ext_caps, ext_caps, n * sizeof(*ext_caps));
+		device->ext_caps_count = n;
+	}
+
+	return FWTS_OK;
+}
+
+/*
+ *  fwts_pci_snapshot_device_cmp()
+ *	qsort callback, sort on segment, bus, device, function
+ */
+static int fwts_pci_snapshot_device_cmp(const void *data1, const void *data2)
+{
+	const fwts_pci_snapshot_device *dev1 = (const fwts_pci_snapshot_device *)data1;
+	const fwts_pci_snapshot_device *dev2 = (const fwts_pci_snapshot_device *)data2;
+
+	if (dev1->segment != dev2->segment)
+		return dev1->segment < dev2->segment ? -1 : 1;
+	if (dev1->bus != dev2->bus)
+		return dev1->bus - dev2->bus;
+	if (dev1->dev != dev2->dev)
+		return dev1->dev - dev2->dev;
+	return dev1->func - dev2->func;
+}
+
+/*
+ *  fwts_pci_snapshot_lower_bound()
+ *	index of the first device at or after segment, bus, dev, func
+ */
+static size_t fwts_pci_snapshot_lower_bound(
+	fwts_pci_snapshot *snapshot,
+	const uint32_t segment,
+	const uint8_t bus,
+	const uint8_t dev,
+	const uint8_t func)
+{
+	fwts_pci_snapshot_device key;
+	size_t lo = 0, hi = snapshot->count;
+
+	key.segment = segment;
+	key.bus = bus;
+	key.dev = dev;
+	key.func = func;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (fwts_pci_snapshot_device_cmp(&snapshot->devices[mid], &key) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/*
+ *  fwts_pci_snapshot_free()
+ *	free a PCI snapshot
+ */
+void fwts_pci_snapshot_free(fwts_pci_snapshot *snapshot)
+{
+	size_t i;
+
+	if (!snapshot)
+		return;
+
+	for (i = 0; i < snapshot->count; i++) {
+		free(snapshot->devices[i].config);
+		free(snapshot->devices[i].caps);
+		free(snapshot->devices[i].ext_caps);
+	}
+	free(snapshot->devices);
+	free(snapshot);
+}
+
+/*
+ *  fwts_pci_snapshot_load()
+ *	read the config space of all the PCI devices in path, a
+ *	/sys/bus/pci/devices tree, returns NULL if path cannot be read
+ */
+fwts_pci_snapshot *fwts_pci_snapshot_load(fwts_framework *fw, const char *path)
+{
+	DIR *dirp;
+	struct dirent *entry;
+	fwts_pci_snapshot *snapshot;
+	size_t size = 0, i;
+
+	if ((dirp = opendir(path)) == NULL)
+		return NULL;
+
+	if ((snapshot = calloc(1, sizeof(*snapshot))) == NULL) {
+		(void)closedir(dirp);
+		return NULL;
+	}
+
+	while ((entry = readdir(dirp)) != NULL) {
+		fwts_pci_snapshot_device *device;
+		unsigned int segment, bus, dev, func;
+
+		if (entry->d_name[0] == '.')
+			continue;
+		if ((strlen(entry->d_name) >= sizeof(device->name)) ||
+		    (sscanf(entry->d_name, "%x:%x:%x.%x", &segment, &bus, &dev, &func) != 4))
+			continue;
+
+		if (snapshot->count == size) {
+			size = size ? size * 2 : 256;
+			device = realloc(snapshot->devices, size * sizeof(*device));
+			if (device == NULL) {
+				fwts_pci_snapshot_free(snapshot);
+				(void)closedir(dirp);
+				return NULL;
+			}
+			snapshot->devices = device;
+		}
+		device = &snapshot->devices[snapshot->count];
+		memset(device, 0, sizeof(*device));
+		strlcpy(device->name, entry->d_name, sizeof(device->name));
+		device->segment = segment;
+		device->bus = bus;
+		device->dev = dev;
+		device->func = func;
+
+		if (fwts_pci_snapshot_read_config(fw, path, device) != FWTS_OK)
+			continue;
+		snapshot->count++;
+		if (fwts_pci_snapshot_caps(device) != FWTS_OK) {
+			fwts_pci_snapshot_free(snapshot);
+			(void)closedir(dirp);
+			return NULL;
+		}
+	}
+	(void)closedir(dirp);
+
+	if (snapshot->count > 1)
+		qsort(snapshot->devices, snapshot->count,
+			sizeof(*snapshot->devices), fwts_pci_snapshot_device_cmp);
+
+	/* Index the devices on the secondary bus of each bridge */
+	for (i = 0; i < snapshot->count; i++) {
+		fwts_pci_snapshot_device *device = &snapshot->devices[i];
+
+		if ((device->config_len > FWTS_PCI_CONFIG_TYPE1_SECONDARY_BUS_NUMBER) &&
+		    (device->config[FWTS_PCI_CONFIG_HEADER_TYPE] & 0x01))
+			device->downstream_count = fwts_pci_snapshot_bus(snapshot,
+				device->segment,
+				device->config[FWTS_PCI_CONFIG_TYPE1_SECONDARY_BUS_NUMBER],
+				&device->downstream);
+	}
+
+	return snapshot;
+}
+
+/*
+ *  fwts_pci_snapshot_get()
+ *	get the PCI snapshot shared by all tests, it is loaded on first
+ *	use from fw->pci_dev_path. Returns NULL if it cannot be loaded.
+ */
+fwts_pci_snapshot *fwts_pci_snapshot_get(fwts_framework *fw)
+{
+	if (!pci_snapshot)
+		pci_snapshot = fwts_pci_snapshot_load(fw,
+			fw->pci_dev_path ? fw->pci_dev_path : FWTS_PCI_DEV_PATH);
+
+	return pci_snapshot;
+}
+
+/*
+ *  fwts_pci_snapshot_release()
+ *	free the shared PCI snapshot
+ */
+void fwts_pci_snapshot_release(void)
+{
+	fwts_pci_snapshot_free(pci_snapshot);
+	pci_snapshot = NULL;
+}
+
+/*
+ *  fwts_pci_snapshot_find()
+ *	find a PCI device, NULL if not found
+ */
+fwts_pci_snapshot_device *fwts_pci_snapshot_find(
+	fwts_pci_snapshot *snapshot,
+	const uint32_t segment,
+	const uint8_t bus,
+	const uint8_t dev,
+	const uint8_t func)
+{
+	size_t i;
+
+	if (!snapshot)
+		return NULL;
+
+	i = fwts_pci_snapshot_lower_bound(snapshot, segment, bus, dev, func);
+	if ((i < snapshot->count) &&
+	    (snapshot->devices[i].segment == segment) &&
+	    (snapshot->devices[i].bus == bus) &&
+	    (snapshot->devices[i].dev == dev) &&
+	    (snapshot->devices[i].func == func))
+		return &snapshot->devices[i];
+
+	return NULL;
+}
+
+/*
+ *  fwts_pci_snapshot_find_name()
+ *	find a PCI device from its sysfs name, e.g. 0000:00:1f.3
+ */
+fwts_pci_snapshot_device *fwts_pci_snapshot_find_name(fwts_pci_snapshot *snapshot, const char *name)
+{
+	unsigned int segment, bus, dev, func;
+
+	if (sscanf(name, "%x:%x:%x.%x", &segment, &bus, &dev, &func) != 4)
+		return NULL;
+
+	return fwts_pci_snapshot_find(snapshot, segment, bus, dev, func);
+}
+
+/*
+ *  fwts_pci_snapshot_bus()
+ *	find all the devices on a bus, sets devices to the first one
+ *	and returns how many there are
+ */
+size_t fwts_pci_snapshot_bus(
+	fwts_pci_snapshot *snapshot,
+	const uint32_t segment,
+	const uint8_t bus,
+	fwts_pci_snapshot_device **devices)
+{
+	size_t i, n;
+
+	*devices = NULL;
+	if (!snapshot)
+		return 0;
+
+	i = fwts_pci_snapshot_lower_bound(snapshot, segment, bus, 0, 0);
+	for (n = i; n < snapshot->count; n++)
+		if ((snapshot->devices[n].segment != segment) ||
+		    (snapshot->devices[n].bus != bus))
+			break;
+
+	if (n > i)
+		*devices = &snapshot->devices[i];
+
+	return n - i;
+}
+
+/*
+ *  fwts_pci_capability_find()
+ *	offset of capability id in config space, 0 if not found
+ */
+uint16_t fwts_pci_capability_find(const fwts_pci_snapshot_device *device, const uint8_t id)
+{
+	size_t i;
+
+	for (i = 0; i < device->caps_count; i++)
+		if (device->caps[i].id == id)
+			return device->caps[i].offset;
+
+	return 0;
+}
+
+/*
+ *  fwts_pci_ext_capability_find()
+ *	offset of extended capability id in config space, 0 if not found
+ */
+uint16_t fwts_pci_ext_capability_find(const fwts_pci_snapshot_device *device, const uint16_t id)
+{
+	size_t i;
+
+	for (i = 0; i < device->ext_caps_count; i++)
+		if (device->ext_caps[i].id == id)
+			return device->ext_caps[i].offset;
+
+	return 0;
+}
+
+/*
+ *  fwts_pci_pcie_capability()
+ *	the PCI Express capability structure of a device, NULL if it has
+ *	none or the structure is not all in the config space that was read
+ */
+fwts_pcie_capability *fwts_pci_pcie_capability(const fwts_pci_snapshot_device *device)
+{
+	uint16_t offset = fwts_pci_capability_find(device, FWTS_PCI_EXPRESS_CAP_ID);
+
+	if ((offset == 0) || (offset + sizeof(fwts_pcie_capability) > device->config_len))
+		return NULL;
+
+	return (fwts_pcie_capability *)&device->config[offset];
+}
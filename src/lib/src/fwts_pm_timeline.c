@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2021 Canonical
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "fwts.h"
+#include "fwts_pm_method.h"
+
+/*
+ *  Kernel log messages that mark the phases of a suspend or
+ *  hibernate cycle, a line is checked for all of them in one pass
+ */
+enum {
+	PM_FWTS_SUSPEND,
+	PM_FWTS_HIBERNATE,
+	PM_STARTING_SUSPEND,
+	PM_STARTING_HIBERNATE,
+	PM_SUSPEND_ENTRY,
+	PM_HIBERNATION_ENTRY,
+	PM_FWTS_RESUME,
+	PM_SAVING_NVS,
+	PM_SMPBOOT_CPU,
+	PM_CPU_OFFLINE,
+	PM_LOW_LEVEL_RESUME,
+	PM_WAKING_S3,
+	PM_WAKING_S4,
+	PM_S2IDLE_ENTER,
+	PM_S2IDLE_EXIT,
+	PM_TIMEKEEPING_SUSPENDED,
+	PM_RESTARTING_TASKS,
+};
+
+typedef struct {
+	const char *str;
+	const size_t len;
+} fwts_pm_marker;
+
+#define PM_MARKER(str)	{ str, sizeof(str) - 1 }
+
+static const fwts_pm_marker pm_markers[] = {
+	[PM_FWTS_SUSPEND]		= PM_MARKER(FWTS_SUSPEND),
+	[PM_FWTS_HIBERNATE]		= PM_MARKER(FWTS_HIBERNATE),
+	[PM_STARTING_SUSPEND]		= PM_MARKER("Starting fwts suspend"),
+	[PM_STARTING_HIBERNATE]		= PM_MARKER("Starting fwts hibernate"),
+	[PM_SUSPEND_ENTRY]		= PM_MARKER("PM: suspend entry"),
+	[PM_HIBERNATION_ENTRY]		= PM_MARKER("hibernation entry"),
+	[PM_FWTS_RESUME]		= PM_MARKER(FWTS_RESUME),
+	[PM_SAVING_NVS]			= PM_MARKER("PM: Saving platform NVS memory"),
+	[PM_SMPBOOT_CPU]		= PM_MARKER("smpboot: CPU"),
+	[PM_CPU_OFFLINE]		= PM_MARKER("is now offline"),
+	[PM_LOW_LEVEL_RESUME]		= PM_MARKER("ACPI: Low-level resume complete"),
+	[PM_WAKING_S3]			= PM_MARKER("ACPI: Waking up from system sleep state S3"),
+	[PM_WAKING_S4]			= PM_MARKER("ACPI: Waking up from system sleep state S4"),
+	[PM_S2IDLE_ENTER]		= PM_MARKER("PM: suspend-to-idle"),
+	[PM_S2IDLE_EXIT]		= PM_MARKER("PM: resume from suspend-to-idle"),
+	[PM_TIMEKEEPING_SUSPENDED]	= PM_MARKER("PM: Timekeeping suspended"),
+	[PM_RESTARTING_TASKS]		= PM_MARKER("Restarting tasks ... done"),
+};
+
+#define PM_FOUND(found, marker)	((found) & (1U << (marker)))
+
+static const char *pm_timeline_names[][2] = {
+	[FWTS_PM_TIMELINE_SUSPEND]	= { "Suspend", "suspend" },
+	[FWTS_PM_TIMELINE_HIBERNATE]	= { "Hibernate", "hibernate" },
+};
+
+/*
+ *  fwts_pm_timeline_init()
+ *	initialise a timeline of a suspend or hibernate cycle
+ */
+void fwts_pm_timeline_init(fwts_pm_timeline *timeline, const fwts_pm_timeline_type type)
+{
+	timeline->type = type;
+	timeline->suspend_start = -1.0;
+	timeline->suspend_finish = -1.0;
+	timeline->resume_start = -1.0;
+	timeline->resume_finish = -1.0;
+	timeline->s2idle_enter = -1.0;
+	timeline->s2idle_exit = -1.0;
+}
+
+/*
+ *  fwts_pm_timeline_scan()
+ *	scan the kernel log of a suspend or hibernate cycle and fill
+ *	in the time stamps of each phase of the cycle. Each line is
+ *	walked just once, only checking the markers that start with the
+ *	current two characters, and the time stamp is only parsed once
+ */
+void fwts_pm_timeline_scan(fwts_list *klog, fwts_pm_timeline *timeline)
+{
+	fwts_list_link *item;
+	uint32_t first[256], second[256];
+	double previous_ts = -1.0, ts = 0.0;
+	size_t i;
+
+	/* Markers that have a given first and second character */
+	memset(first, 0, sizeof(first));
+	memset(second, 0, sizeof(second));
+	for (i = 0; i < FWTS_ARRAY_SIZE(pm_markers); i++) {
+		first[(unsigned char)pm_markers[i].str[0]] |= 1U << i;
+		second[(unsigned char)pm_markers[i].str[1]] |= 1U << i;
+	}
+
+	fwts_list_foreach(item, klog) {
+		const char *txt = (const char *)item->data;
+		const char *bracket = NULL, *ptr;
+		uint32_t found = 0;
+		char *end;
+		double val;
+
+		for (ptr = txt; *ptr; ptr++) {
+			uint32_t markers = first[(unsigned char)ptr[0]];
+
+			if (*ptr == '[' && !bracket)
+				bracket = ptr;
+			if (markers)
+				markers &= second[(unsigned char)ptr[1]];
+			for (i = 0; markers; i++, markers >>= 1) {
+				if ((markers & 1) &&
+				    !strncmp(ptr, pm_markers[i].str, pm_markers[i].len))
+					found |= 1U << i;
+			}
+		}
+
+		if ((ptr - txt < 15) || bracket == NULL)
+			continue;
+
+		previous_ts = ts;
+
+		/* Get log time stamp */
+		val = strtod(bracket + 1, &end);
+		if (end != bracket + 1)
+			ts = val;
+
+		if (!found)
+			continue;
+
+		if (PM_FOUND(found, PM_FWTS_SUSPEND) ||
+		    PM_FOUND(found, PM_STARTING_SUSPEND) ||
+		    PM_FOUND(found, PM_FWTS_HIBERNATE) ||
+		    PM_FOUND(found, PM_STARTING_HIBERNATE)) {
+			timeline->suspend_start = ts;
+			continue;
+		}
+
+		/* Update log time if this is available */
+		if (PM_FOUND(found, PM_SUSPEND_ENTRY) ||
+		    PM_FOUND(found, PM_HIBERNATION_ENTRY)) {
+			timeline->suspend_start = ts;
+			continue;
+		}
+
+		if (PM_FOUND(found, PM_FWTS_RESUME)) {
+			timeline->resume_finish = ts;
+			continue;
+		}
+		/* This may be the last message we see from the kernel */
+		if (PM_FOUND(found, PM_SAVING_NVS)) {
+			timeline->suspend_finish = ts;
+			continue;
+		}
+		/* And this may appear even later */
+		if (PM_FOUND(found, PM_SMPBOOT_CPU) &&
+		    PM_FOUND(found, PM_CPU_OFFLINE)) {
+			timeline->suspend_finish = ts;
+			continue;
+		}
+
+		if (PM_FOUND(found, PM_LOW_LEVEL_RESUME)) {
+			timeline->resume_start = ts;
+			if (timeline->suspend_finish < 0.0)
+				timeline->suspend_finish = previous_ts;
+			continue;
+		}
+		if (timeline->resume_start < 0.0 &&
+		    (PM_FOUND(found, PM_WAKING_S3) || PM_FOUND(found, PM_WAKING_S4))) {
+			timeline->resume_start = ts;
+			if (timeline->suspend_finish < 0.0)
+				timeline->suspend_finish = previous_ts;
+			continue;
+		}
+
+		/* get log time for s2idle */
+		if (PM_FOUND(found, PM_S2IDLE_ENTER)) {
+			timeline->s2idle_enter = ts;
+			timeline->suspend_finish = ts;
+			continue;
+		}
+		if (PM_FOUND(found, PM_S2IDLE_EXIT))
+			timeline->s2idle_exit = ts;
+		if (PM_FOUND(found, PM_TIMEKEEPING_SUSPENDED)) {
+			timeline->resume_start = ts;
+			if (timeline->suspend_finish < 0.0)
+				timeline->suspend_finish = previous_ts;
+			continue;
+		}
+
+		if (PM_FOUND(found, PM_RESTARTING_TASKS)) {
+			timeline->resume_finish = ts;
+			break;
+		}
+	}
+}
+
+/*
+ *  fwts_pm_timeline_suspend_time()
+ *	get the time taken to suspend in seconds, returns false
+ *	if it is not known
+ */
+bool fwts_pm_timeline_suspend_time(const fwts_pm_timeline *timeline, double *seconds)
+{
+	if (timeline->suspend_start > 0.0 && timeline->suspend_finish > 0.0) {
+		*seconds = timeline->suspend_finish - timeline->suspend_start;
+		return true;
+	}
+	return false;
+}
+
+/*
+ *  fwts_pm_timeline_resume_time()
+ *	get the time taken to resume in seconds, returns false
+ *	if it is not known
+ */
+bool fwts_pm_timeline_resume_time(const fwts_pm_timeline *timeline, double *seconds)
+{
+	if (timeline->resume_start > 0.0 && timeline->resume_finish > 0.0) {
+		*seconds = timeline->resume_finish - timeline->resume_start;
+		return true;
+	}
+	return false;
+}
+
+/*
+ *  fwts_pm_timeline_log()
+ *	log the suspend and resume times of a cycle
+ */
+void fwts_pm_timeline_log(fwts_framework *fw, const fwts_pm_timeline *timeline)
+{
+	const char *name = pm_timeline_names[timeline->type][0];
+	const int width = (int)strlen(name) + 1;
+	double suspend_time, resume_time;
+	char label[32];
+
+	fwts_log_info(fw, "%s/Resume Timings:", name);
+	snprintf(label, sizeof(label), "%s:", name);
+	if (fwts_pm_timeline_suspend_time(timeline, &suspend_time))
+		fwts_log_info_verbatim(fw, "  %-*s %.3f seconds.", width, label, suspend_time);
+	else
+		fwts_log_info_verbatim(fw, "  Could not determine time to %s.",
+			pm_timeline_names[timeline->type][1]);
+
+	if (fwts_pm_timeline_resume_time(timeline, &resume_time))
+		fwts_log_info_verbatim(fw, "  %-*s %.3f seconds.", width, "Resume:", resume_time);
+	else
+		fwts_log_info_verbatim(fw, "  Could not determine time to resume.");
+
+	if (timeline->s2idle_enter > 0.0 && timeline->s2idle_exit > 0.0)
+		fwts_log_info_verbatim(fw, "  Suspend-to-idle for %.3f seconds.",
+			timeline->s2idle_exit - timeline->s2idle_enter);
+}
+
+/*
+ *  fwts_pm_timeline_stats_init()
+ *	initialise the statistics of a number of cycles
+ */
+void fwts_pm_timeline_stats_init(fwts_pm_timeline_stats *stats, const fwts_pm_timeline_type type)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->type = type;
+}
+
+/*
+ *  fwts_pm_timeline_stats_add()
+ *	add the suspend and resume times of a cycle to the statistics
+ */
+void fwts_pm_timeline_stats_add(fwts_pm_timeline_stats *stats, const fwts_pm_timeline *timeline)
+{
+	double suspend_time, resume_time;
+
+	stats->cycles++;
+
+	if (fwts_pm_timeline_suspend_time(timeline, &suspend_time)) {
+		if (!stats->suspends || suspend_time < stats->suspend_min)
+			stats->suspend_min = suspend_time;
+		if (!stats->suspends || suspend_time > stats->suspend_max)
+			stats->suspend_max = suspend_time;
+		stats->suspend_total += suspend_time;
+		stats->suspends++;
+	}
+
+	if (fwts_pm_timeline_resume_time(timeline, &resume_time)) {
+		if (!stats->resumes || resume_time < stats->resume_min)
+			stats->resume_min = resume_time;
+		if (!stats->resumes || resume_time > stats->resume_max)
+			stats->resume_max = resume_time;
+		stats->resume_total += resume_time;
+		stats->resumes++;
+	}
+}
+
+/*
+ *  fwts_pm_timeline_stats_log()
+ *	log the minimum, average and maximum suspend and resume times
+ */
+void fwts_pm_timeline_stats_log(fwts_framework *fw, const fwts_pm_timeline_stats *stats)
+{
+	const char *name = pm_timeline_names[stats->type][0];
+	const int width = (int)strlen(name) + 1;
+	char label[32];
+
+	fwts_log_info(fw, "%s/Resume Timings over %d cycle%s:",
+		name, stats->cycles, stats->cycles == 1 ? "" : "s");
+	snprintf(label, sizeof(label), "%s:", name);
+	if (stats->suspends)
+		fwts_log_info_verbatim(fw, "  %-*s min %.3f, avg %.3f, max %.3f seconds (%d of %d cycles).",
+			width, label, stats->suspend_min,
+			stats->suspend_total / stats->suspends,
+			stats->suspend_max, stats->suspends, stats->cycles);
+	else
+		fwts_log_info_verbatim(fw, "  Could not determine time to %s.",
+			pm_timeline_names[stats->type][1]);
+
+	if (stats->resumes)
+		fwts_log_info_verbatim(fw, "  %-*s min %.3f, avg %.3f, max %.3f seconds (%d of %d cycles).",
+			width, "Resume:", stats->resume_min,
+			stats->resume_total / stats->resumes,
+			stats->resume_max, stats->resumes, stats->cycles);
+	else
+		fwts_log_info_verbatim(fw, "  Could not determine time to resume.");
+}
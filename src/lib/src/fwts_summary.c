@@ -38,9 +38,21 @@ enum {
 	SUMMARY_MAX = SUMMARY_UNKNOWN+1
 };
 
-/* list of summary items per error level */
+/* error level of each summary list */
+static const fwts_log_level summary_levels[] = {
+	LOG_LEVEL_CRITICAL,
+	LOG_LEVEL_HIGH,
+	LOG_LEVEL_MEDIUM,
+	LOG_LEVEL_LOW,
+	LOG_LEVEL_NONE
+};
+
+/* list of summary items per error level, in the order they were added */
 static fwts_list *fwts_summaries[SUMMARY_MAX];
 
+/* summary items per error level hashed on their text */
+static fwts_hash *fwts_summaries_hash[SUMMARY_MAX];
+
 /*
  *  fwts_summary_init()
  *	initialise
@@ -51,7 +63,8 @@ int fwts_summary_init(void)
 
 	/* initialise list of summary items for all error levels */
 	for (i = 0; i < SUMMARY_MAX; i++)
-		if ((fwts_summaries[i] = fwts_list_new()) == NULL) {
+		if (((fwts_summaries[i] = fwts_list_new()) == NULL) ||
+		    ((fwts_summaries_hash[i] = fwts_hash_new(0)) == NULL)) {
 			fwts_summary_deinit();
 			return FWTS_ERROR;
 		}
@@ -80,9 +93,15 @@ void fwts_summary_deinit(void)
 {
 	int i;
 
-	for (i = 0; i < SUMMARY_MAX; i++)
-		if (fwts_summaries[i])
+	for (i = 0; i < SUMMARY_MAX; i++) {
+		/* Hash keys are owned by the summary items, so free the hash first */
+		fwts_hash_free(fwts_summaries_hash[i], NULL);
+		fwts_summaries_hash[i] = NULL;
+		if (fwts_summaries[i]) {
 			fwts_list_free(fwts_summaries[i], fwts_summary_item_free);
+			fwts_summaries[i] = NULL;
+		}
+	}
 }
 
 static int fwts_summary_level_to_index(const fwts_log_level level)
@@ -112,25 +131,15 @@ int fwts_summary_add(
 	const fwts_log_level level,
 	const char *text)
 {
-	fwts_list_link	*item;
-	fwts_summary_item *summary_item = NULL;
-	bool summary_item_found = false;
+	fwts_summary_item *summary_item;
 	int index = fwts_summary_level_to_index(level);
 
 	if (FWTS_LEVEL_IGNORE(fw, level))
 		return FWTS_OK;
 
-	/* Does the text already exist? - search for it */
-	fwts_list_foreach(item, fwts_summaries[index]) {
-		summary_item = fwts_list_data(fwts_summary_item *,item);
-		if (strcmp(text, summary_item->text) == 0) {
-			summary_item_found = true;
-			break;
-		}
-	}
-
-	/* Not found, create a new one */
-	if (!summary_item_found) {
+	/* Does the text already exist? - look it up */
+	if (fwts_hash_get(fwts_summaries_hash[index], text) == NULL) {
+		/* Not found, create a new one */
 		if ((summary_item = calloc(1, sizeof(fwts_summary_item))) == NULL)
 			return FWTS_ERROR;
 
@@ -147,12 +156,85 @@ int fwts_summary_add(
 		fwts_chop_newline(summary_item->text);
 
 		/* And append new item if not done so already */
-		fwts_list_append(fwts_summaries[index], summary_item);
+		if (fwts_list_append(fwts_summaries[index], summary_item) == NULL) {
+			fwts_summary_item_free(summary_item);
+			return FWTS_ERROR;
+		}
+		(void)fwts_hash_add(fwts_summaries_hash[index], summary_item->text, summary_item);
 	}
 
 	return FWTS_OK;
 }
 
+/*
+ *  fwts_summary_save()
+ *	write all the summary items to fp in the order they were
+ *	added so that fwts_summary_load() can add them to the
+ *	summary of another process
+ */
+int fwts_summary_save(FILE *fp)
+{
+	int i;
+
+	for (i = 0; i < SUMMARY_MAX; i++) {
+		fwts_list_link *item;
+
+		if (!fwts_summaries[i])
+			continue;
+
+		fwts_list_foreach(item, fwts_summaries[i]) {
+			fwts_summary_item *summary_item = fwts_list_data(fwts_summary_item *, item);
+			uint32_t hdr[3];
+
+			hdr[0] = i;
+			hdr[1] = strlen(summary_item->test);
+			hdr[2] = strlen(summary_item->text);
+
+			if ((fwrite(hdr, sizeof(hdr), 1, fp) != 1) ||
+			    (fwrite(summary_item->test, 1, hdr[1], fp) != hdr[1]) ||
+			    (fwrite(summary_item->text, 1, hdr[2], fp) != hdr[2]))
+				return FWTS_ERROR;
+		}
+	}
+	return fflush(fp) ? FWTS_ERROR : FWTS_OK;
+}
+
+/*
+ *  fwts_summary_load()
+ *	add the summary items written by fwts_summary_save() from
+ *	fp, items that are already in the summary are ignored
+ */
+int fwts_summary_load(fwts_framework *fw, FILE *fp)
+{
+	uint32_t hdr[3];
+	int ret = FWTS_OK;
+
+	while (fread(hdr, sizeof(hdr), 1, fp) == 1) {
+		char *test, *text;
+
+		if (hdr[0] >= SUMMARY_MAX)
+			return FWTS_ERROR;
+
+		test = malloc((size_t)hdr[1] + 1);
+		text = malloc((size_t)hdr[2] + 1);
+		if (!test || !text ||
+		    (fread(test, 1, hdr[1], fp) != hdr[1]) ||
+		    (fread(text, 1, hdr[2], fp) != hdr[2])) {
+			free(test);
+			free(text);
+			return FWTS_ERROR;
+		}
+		test[hdr[1]] = '\0';
+		text[hdr[2]] = '\0';
+
+		if (fwts_summary_add(fw, test, summary_levels[hdr[0]], text) != FWTS_OK)
+			ret = FWTS_ERROR;
+		free(test);
+		free(text);
+	}
+	return ret;
+}
+
 static void fwts_summary_format_field(
 	char *buffer,
 	const int buflen,
@@ -178,14 +260,6 @@ int fwts_summary_report(fwts_framework *fw, fwts_list *test_list)
 		"Other"
 	};
 
-	static const int summary_levels[] = {
-		LOG_LEVEL_CRITICAL,
-		LOG_LEVEL_HIGH,
-		LOG_LEVEL_MEDIUM,
-		LOG_LEVEL_LOW,
-		LOG_LEVEL_NONE
-	};
-
 	int i;
 
 	fwts_log_summary(fw, "Test Failure Summary");
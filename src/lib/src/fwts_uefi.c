@@ -34,6 +34,7 @@
 #include "fwts.h"
 #include "fwts_uefi.h"
 #include "fwts_efi_runtime.h"
+#include "fwts_efi_module.h"
 
 /* Old sysfs uefi packed binary blob variables */
 typedef struct {
@@ -554,7 +555,7 @@ void fwts_uefi_rt_support_status_get(int fd, uint32_t *rtservicessupported)
 {
 	long ioret;
 
-	ioret = ioctl(fd, EFI_RUNTIME_GET_SUPPORTED_MASK, rtservicessupported);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_SUPPORTED_MASK, rtservicessupported);
 	if (ioret == -1)
 		*rtservicessupported = EFI_RT_SUPPORTED_ALL;
 
@@ -1047,9 +1047,15 @@ int fwts_acpica_init(fwts_framework *fw)
 	UINT32 init_flags = ACPI_FULL_INITIALIZATION;
 	fwts_acpi_table_info *table;
 
-	/* Abort if already initialised */
-	if (fwts_acpica_init_called)
-		return FWTS_ERROR;
+	/*
+	 * If already initialised, close down the idle shared session
+	 * left running by fwts_acpi_deinit(), abort if it is in use
+	 */
+	if (fwts_acpica_init_called) {
+		(void)fwts_acpi_release();
+		if (fwts_acpica_init_called)
+			return FWTS_ERROR;
+	}
 
 	AcpiGbl_AutoSerializeMethods =
 		FWTS_ACPICA_MODE(fw, FWTS_ACPICA_MODE_SERIALIZED);
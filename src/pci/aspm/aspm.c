@@ -70,33 +70,18 @@ static int facp_get_aspm_control(fwts_framework *fw)
 }
 
 static int pcie_compare_rp_dev_aspm_registers(fwts_framework *fw,
-	fwts_pci_device *rp,
-	fwts_pci_device *dev)
+	fwts_pci_snapshot_device *rp,
+	fwts_pci_snapshot_device *dev)
 {
 	fwts_pcie_capability *rp_cap, *device_cap;
 	uint8_t rp_aspm_cntrl, device_aspm_cntrl;
-	uint8_t next_cap;
 	int ret = FWTS_OK;
 	bool l0s_disabled = false, l1_disabled = false;
 
-	next_cap = rp->config[FWTS_PCI_CONFIG_TYPE1_CAPABILITY_POINTER];
-	rp_cap = (fwts_pcie_capability *) &rp->config[next_cap];
-	while (rp_cap->pcie_cap_id != FWTS_PCI_EXPRESS_CAP_ID) {
-		if (rp_cap->next_cap_point == FWTS_PCI_CAPABILITIES_LAST_ID)
-			break;
-		next_cap = rp_cap->next_cap_point;
-		rp_cap = (fwts_pcie_capability *) &rp->config[next_cap];
-	}
-
-	next_cap = dev->config[FWTS_PCI_CONFIG_TYPE1_CAPABILITY_POINTER];
-	device_cap = (fwts_pcie_capability *)&dev->config[next_cap];
-	while (device_cap->pcie_cap_id != FWTS_PCI_EXPRESS_CAP_ID) {
-		if (device_cap->next_cap_point == FWTS_PCI_CAPABILITIES_LAST_ID)
-			break;
-		next_cap = device_cap->next_cap_point;
-		device_cap = (fwts_pcie_capability *)&dev->config[next_cap];
-	}
-
+	/* Not a PCI Express link, so no ASPM */
+	if (((rp_cap = fwts_pci_pcie_capability(rp)) == NULL) ||
+	    ((device_cap = fwts_pci_pcie_capability(dev)) == NULL))
+		return FWTS_OK;
 
 	if (((rp_cap->link_cap & FWTS_PCIE_ASPM_SUPPORT_L0_FIELD) >> 10) !=
 		(rp_cap->link_contrl & FWTS_PCIE_ASPM_CONTROL_L0_FIELD)) {
@@ -168,77 +153,21 @@ static int pcie_compare_rp_dev_aspm_registers(fwts_framework *fw,
 
 static int pcie_check_aspm_registers(fwts_framework *fw)
 {
-	DIR *dirp;
-	struct dirent *entry;
-	fwts_list dev_list;
-	fwts_list_link *lcur, *ltarget;
+	fwts_pci_snapshot *snapshot;
+	size_t i;
 
-	fwts_list_init(&dev_list);
-
-	if ((dirp = opendir(FWTS_PCI_DEV_PATH)) == NULL) {
-		fwts_log_warning(fw, "Could not open %s.", FWTS_PCI_DEV_PATH);
+	if ((snapshot = fwts_pci_snapshot_get(fw)) == NULL) {
+		fwts_log_warning(fw, "Could not open %s.", fw->pci_dev_path);
 		return FWTS_ERROR;
 	}
-	while ((entry = readdir(dirp)) != NULL) {
-		uint8_t bus, dev, func;
-		uint16_t segment;
-
-		if (entry->d_name[0] == '.')
-			continue;
-
-		if (sscanf(entry->d_name, "%" SCNx16 ":%" SCNx8 ":%" SCNx8 ".%" SCNx8, &segment, &bus, &dev, &func) == 4) {
-			int fd;
-			char path[PATH_MAX];
-			fwts_pci_device *device;
-
-			device = (fwts_pci_device *)calloc(1, sizeof(fwts_pci_device));
-			if (device == NULL) {
-				fwts_list_free_items(&dev_list, free);
-				closedir(dirp);
-				return FWTS_ERROR;
-			}
-			device->segment = segment;
-			device->bus = bus;
-			device->dev = dev;
-			device->func = func;
-
-			snprintf(path, sizeof(path), FWTS_PCI_DEV_PATH "/%s/config", entry->d_name);
-			if ((fd = open(path, O_RDONLY)) < 0) {
-				fwts_log_warning(fw, "Could not open config from PCI device %s\n", entry->d_name);
-				free(device);
-				continue;
-			}
-
-			if (read(fd, device->config, sizeof(device->config)) < 0) {
-				fwts_log_warning(fw, "Could not read config from PCI device %s\n", entry->d_name);
-				free(device);
-				(void)close(fd);
-				continue;
-			}
-			(void)close(fd);
-			fwts_list_append(&dev_list, device);
-		}
-	}
-	closedir(dirp);
-
-	/* Check aspm registers from the list of pci devices */
-	for (lcur = dev_list.head; lcur; lcur = lcur->next) {
-		fwts_pci_device *cur = (fwts_pci_device *)lcur->data;
-
-		/* Find PCI Bridge (PCIE Root Port) and the attached device  */
-		if (cur->config[FWTS_PCI_CONFIG_HEADER_TYPE] & 0x01) {
-			for (ltarget = dev_list.head; ltarget; ltarget = ltarget->next) {
-				fwts_pci_device *target = (fwts_pci_device *)ltarget->data;
-				if (target->segment == cur->segment) {
-					if (target->bus == cur->config[FWTS_PCI_CONFIG_TYPE1_SECONDARY_BUS_NUMBER]) {
-						pcie_compare_rp_dev_aspm_registers(fw, cur, target);
-						break;
-					}
-				}
-			}
-		}
+
+	/* Check aspm registers of each PCI Bridge (PCIE Root Port) and the attached device */
+	for (i = 0; i < snapshot->count; i++) {
+		fwts_pci_snapshot_device *cur = &snapshot->devices[i];
+
+		if (cur->downstream_count)
+			pcie_compare_rp_dev_aspm_registers(fw, cur, cur->downstream);
 	}
-	fwts_list_free_items(&dev_list, free);
 
 	return FWTS_OK;
 }
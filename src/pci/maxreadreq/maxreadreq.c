@@ -34,9 +34,9 @@
 
 static int maxreadreq_init(fwts_framework *fw)
 {
-	if (access(FWTS_PCI_DEV_PATH, R_OK) < 0) {
+	if (access(fw->pci_dev_path, R_OK) < 0) {
 		fwts_log_info(fw, "Could not access %s, skipping test",
-			FWTS_PCI_DEV_PATH);
+			fw->pci_dev_path);
 		return FWTS_SKIP;
 	}
 	return FWTS_OK;
@@ -48,38 +48,24 @@ static int maxreadreq_init(fwts_framework *fw)
  */
 static int maxreadreq_test1(fwts_framework *fw)
 {
-	DIR *dirp;
-	struct dirent *entry;
+	fwts_pci_snapshot *snapshot;
 	int warnings = 0;
+	size_t i;
 
-	if ((dirp = opendir(FWTS_PCI_DEV_PATH)) == NULL) {
-		fwts_log_warning(fw, "Could not open %s.", FWTS_PCI_DEV_PATH);
+	if ((snapshot = fwts_pci_snapshot_get(fw)) == NULL) {
+		fwts_log_warning(fw, "Could not open %s.", fw->pci_dev_path);
 		return FWTS_ERROR;
 	}
 
-	while ((entry = readdir(dirp)) != NULL) {
-		char path[PATH_MAX];
-		uint8_t config[256];
-		int fd;
-		ssize_t n;
-		uint8_t offset = 0;
+	for (i = 0; i < snapshot->count; i++) {
+		fwts_pci_snapshot_device *device = &snapshot->devices[i];
+		const uint8_t *config = device->config;
+		fwts_pcie_capability *cap;
 		uint16_t vendor_id;
 
-		if (entry->d_name[0] == '.')
-			continue;
-
-		/* Read Config space */
-		snprintf(path, sizeof(path), FWTS_PCI_DEV_PATH "/%s/config", entry->d_name);
-		if ((fd = open(path, O_RDONLY)) < 0) {
-			fwts_log_warning(fw, "Could not open %s PCI config data\n", entry->d_name);
-			continue;
-		}
-		if ((n = read(fd, config, sizeof(config))) < 0) {
-			fwts_log_warning(fw, "Could not read %s PCI config data\n", entry->d_name);
-			(void)close(fd);
+		/* config region too small, do next */
+		if (device->config_len < FWTS_PCI_CONFIG_TYPE0_CAPABILITIES_POINTER)
 			continue;
-		}
-		(void)close(fd);
 
 		/* Ignore Host Bridge */
 		if ((config[FWTS_PCI_CONFIG_CLASS_CODE] == FWTS_PCI_CLASS_CODE_BRIDGE_CONTROLLER) &&
@@ -104,32 +90,17 @@ static int maxreadreq_test1(fwts_framework *fw)
 		    (vendor_id == FWTS_PCI_INTEL_VENDOR_ID))
 			continue;
 
-		/* config region too small, do next */
-		if (n < FWTS_PCI_CONFIG_TYPE0_CAPABILITIES_POINTER)
-			continue;
-		offset = config[FWTS_PCI_CONFIG_TYPE0_CAPABILITIES_POINTER];
-
-		/*
-		 *  Step through capability structures and
-		 *  examine MaxReadReq settings
-		 */
-		while ((offset != FWTS_PCI_CAPABILITIES_LAST_ID) &&
-		       (offset > 0) && ((ssize_t)(offset + sizeof(fwts_pcie_capability)) <= n)) {
-			fwts_pcie_capability *cap = (fwts_pcie_capability *)&config[offset];
-
-			if (cap->pcie_cap_id == FWTS_PCI_EXPRESS_CAP_ID) {
-				uint32_t max_readreq = 128 << ((cap->device_contrl >> 12) & 0x3);
-				if (max_readreq <= 128) {
-					fwts_log_warning(fw,
-						"MaxReadReq for %s is low (%" PRIu32 ").",
-						entry->d_name, max_readreq);
-					warnings++;
-				}
+		/* Examine the MaxReadReq setting in the PCI Express capability */
+		if ((cap = fwts_pci_pcie_capability(device)) != NULL) {
+			uint32_t max_readreq = 128 << ((cap->device_contrl >> 12) & 0x3);
+			if (max_readreq <= 128) {
+				fwts_log_warning(fw,
+					"MaxReadReq for %s is low (%" PRIu32 ").",
+					device->name, max_readreq);
+				warnings++;
 			}
-			offset = cap->next_cap_point;
 		}
 	}
-	(void)closedir(dirp);
 
 	if (warnings > 0) {
 		fwts_failed(fw, LOG_LEVEL_LOW,
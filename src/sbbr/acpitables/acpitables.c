@@ -241,18 +241,12 @@ static const char *recommended_acpi_tables[] = {
 /* Searches ACPI tables by signature. */
 static fwts_acpi_table_info *sbbr_search_acpi_tables(fwts_framework *fw, const char *signature)
 {
-	uint32_t i;
 	fwts_acpi_table_info *info;
 
-	i = 0;
-	while (fwts_acpi_get_table(fw, i, &info) == FWTS_OK) {
-		if (info != NULL && strncmp(info->name, signature, sizeof(uint32_t)) == 0) {
-			return info;
-		}
-		i++;
-	}
+	if (fwts_acpi_find_table(fw, signature, 0, &info) != FWTS_OK)
+		return NULL;
 
-	return NULL;
+	return info;
 }
 
 static int acpi_table_sbbr_check_test3(fwts_framework *fw)
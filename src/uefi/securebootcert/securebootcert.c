@@ -527,7 +527,7 @@ static int securebootcert_setvar(
 	setvariable.DataSize = datasize;
 	setvariable.Data = data;
 	setvariable.status = &status;
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		if (status == EFI_OUT_OF_RESOURCES) {
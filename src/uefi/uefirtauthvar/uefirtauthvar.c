@@ -73,7 +73,7 @@ static long setvar(
 	setvariable.Data = data;
 	setvariable.status = status;
 	*status = ~0ULL;
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	return ioret;
 }
@@ -95,7 +95,7 @@ static long getvar(
 	getvariable.Data = data;
 	getvariable.status = status;
 	*status = ~0ULL;
-	ioret = ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
 
 	return ioret;
 }
@@ -83,7 +83,8 @@ static int getnexthighmonotoniccount_test(fwts_framework *fw, uint32_t multitest
 
 	for (i = 0; i < multitesttime; i++) {
 		status = ~0ULL;
-		long ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTHIGHMONOTONICCOUNT, &getnexthighmonotoniccount);
+		long ioret = fwts_lib_efi_runtime_ioctl(fd,
+			EFI_RUNTIME_GET_NEXTHIGHMONOTONICCOUNT, &getnexthighmonotoniccount);
 
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED) {
@@ -136,7 +137,8 @@ static int querycapsulecapabilities_test(fwts_framework *fw, uint32_t multitestt
 
 	for (i = 0; i < multitesttime; i++) {
 		status = ~0ULL;
-		long ioret = ioctl(fd, EFI_RUNTIME_QUERY_CAPSULECAPABILITIES, &querycapsulecapabilities);
+		long ioret = fwts_lib_efi_runtime_ioctl(fd,
+			EFI_RUNTIME_QUERY_CAPSULECAPABILITIES, &querycapsulecapabilities);
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED) {
 				fwts_skipped(fw, "Not support the UEFI QueryCapsuleCapabilities runtime interface"
@@ -257,7 +259,8 @@ static int uefirtmisc_test3(fwts_framework *fw)
 	getnexthighmonotoniccount.HighCount = NULL;
 	getnexthighmonotoniccount.status = &status;
 
-	ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTHIGHMONOTONICCOUNT, &getnexthighmonotoniccount);
+	ioret = fwts_lib_efi_runtime_ioctl(fd,
+		EFI_RUNTIME_GET_NEXTHIGHMONOTONICCOUNT, &getnexthighmonotoniccount);
 	if (ioret == -1) {
 		if (status == EFI_UNSUPPORTED) {
 			fwts_skipped(fw, "Skipping test, GetNextHighMonotonicCount runtime "
@@ -292,7 +295,8 @@ static int uefirtmisc_test4(fwts_framework *fw)
 		getnexthighmonotoniccount.status = &status;
 		status = ~0ULL;
 
-		ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTHIGHMONOTONICCOUNT, &getnexthighmonotoniccount);
+		ioret = fwts_lib_efi_runtime_ioctl(fd,
+			EFI_RUNTIME_GET_NEXTHIGHMONOTONICCOUNT, &getnexthighmonotoniccount);
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED)
 				fwts_passed(fw, "UEFI GetNextHighMonotonicCount runtime "
@@ -79,20 +79,20 @@ static void uefirtvariable_env_cleanup(void)
 	setvariable.Data = &data;
 	status = ~0ULL;
 	setvariable.status = &status;
-	(void)ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	(void)fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	status = ~0ULL;
 	setvariable.VariableName = variablenametest2;
-	(void)ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	(void)fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	status = ~0ULL;
 	setvariable.VariableName = variablenametest3;
-	(void)ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	(void)fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	status = ~0ULL;
 	setvariable.VariableName = variablenametest;
 	setvariable.VendorGuid = &gtestguid2;
-	(void)ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	(void)fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 }
 
 static int uefirtvariable_init(fwts_framework *fw)
@@ -150,7 +150,7 @@ static int getvariable_test(
 	setvariable.Data = data;
 	setvariable.status = &status;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		if (status == EFI_UNSUPPORTED) {
@@ -190,7 +190,7 @@ static int getvariable_test(
 
 	for (i = 0; i < multitesttime; i++) {
 		status = ~0ULL;
-		ioret = ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED) {
 				fwts_skipped(fw, "Skipping test, GetVariable runtime "
@@ -241,7 +241,7 @@ static int getvariable_test(
 	setvariable.DataSize = 0;
 	status = ~0ULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "UEFIRuntimeSetVariable",
@@ -257,7 +257,7 @@ err_restore_env:
 	setvariable.DataSize = 0;
 	status = ~0ULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "UEFIRuntimeSetVariable",
@@ -339,7 +339,7 @@ static int getnextvariable_test1(fwts_framework *fw)
 	setvariable.Data = data;
 	setvariable.status = &status;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		if (status == EFI_UNSUPPORTED) {
@@ -389,7 +389,7 @@ static int getnextvariable_test1(fwts_framework *fw)
 	while (true) {
 		variablenamesize = maxvariablenamesize;
 		status = ~0ULL;
-		ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
 
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED) {
@@ -460,7 +460,7 @@ static int getnextvariable_test1(fwts_framework *fw)
 	setvariable.DataSize = 0;
 	status = ~0ULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "UEFIRuntimeSetVariable",
@@ -476,7 +476,7 @@ err_restore_env:
 	setvariable.DataSize = 0;
 	status = ~0ULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 	if (ioret == -1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "UEFIRuntimeSetVariable",
 			"Failed to delete variable with UEFI runtime service.");
@@ -548,7 +548,7 @@ static int getnextvariable_test2(fwts_framework *fw)
 
 		status = ~0ULL;
 		variablenamesize = maxvariablenamesize;
-		ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
 
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED) {
@@ -719,7 +719,7 @@ static int getnextvariable_test3(fwts_framework *fw)
 
 		status = ~0ULL;
 		variablenamesize = maxvariablenamesize;
-		ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
 
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED) {
@@ -846,7 +846,7 @@ static int getnextvariable_test4(fwts_framework *fw)
 	 */
 	getnextvariablename.VariableName = NULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
 
 	if (ioret == -1) {
 		if (status == EFI_UNSUPPORTED) {
@@ -868,7 +868,7 @@ static int getnextvariable_test4(fwts_framework *fw)
 	getnextvariablename.VendorGuid = NULL;
 	status = ~0ULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
 
 	if (ioret != -1 || status != EFI_INVALID_PARAMETER) {
 		fwts_failed(fw, LOG_LEVEL_HIGH,
@@ -882,7 +882,7 @@ static int getnextvariable_test4(fwts_framework *fw)
 	getnextvariablename.VariableNameSize = NULL;
 	status = ~0ULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
 
 	if (ioret != -1 || status != EFI_INVALID_PARAMETER) {
 		fwts_failed(fw, LOG_LEVEL_HIGH,
@@ -904,7 +904,7 @@ static int getnextvariable_test4(fwts_framework *fw)
 		variablename[0] = '\0';
 		status = ~0ULL;
 
-		ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
 
 		/*
 		 * We expect this machine to have at least some UEFI
@@ -969,7 +969,7 @@ static int setvariable_insertvariable(
 	setvariable.DataSize = datasize;
 	setvariable.Data = data;
 	setvariable.status = &status;
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		if (status == EFI_UNSUPPORTED) {
@@ -1048,7 +1048,7 @@ static int setvariable_checkvariable(
 	getvariable.Data = testdata;
 	getvariable.status = &status;
 
-	ioret = ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
 	if (ioret == -1) {
 		if (status == EFI_UNSUPPORTED) {
 			fwts_skipped(fw, "Skipping test, GetVariable runtime "
@@ -1114,7 +1114,7 @@ static int setvariable_checkvariable_notfound(
 	getvariable.Data = testdata;
 	getvariable.status = &status;
 
-	ioret = ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
 	/* expect the uefi runtime interface return EFI_NOT_FOUND */
 	if (ioret == -1) {
 		if (status == EFI_UNSUPPORTED) {
@@ -1163,7 +1163,7 @@ static int setvariable_invalidattr(
 	setvariable.Data = data;
 	setvariable.status = &status;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		if (status == EFI_UNSUPPORTED) {
@@ -1517,7 +1517,7 @@ static int setvariable_test8(fwts_framework *fw)
 	setvariable.Data = &data;
 	setvariable.status = &status;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (status == EFI_UNSUPPORTED && ioret == -1)
 		return FWTS_OK;
@@ -1547,7 +1547,7 @@ static int do_queryvariableinfo(
 	queryvariableinfo.status = status;
 	*status = ~0ULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_QUERY_VARIABLEINFO, &queryvariableinfo);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_QUERY_VARIABLEINFO, &queryvariableinfo);
 
 	if (ioret == -1)
 		return FWTS_ERROR;
@@ -1589,7 +1589,7 @@ static int getnextvariable_multitest(
 	setvariable.Data = data;
 	setvariable.status = &status;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		if (status == EFI_UNSUPPORTED) {
@@ -1628,7 +1628,7 @@ static int getnextvariable_multitest(
 		variablename[0] = '\0';
 		variablenamesize = MAX_DATA_LENGTH;
 		status = ~0ULL;
-		ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
 
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED) {
@@ -1647,7 +1647,7 @@ static int getnextvariable_multitest(
 	setvariable.DataSize = 0;
 	status = ~0ULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "UEFIRuntimeSetVariable",
@@ -1662,7 +1662,7 @@ err_restore_env:
 	setvariable.DataSize = 0;
 	status = ~0ULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "UEFIRuntimeSetVariable",
@@ -1814,7 +1814,7 @@ static int uefirtvariable_test4(fwts_framework *fw)
 	return FWTS_OK;
 }
 
-static int uefirtvariable_test5(fwts_framework *fw)
+static int uefirtvariable_getvariable_stress(fwts_framework *fw)
 {
 	int ret;
 	uint32_t multitesttime = uefi_get_variable_multiple;
@@ -1837,7 +1837,7 @@ static int uefirtvariable_test5(fwts_framework *fw)
 
 }
 
-static int uefirtvariable_test6(fwts_framework *fw)
+static int uefirtvariable_setvariable_stress(fwts_framework *fw)
 {
 	int ret;
 	uint32_t multitesttime = uefi_set_variable_multiple;
@@ -1926,7 +1926,7 @@ static int uefirtvariable_test6(fwts_framework *fw)
 	return FWTS_OK;
 }
 
-static int uefirtvariable_test7(fwts_framework *fw)
+static int uefirtvariable_queryvariable_stress(fwts_framework *fw)
 {
 	uint32_t multitesttime = uefi_query_variable_multiple;
 	uint64_t status;
@@ -1996,7 +1996,7 @@ static void getvariable_test_invalid(
 	fwts_log_info(fw, "Testing GetVariable with %s.", test);
 	*(getvariable->status) = ~0ULL;
 
-	ioret = ioctl(fd, EFI_RUNTIME_GET_VARIABLE, getvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_VARIABLE, getvariable);
 
 	if (ioret == -1) {
 		if (*(getvariable->status) == EFI_UNSUPPORTED) {
@@ -2025,6 +2025,38 @@ static void getvariable_test_invalid(
 
 }
 
+/*
+ *  uefirtvariable_latency_test()
+ *	run a stress test and report the runtime service latencies
+ */
+static int uefirtvariable_latency_test(
+	fwts_framework *fw,
+	int (*test)(fwts_framework *fw))
+{
+	int ret;
+
+	fwts_lib_efi_runtime_latency_reset();
+	ret = test(fw);
+	fwts_lib_efi_runtime_latency_report(fw);
+
+	return ret;
+}
+
+static int uefirtvariable_test5(fwts_framework *fw)
+{
+	return uefirtvariable_latency_test(fw, uefirtvariable_getvariable_stress);
+}
+
+static int uefirtvariable_test6(fwts_framework *fw)
+{
+	return uefirtvariable_latency_test(fw, uefirtvariable_setvariable_stress);
+}
+
+static int uefirtvariable_test7(fwts_framework *fw)
+{
+	return uefirtvariable_latency_test(fw, uefirtvariable_queryvariable_stress);
+}
+
 static int uefirtvariable_test8(fwts_framework *fw)
 {
 	struct efi_getvariable getvariable;
@@ -2052,7 +2084,7 @@ static int uefirtvariable_test8(fwts_framework *fw)
 	setvariable.Data = data;
 	setvariable.status = &status;
 
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	if (ioret == -1) {
 		if (status == EFI_UNSUPPORTED) {
@@ -2119,7 +2151,7 @@ static int uefirtvariable_test8(fwts_framework *fw)
 	/* delete the variable */
 	setvariable.DataSize = 0;
 	status = ~0ULL;
-	ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 	if (ioret == -1) {
 		fwts_failed(fw, LOG_LEVEL_HIGH, "UEFIRuntimeSetVariable",
 			"Failed to delete variable with UEFI runtime service.");
@@ -2159,7 +2191,7 @@ static int uefirtvariable_test9(fwts_framework *fw)
 		setvariable.Data = &data;
 		setvariable.status = &status;
 
-		ioret = ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED)
 				fwts_passed(fw, "UEFI SetVariable runtime service "
@@ -2194,7 +2226,7 @@ static int uefirtvariable_test9(fwts_framework *fw)
 		getvariable.Data = testdata;
 		getvariable.status = &status;
 
-		ioret = ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED)
 				fwts_passed(fw, "UEFI GetVariable runtime service "
@@ -2223,7 +2255,7 @@ static int uefirtvariable_test9(fwts_framework *fw)
 	/* delete the variable which was set */
 	setvariable.DataSize = 0;
 	status = ~0ULL;
-	(void)ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
+	(void)fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_SET_VARIABLE, &setvariable);
 
 	variablename = malloc(sizeof(uint16_t) * variablenamesize);
 	if (!variablename) {
@@ -2239,7 +2271,7 @@ static int uefirtvariable_test9(fwts_framework *fw)
 		variablename[0] = '\0';
 		status = ~0ULL;
 
-		ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED)
 				fwts_passed(fw, "UEFI GetNextVarName runtime service "
@@ -2273,7 +2305,7 @@ static int uefirtvariable_test9(fwts_framework *fw)
 		queryvariableinfo.status = &status;
 		status = ~0ULL;
 
-		ioret = ioctl(fd, EFI_RUNTIME_QUERY_VARIABLEINFO, &queryvariableinfo);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_QUERY_VARIABLEINFO, &queryvariableinfo);
 		if (ioret == -1) {
 			if (status == EFI_UNSUPPORTED)
 				fwts_passed(fw, "UEFI QueryVarInfo runtime service "
@@ -88,7 +88,7 @@ static int do_checkvariables(
 		status = ~0ULL;
 
 		variablenamesize = MAX_VARNAME_LENGTH;
-		ioret = ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_NEXTVARIABLENAME, &getnextvariablename);
 
 		if (ioret == -1) {
 
@@ -116,7 +116,7 @@ static int do_checkvariables(
 		getvariable.Data = data;
 		status = ~0ULL;
 
-		ioret = ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
+		ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
 		if (ioret == -1) {
 			if (status != EFI_BUFFER_TOO_SMALL) {
 				free(data);
@@ -141,7 +141,7 @@ static int do_checkvariables(
 				getvariable.Data = data;
 				status = ~0ULL;
 
-				ioret = ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
+				ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_GET_VARIABLE, &getvariable);
 				if (ioret == -1) {
 					fwts_log_info(fw, "Failed to get variable with variable larger than maximum variable length.");
 					fwts_uefi_print_status_info(fw, status);
@@ -178,7 +178,7 @@ static int do_queryvariableinfo(
 	*status = ~0ULL;
 	queryvariableinfo.status = status;
 
-	ioret = ioctl(fd, EFI_RUNTIME_QUERY_VARIABLEINFO, &queryvariableinfo);
+	ioret = fwts_lib_efi_runtime_ioctl(fd, EFI_RUNTIME_QUERY_VARIABLEINFO, &queryvariableinfo);
 
 	if (ioret == -1)
 		return FWTS_ERROR;
@@ -0,0 +1,702 @@
+/*
+ * Copyright (C) 2021 Canonical
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ *  fwtsbench: micro-benchmarks for the hot paths in libfwts,
+ *  built on demand with "make fwtsbench".
+ */
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <regex.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+
+#include "fwts.h"
+#include "fwts_efi_runtime.h"
+#include "fwts_efi_module.h"
+
+typedef struct {
+	const char *name;		/* benchmark name */
+	const char *args;		/* argument help */
+	const char *description;	/* what it measures */
+	int (*func)(int argc, char **argv);
+} bench_info;
+
+/*
+ *  bench_time_now()
+ *	monotonic time in seconds
+ */
+static double bench_time_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+/*
+ *  bench_arg_ulong()
+ *	fetch optional numeric argument n, default to def
+ */
+static unsigned long bench_arg_ulong(int argc, char **argv, int n, unsigned long def)
+{
+	unsigned long val;
+
+	if (n >= argc)
+		return def;
+	val = strtoul(argv[n], NULL, 10);
+
+	return val ? val : def;
+}
+
+/*
+ *  bench_klog_synthetic()
+ *	create a synthetic kernel log of roughly mb megabytes,
+ *	a mix of unique and frequently repeated messages much
+ *	like a kernel log after a long soak test
+ */
+static fwts_list *bench_klog_synthetic(const unsigned long mb)
+{
+	static const char *messages[] = {
+		"ACPI Error: No handler for Region [ECOR] (%d) [EmbeddedControl] (20210331/evregion-130)",
+		"pcieport 0000:00:1c.%d: AER: Corrected error received: 0000:00:1c.0",
+		"mce: [Hardware Error]: Machine check events logged",
+		"ACPI Warning: SystemIO range 0x0000000000000428-0x000000000000042F conflicts with OpRegion",
+		"usb 1-%d: new high-speed USB device number %d using xhci_hcd",
+		"EDAC sbridge: Seeking for: PCI ID 8086:%4.4x",
+		"thermal thermal_zone%d: failed to read out thermal zone (-61)",
+		"nvme nvme%d: I/O %d QID %d timeout, completion polled",
+		"Freezing user space processes ... (elapsed 0.00%d seconds) done.",
+		"PM: freeze of devices complete after %d.%d msecs",
+	};
+	const size_t total = mb * 1024 * 1024;
+	size_t size = 0;
+	unsigned long n = 0;
+	fwts_list *log;
+
+	if ((log = fwts_list_new()) == NULL)
+		return NULL;
+
+	while (size < total) {
+		char buf[256], msg[192];
+		const unsigned long which = n % FWTS_ARRAY_SIZE(messages);
+		char *line;
+
+		/*
+		 *  Every 4th line is unique, the rest repeat with
+		 *  a small number of variations
+		 */
+		if ((n & 3) == 0)
+			snprintf(msg, sizeof(msg), "fwtsbench: unique event %lu on cpu %lu", n, n % 224);
+		else
+			snprintf(msg, sizeof(msg), messages[which], (int)(n % 17), (int)(n % 13), (int)(n % 7));
+
+		snprintf(buf, sizeof(buf), "<%d>[%5lu.%6.6lu] %s", (int)(n % 8), n / 1000, n % 1000000, msg);
+		if ((line = strdup(buf)) == NULL)
+			break;
+		if (fwts_list_append(log, line) == NULL) {
+			free(line);
+			break;
+		}
+		size += strlen(line) + 1;
+		n++;
+	}
+	return log;
+}
+
+static void bench_logscan_callback(fwts_framework *fw, char *line, int repeated,
+	char *prevline, void *private, int *match)
+{
+	unsigned long *repeats = (unsigned long *)private;
+
+	FWTS_UNUSED(fw);
+	FWTS_UNUSED(line);
+	FWTS_UNUSED(prevline);
+
+	*repeats += repeated;
+	(*match)++;
+}
+
+/*
+ *  bench_logscan()
+ *	time the duplicate line reduction in fwts_log_scan()
+ */
+static int bench_logscan(int argc, char **argv)
+{
+	const unsigned long mb = bench_arg_ulong(argc, argv, 0, 8);
+	unsigned long repeats = 0;
+	fwts_list *log;
+	double t1, t2;
+	int unique = 0;
+
+	if ((log = bench_klog_synthetic(mb)) == NULL) {
+		fprintf(stderr, "Cannot create synthetic log.\n");
+		return EXIT_FAILURE;
+	}
+
+	t1 = bench_time_now();
+	if (fwts_log_scan(NULL, log, bench_logscan_callback, NULL,
+	    &repeats, &unique, true) != FWTS_OK) {
+		fprintf(stderr, "fwts_log_scan failed.\n");
+		fwts_log_free(log);
+		return EXIT_FAILURE;
+	}
+	t2 = bench_time_now();
+
+	printf("logscan: %lu MB, %d lines, %d unique, %lu repeats, %.3f secs, %.0f lines/sec\n",
+		mb, fwts_list_len(log), unique, repeats, t2 - t1,
+		(double)fwts_list_len(log) / (t2 - t1));
+
+	fwts_log_free(log);
+
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  bench_match_linear()
+ *	reference first-match-wins pattern walk, as done before the
+ *	multi-pattern matcher, return the pattern index or -1
+ */
+static int bench_match_linear(fwts_log_patterns *table, const char *line)
+{
+	int i;
+
+	for (i = 0; i < table->count; i++) {
+		fwts_log_pattern *pattern = &table->patterns[i];
+
+		if (pattern->compare_mode == FWTS_COMPARE_REGEX) {
+			if (pattern->compiled_ok &&
+			    !regexec(&pattern->compiled, line, 0, NULL, 0))
+				return i;
+		} else if (strstr(line, pattern->pattern)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/*
+ *  bench_logmatch()
+ *	time matching log lines against a json pattern table, one
+ *	pattern at a time and with the multi-pattern matcher, and
+ *	check that both find the same pattern for every line
+ */
+static int bench_logmatch(int argc, char **argv)
+{
+	const char *json = argc > 0 ? argv[0] : "data/klog.json";
+	const char *table = argc > 1 ? argv[1] : "firmware_error_warning_patterns";
+	const unsigned long mb = bench_arg_ulong(argc, argv, 2, 1);
+	fwts_framework *fw;
+	fwts_log_patterns *patterns;
+	fwts_list *log;
+	fwts_list_link *item;
+	unsigned long lines = 0, matched = 0, mismatched = 0;
+	double t1, t2, t3;
+	int i;
+
+	if ((fw = calloc(1, sizeof(*fw))) == NULL) {
+		fprintf(stderr, "Cannot allocate framework.\n");
+		return EXIT_FAILURE;
+	}
+	if ((patterns = fwts_log_patterns_load(fw, json, table, "Klog")) == NULL) {
+		fprintf(stderr, "Cannot load table %s from %s.\n", table, json);
+		free(fw);
+		return EXIT_FAILURE;
+	}
+	if (!patterns->matcher) {
+		fprintf(stderr, "Cannot build multi-pattern matcher.\n");
+		fwts_log_patterns_free(patterns);
+		free(fw);
+		return EXIT_FAILURE;
+	}
+	if ((log = bench_klog_synthetic(mb)) == NULL) {
+		fprintf(stderr, "Cannot create synthetic log.\n");
+		fwts_log_patterns_free(patterns);
+		free(fw);
+		return EXIT_FAILURE;
+	}
+
+	/* Sprinkle in lines that contain each of the patterns */
+	for (i = 0; i < patterns->count; i++) {
+		char buf[1024];
+		char *line;
+
+		snprintf(buf, sizeof(buf), "[%5d.000000] ACPI: %s (fwtsbench)",
+			i, patterns->patterns[i].pattern);
+		if ((line = strdup(buf)) == NULL)
+			break;
+		if (fwts_list_append(log, line) == NULL) {
+			free(line);
+			break;
+		}
+	}
+
+	t1 = bench_time_now();
+	fwts_list_foreach(item, log)
+		(void)bench_match_linear(patterns, fwts_log_remove_timestamp(fwts_list_data(char *, item)));
+	t2 = bench_time_now();
+	fwts_list_foreach(item, log)
+		(void)fwts_log_matcher_match(fw, patterns->matcher,
+			fwts_log_remove_timestamp(fwts_list_data(char *, item)));
+	t3 = bench_time_now();
+
+	fwts_list_foreach(item, log) {
+		const char *line = fwts_log_remove_timestamp(fwts_list_data(char *, item));
+		const int expected = bench_match_linear(patterns, line);
+
+		if (expected != fwts_log_matcher_match(fw, patterns->matcher, line))
+			mismatched++;
+		if (expected >= 0)
+			matched++;
+		lines++;
+	}
+
+	printf("logmatch: %d patterns, %lu lines, %lu matched, %lu mismatched\n",
+		patterns->count, lines, matched, mismatched);
+	printf("logmatch: linear %.3f secs, matcher %.3f secs, %.1fx\n",
+		t2 - t1, t3 - t2, (t2 - t1) / (t3 - t2));
+
+	fwts_log_free(log);
+	fwts_log_patterns_free(patterns);
+	free(fw);
+
+	return mismatched ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static void bench_regex_per_line_callback(fwts_framework *fw, char *line, int repeated,
+	char *prev, void *pattern, int *match)
+{
+	regex_t compiled;
+
+	FWTS_UNUSED(fw);
+	FWTS_UNUSED(repeated);
+	FWTS_UNUSED(prev);
+
+	if (!regcomp(&compiled, (char *)pattern, REG_EXTENDED)) {
+		if (!regexec(&compiled, line, 0, NULL, 0))
+			(*match)++;
+		regfree(&compiled);
+	}
+}
+
+/*
+ *  bench_regexfind()
+ *	time searching a large kernel log for the s4 PM messages,
+ *	compiling each regex per line (as fwts_log_regex_find()
+ *	used to) against compiling once and searching in one pass
+ */
+static int bench_regexfind(int argc, char **argv)
+{
+	const unsigned long mb = bench_arg_ulong(argc, argv, 0, 8);
+	fwts_log_regex regexes[] = {
+		{ .pattern = "Freezing user space processes.*done" },
+		{ .pattern = "Freezing remaining freezable tasks.*done" },
+		{ .pattern = "PM: freeze of devices complete" },
+		{ .pattern = "PM: late freeze of devices complete" },
+		{ .pattern = "PM: Allocated.*kbytes" },
+		{ .pattern = "PM: Image restored successfully" },
+	};
+	fwts_framework *fw;
+	fwts_list *log;
+	double t1, t2, t3;
+	int i, mismatched = 0;
+	int counts[FWTS_ARRAY_SIZE(regexes)];
+
+	if ((fw = calloc(1, sizeof(*fw))) == NULL) {
+		fprintf(stderr, "Cannot allocate framework.\n");
+		return EXIT_FAILURE;
+	}
+	if ((log = bench_klog_synthetic(mb)) == NULL) {
+		fprintf(stderr, "Cannot create synthetic log.\n");
+		free(fw);
+		return EXIT_FAILURE;
+	}
+
+	t1 = bench_time_now();
+	for (i = 0; i < (int)FWTS_ARRAY_SIZE(regexes); i++)
+		fwts_log_scan(fw, log, bench_regex_per_line_callback, NULL,
+			(void *)regexes[i].pattern, &counts[i], true);
+	t2 = bench_time_now();
+	(void)fwts_log_regex_compile(fw, regexes, FWTS_ARRAY_SIZE(regexes));
+	fwts_log_regex_find_all(fw, log, regexes, FWTS_ARRAY_SIZE(regexes), true);
+	fwts_log_regex_free(regexes, FWTS_ARRAY_SIZE(regexes));
+	t3 = bench_time_now();
+
+	for (i = 0; i < (int)FWTS_ARRAY_SIZE(regexes); i++)
+		if (counts[i] != regexes[i].count)
+			mismatched++;
+
+	printf("regexfind: %lu MB, %d lines, %zu patterns, %d mismatched\n",
+		mb, fwts_list_len(log), FWTS_ARRAY_SIZE(regexes), mismatched);
+	printf("regexfind: regcomp per line %.3f secs, compile once %.3f secs, %.1fx\n",
+		t2 - t1, t3 - t2, (t2 - t1) / (t3 - t2));
+
+	fwts_log_free(log);
+	free(fw);
+
+	return mismatched ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+/*
+ *  bench_jsonparse()
+ *	time parsing a json data file and freeing the parsed tree
+ */
+static int bench_jsonparse(int argc, char **argv)
+{
+	const char *json = argc > 0 ? argv[0] : "data/klog.json";
+	const unsigned long loops = bench_arg_ulong(argc, argv, 1, 100);
+	struct stat buf;
+	double t1, t2;
+	unsigned long i;
+
+	if (stat(json, &buf) < 0) {
+		fprintf(stderr, "Cannot stat %s.\n", json);
+		return EXIT_FAILURE;
+	}
+
+	t1 = bench_time_now();
+	for (i = 0; i < loops; i++) {
+		json_object *obj;
+
+		if ((obj = json_object_from_file(json)) == NULL) {
+			fprintf(stderr, "Cannot parse %s.\n", json);
+			return EXIT_FAILURE;
+		}
+		json_object_put(obj);
+	}
+	t2 = bench_time_now();
+
+	printf("jsonparse: %s, %jd bytes, %lu loops\n", json, (intmax_t)buf.st_size, loops);
+	printf("jsonparse: %.3f msecs per parse, %.1f MB/sec\n",
+		((t2 - t1) * 1000.0) / loops,
+		((double)buf.st_size * loops) / ((t2 - t1) * 1024.0 * 1024.0));
+
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  bench_logprint()
+ *	time writing records to a plaintext log, a mix of short
+ *	records and long records that need to be wrapped
+ */
+static int bench_logprint(int argc, char **argv)
+{
+	const unsigned long records = bench_arg_ulong(argc, argv, 0, 1000000);
+	const char *filename = argc > 1 ? argv[1] : "/tmp/fwtsbench.log";
+	fwts_framework *fw;
+	struct stat buf;
+	double t1, t2;
+	unsigned long i;
+
+	if ((fw = calloc(1, sizeof(*fw))) == NULL) {
+		fprintf(stderr, "Cannot allocate framework.\n");
+		return EXIT_FAILURE;
+	}
+	fw->filter_level = LOG_LEVEL_ALL;
+	fwts_log_set_format("%date %time [%field] (%owner): ");
+	fwts_log_set_line_width(120);
+	if ((fw->results = fwts_log_open("fwtsbench", filename, "w", LOG_TYPE_PLAINTEXT)) == NULL) {
+		fprintf(stderr, "Cannot open log %s.\n", filename);
+		free(fw);
+		return EXIT_FAILURE;
+	}
+
+	t1 = bench_time_now();
+	for (i = 0; i < records; i++) {
+		if (i & 3)
+			fwts_log_printf(fw, LOG_INFO, LOG_LEVEL_NONE, "", "", "",
+				"Test %lu, checked %lu of %lu items.", i, i % 13, records);
+		else
+			fwts_log_printf(fw, LOG_ERROR, LOG_LEVEL_HIGH, "", "", "",
+				"FAILED [HIGH] BenchRecord: Test %lu, _SB_.PCI0.LPCB.EC0_.BAT%lu "
+				"returned a package of %lu elements, expected 13 elements, "
+				"the Battery Information package is broken and the "
+				"battery capacity will not be reported correctly.",
+				i, i % 4, i % 17);
+	}
+	t2 = bench_time_now();
+
+	fwts_log_close(fw->results);
+	free(fw);
+
+	if (stat(filename, &buf) < 0)
+		buf.st_size = 0;
+	printf("logprint: %lu records, %jd bytes, %.3f secs, %.0f records/sec\n",
+		records, (intmax_t)buf.st_size, t2 - t1, (double)records / (t2 - t1));
+	if (argc < 2)
+		(void)unlink(filename);
+
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  bench_uefirt_spin()
+ *	busy wait for nsecs
+ */
+static void bench_uefirt_spin(const uint64_t nsecs)
+{
+	const double end = bench_time_now() + ((double)nsecs / 1000000000.0);
+
+	while (bench_time_now() < end)
+		;
+}
+
+/*
+ *  bench_uefirt_ioctl_null()
+ *	mock efi_runtime backend that returns immediately
+ */
+static int bench_uefirt_ioctl_null(const int fd, const unsigned long request, void *arg)
+{
+	FWTS_UNUSED(fd);
+	FWTS_UNUSED(request);
+	FWTS_UNUSED(arg);
+
+	return 0;
+}
+
+/*
+ *  bench_uefirt_ioctl()
+ *	mock efi_runtime backend, services take a few usecs with
+ *	the occasional slow call, much like real firmware
+ */
+static int bench_uefirt_ioctl(const int fd, const unsigned long request, void *arg)
+{
+	static uint32_t seed = 0x12345678;
+	uint64_t nsecs;
+
+	FWTS_UNUSED(fd);
+	FWTS_UNUSED(arg);
+
+	/* xorshift32 */
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+
+	switch (request) {
+	case EFI_RUNTIME_SET_VARIABLE:
+		nsecs = (seed % 1000) ? 20000 + (seed % 10000) : 250000;
+		break;
+	case EFI_RUNTIME_GET_TIME:
+		nsecs = (seed % 5000) ? 1000 + (seed % 500) : 120000;
+		break;
+	default:
+		nsecs = 2000 + (seed % 2000);
+		break;
+	}
+	bench_uefirt_spin(nsecs);
+
+	return 0;
+}
+
+/*
+ *  bench_uefirt()
+ *	exercise the UEFI runtime service latency profiler with
+ *	a mock backend and report the profiler overhead
+ */
+static int bench_uefirt(int argc, char **argv)
+{
+	static const unsigned long requests[] = {
+		EFI_RUNTIME_GET_VARIABLE,
+		EFI_RUNTIME_SET_VARIABLE,
+		EFI_RUNTIME_GET_TIME,
+		EFI_RUNTIME_QUERY_VARIABLEINFO,
+	};
+	const unsigned long calls = bench_arg_ulong(argc, argv, 0, 10000);
+	const char *thresholds = argc > 1 ? argv[1] : "100,SetVariable:200";
+	fwts_framework *fw;
+	double t1, t2, t3;
+	unsigned long i;
+	size_t j;
+
+	if (fwts_lib_efi_runtime_latency_threshold(thresholds) != FWTS_OK) {
+		fprintf(stderr, "Invalid thresholds '%s'.\n", thresholds);
+		return EXIT_FAILURE;
+	}
+	if ((fw = calloc(1, sizeof(*fw))) == NULL) {
+		fprintf(stderr, "Cannot allocate framework.\n");
+		return EXIT_FAILURE;
+	}
+	fw->filter_level = LOG_LEVEL_ALL;
+	if ((fw->results = fwts_log_open("uefirt", "stdout", "w", LOG_TYPE_PLAINTEXT)) == NULL) {
+		fprintf(stderr, "Cannot open log.\n");
+		free(fw);
+		return EXIT_FAILURE;
+	}
+	/* Profiler overhead, null backend on its own and then profiled */
+	fwts_lib_efi_runtime_ioctl_set(bench_uefirt_ioctl_null);
+	t1 = bench_time_now();
+	for (i = 0; i < calls * 100; i++)
+		for (j = 0; j < FWTS_ARRAY_SIZE(requests); j++)
+			(void)bench_uefirt_ioctl_null(-1, requests[j], NULL);
+	t2 = bench_time_now();
+	for (i = 0; i < calls * 100; i++)
+		for (j = 0; j < FWTS_ARRAY_SIZE(requests); j++)
+			(void)fwts_lib_efi_runtime_ioctl(-1, requests[j], NULL);
+	t3 = bench_time_now();
+
+	/* Latencies of the mock firmware */
+	fwts_lib_efi_runtime_ioctl_set(bench_uefirt_ioctl);
+	fwts_lib_efi_runtime_latency_reset();
+	for (i = 0; i < calls; i++)
+		for (j = 0; j < FWTS_ARRAY_SIZE(requests); j++)
+			(void)fwts_lib_efi_runtime_ioctl(-1, requests[j], NULL);
+	fwts_lib_efi_runtime_latency_report(fw);
+
+	fwts_lib_efi_runtime_ioctl_set(NULL);
+	fwts_log_close(fw->results);
+	free(fw);
+
+	printf("uefirt: %lu calls per service, %.1f nsecs profiler overhead per call\n",
+		calls, (((t3 - t2) - (t2 - t1)) * 1000000000.0) /
+			(calls * 100 * FWTS_ARRAY_SIZE(requests)));
+
+	return EXIT_SUCCESS;
+}
+
+/*
+ *  bench_summary()
+ *	time checking failure labels against the --filter-error-discard
+ *	list and adding failures to the summary, one in every three
+ *	failures repeats an earlier one much like a test looping over
+ *	objects
+ */
+static int bench_summary(int argc, char **argv)
+{
+	const unsigned long failures = bench_arg_ulong(argc, argv, 0, 100000);
+	const unsigned long labels = bench_arg_ulong(argc, argv, 1, 500);
+	fwts_framework *fw;
+	char **filters;
+	double t1, t2, t3;
+	unsigned long i;
+	int kept = 0, ret = EXIT_FAILURE;
+
+	if ((fw = calloc(1, sizeof(*fw))) == NULL) {
+		fprintf(stderr, "Cannot allocate framework.\n");
+		return EXIT_FAILURE;
+	}
+	fw->filter_level = LOG_LEVEL_ALL;
+	fwts_list_init(&fw->errors_filter_discard);
+	if ((filters = calloc(labels, sizeof(*filters))) == NULL) {
+		fprintf(stderr, "Cannot allocate filters.\n");
+		free(fw);
+		return EXIT_FAILURE;
+	}
+	if ((fw->errors_filter_discard_hash = fwts_hash_new(labels)) == NULL)
+		goto out;
+	/* Discard every other label */
+	for (i = 0; i < labels; i++) {
+		char label[64];
+
+		snprintf(label, sizeof(label), "BenchLabel%lu", i * 2);
+		if ((filters[i] = strdup(label)) == NULL)
+			goto out;
+		if ((fwts_list_append(&fw->errors_filter_discard, filters[i]) == NULL) ||
+		    (fwts_hash_add(fw->errors_filter_discard_hash, filters[i], filters[i]) != FWTS_OK))
+			goto out;
+	}
+	if (fwts_summary_init() != FWTS_OK)
+		goto out;
+
+	t1 = bench_time_now();
+	for (i = 0; i < failures; i++) {
+		char label[64];
+
+		snprintf(label, sizeof(label), "BenchLabel%lu", i % (labels * 2));
+		fwts_error_inc(fw, label, &kept);
+	}
+	t2 = bench_time_now();
+	for (i = 0; i < failures; i++) {
+		static const fwts_log_level levels[] = {
+			LOG_LEVEL_CRITICAL, LOG_LEVEL_HIGH, LOG_LEVEL_MEDIUM, LOG_LEVEL_LOW
+		};
+		const unsigned long n = (i % 3) ? i : i / 3;
+		char text[128];
+
+		snprintf(text, sizeof(text), "Object \\_SB_.PCI0.DEV%lu returned an invalid "
+			"package, element %lu has the wrong type.", n, n % 7);
+		if (fwts_summary_add(fw, "bench", levels[n & 3], text) != FWTS_OK) {
+			fprintf(stderr, "fwts_summary_add failed.\n");
+			fwts_summary_deinit();
+			goto out;
+		}
+	}
+	t3 = bench_time_now();
+	fwts_summary_deinit();
+
+	printf("summary: %lu failures, %lu filter labels, %lu discarded\n",
+		failures, labels, failures - kept);
+	printf("summary: filter %.3f secs, %.0f labels/sec\n",
+		t2 - t1, (double)failures / (t2 - t1));
+	printf("summary: summary add %.3f secs, %.0f failures/sec\n",
+		t3 - t2, (double)failures / (t3 - t2));
+	ret = EXIT_SUCCESS;
+out:
+	if (ret != EXIT_SUCCESS)
+		fprintf(stderr, "Out of memory.\n");
+	fwts_hash_free(fw->errors_filter_discard_hash, NULL);
+	fwts_list_free_items(&fw->errors_filter_discard, NULL);
+	for (i = 0; i < labels; i++)
+		free(filters[i]);
+	free(filters);
+	free(fw);
+
+	return ret;
+}
+
+static bench_info benchmarks[] = {
+	{ "logscan",	"[MB]",	"fwts_log_scan() repeated line reduction", bench_logscan },
+	{ "logmatch",	"[json] [table] [MB]", "json pattern table matching", bench_logmatch },
+	{ "regexfind",	"[MB]",	"fwts_log_regex_find_all() on a large log", bench_regexfind },
+	{ "jsonparse",	"[json] [loops]", "json_object_from_file() parse throughput", bench_jsonparse },
+	{ "logprint",	"[records] [log]", "plaintext log record formatting", bench_logprint },
+	{ "summary",	"[failures] [labels]", "summary and error filter sets", bench_summary },
+	{ "uefirt",	"[calls] [thresholds]", "UEFI runtime latency profiler, mock backend", bench_uefirt },
+	{ NULL,		NULL,	NULL, NULL }
+};
+
+static void help(void)
+{
+	bench_info *bench;
+
+	printf("Usage: fwtsbench benchmark [args]\n");
+	for (bench = benchmarks; bench->name; bench++)
+		printf("  %-12s %-22s %s\n", bench->name, bench->args, bench->description);
+}
+
+int main(int argc, char **argv)
+{
+	bench_info *bench;
+
+	if (argc < 2) {
+		help();
+		exit(EXIT_FAILURE);
+	}
+
+	for (bench = benchmarks; bench->name; bench++)
+		if (!strcmp(argv[1], bench->name))
+			exit(bench->func(argc - 2, argv + 2));
+
+	help();
+	exit(EXIT_FAILURE);
+}
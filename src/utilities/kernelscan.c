@@ -23,8 +23,15 @@
 #include <string.h>
 #include <stddef.h>
 #include <ctype.h>
+#include <limits.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include <regex.h>
 #include "fwts_json.h"
 
@@ -91,21 +98,43 @@ typedef struct {
 } token;
 
 /*
- *  Quick and dirty way to push input stream back, like ungetc()
+ *  Parser context, the input is parsed from memory
  */
-typedef struct get_stack {
-	int ch;			/* Char pushed back */
-	struct get_stack *next;	/* Next one in list */
-} get_stack;
+typedef struct {
+	const unsigned char *ptr;	/* Next char to read */
+	const unsigned char *end;	/* End of the input */
+	bool skip_white_space;		/* Magic skip white space flag */
+	FILE *out;			/* Where the results are printed */
+	token line;			/* Kernel message being gathered */
+	token str;			/* Literal string being gathered */
+	fwts_hash *found;		/* Cached klog_find() results */
+	size_t ok;			/* Messages found in klog patterns */
+	size_t add;			/* Messages not found in klog patterns */
+} parser;
 
 /*
- *  Parser context
+ *  A source file to scan, results are gathered in
+ *  memory so they can be printed in file order
  */
 typedef struct {
-	FILE *fp;		/* The file descriptor we are reading */
-	bool skip_white_space;	/* Magic skip white space flag */
-	get_stack *get_chars;	/* Ungot chars get pushed onto this */
-} parser;
+	char *name;		/* Source file name */
+	char *out;		/* Scan results */
+	size_t out_len;		/* Length of the results */
+	size_t size;		/* Size of source file */
+	size_t ok;		/* Messages found in klog patterns */
+	size_t add;		/* Messages not found in klog patterns */
+} source_file;
+
+/*
+ *  Source files to scan, shared by the scanner threads
+ */
+typedef struct {
+	source_file *files;	/* Files to scan */
+	size_t count;		/* Number of files */
+	size_t size;		/* Allocated number of files */
+	size_t next;		/* Next file to be scanned */
+	pthread_mutex_t lock;	/* Protects next */
+} source_files;
 
 /*
  *  FWTS klog patterns, loaded from a json file
@@ -210,53 +239,23 @@ static inline unsigned int djb2a(const char *str)
         return hash;
 }
 
-/*
- *  Initialise the parser
- */
-static void parser_new(parser *p, FILE *fp, bool skip_white_space)
-{
-	p->get_chars = NULL;
-	p->fp = fp;
-	p->skip_white_space = skip_white_space;
-}
-
 /*
  *  Get next character from input stream
  */
-static int get_next(parser *p)
+static inline int get_next(parser *p)
 {
-	/*
-	 * If we have chars pushed using unget_next
-	 * then pop them off the list first
-	 */
-	if (p->get_chars) {
-		get_stack *tmp = p->get_chars;
-		int ch = tmp->ch;
-
-		p->get_chars = tmp->next;
-		free(tmp);
-
-		return ch;
-	}
-	return fgetc(p->fp);
+	return (p->ptr < p->end) ? *p->ptr++ : EOF;
 }
 
 /*
- *  Push character back onto the input
- *  stream (in this case, it is a simple FIFO stack
+ *  Push character back onto the input stream, chars are
+ *  only ever pushed back in the reverse order they were
+ *  read, so just step back over them
  */
-static void unget_next(parser *p, int ch)
+static inline void unget_next(parser *p, int ch)
 {
-	get_stack *new;
-
-	if ((new = calloc(1, sizeof(get_stack))) == NULL) {
-		fprintf(stderr, "unget_next: Out of memory!\n");
-		exit(EXIT_FAILURE);
-	}
-
-	new->ch = ch;
-	new->next = p->get_chars;
-	p->get_chars = new;
+	if (ch != EOF)
+		p->ptr--;
 }
 
 /*
@@ -299,32 +298,48 @@ static void token_free(token *t)
 	t->type = TOKEN_UNKNOWN;
 }
 
+/*
+ *  Make sure there is space for len more chars
+ *  and a terminating nul in the token
+ */
+static void token_reserve(token *t, size_t len)
+{
+	ptrdiff_t diff = t->ptr - t->token;
+
+	if ((size_t)diff + len < t->len)
+		return;
+
+	while ((size_t)diff + len >= t->len)
+		t->len *= 2;
+	if ((t->token = realloc(t->token, t->len)) == NULL) {
+		fprintf(stderr, "token_reserve: Out of memory!\n");
+		exit(EXIT_FAILURE);
+	}
+	t->ptr = t->token + diff;
+}
+
 /*
  *  Append a single character to the token,
  *  we may run out of space, so this occasionally
- *  adds an extra 1K of token space for long tokens
+ *  doubles the token space for long tokens
  */
-static void token_append(token *t, int ch)
+static inline void token_append(token *t, int ch)
 {
-	if (t->ptr < t->token + t->len - 1) {
-		/* Enough space, just add char */
-		*(t->ptr) = ch;
-		t->ptr++;
-		*(t->ptr) = 0;
-	} else {
-		/* No more space, add 1K more space */
-		ptrdiff_t diff = t->ptr - t->token;
-
-		t->len += 1024;
-		if ((t->token = realloc(t->token, t->len)) == NULL) {
-			fprintf(stderr, "token_append: Out of memory!\n");
-			exit(EXIT_FAILURE);
-		}
-		t->ptr = t->token + diff;
-		*(t->ptr) = ch;
-		t->ptr++;
-		*(t->ptr) = 0;
-	}
+	token_reserve(t, 1);
+	*(t->ptr) = ch;
+	t->ptr++;
+	*(t->ptr) = 0;
+}
+
+/*
+ *  Append a string to the token
+ */
+static void token_cat(token *t, const char *str, size_t len)
+{
+	token_reserve(t, len);
+	memcpy(t->ptr, str, len);
+	t->ptr += len;
+	*(t->ptr) = 0;
 }
 
 /*
@@ -468,6 +483,44 @@ static bool klog_find(char *str, klog_pattern *patterns)
 	return false;
 }
 
+/*
+ *  A klog_find() result, the string is the hash key
+ */
+typedef struct {
+	bool found;		/* String matched a klog pattern */
+	char str[];		/* The string */
+} klog_found;
+
+/*
+ *  Does str match any of the patterns in the klog pattern table,
+ *  the same strings turn up over and over again in the kernel so
+ *  remember the result of matching each string
+ */
+static bool klog_find_cached(parser *p, char *str)
+{
+	klog_found *kf;
+	size_t len;
+
+	if ((kf = fwts_hash_get(p->found, str)) != NULL)
+		return kf->found;
+
+	len = strlen(str);
+	if ((kf = malloc(sizeof(*kf) + len + 1)) == NULL) {
+		fprintf(stderr, "klog_find_cached: Out of memory!\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(kf->str, str, len + 1);
+	kf->found = klog_find(str, klog_patterns);
+	if (fwts_hash_add(p->found, kf->str, kf) != 0) {
+		bool found = kf->found;
+
+		free(kf);
+		return found;
+	}
+
+	return kf->found;
+}
+
 /*
  *  Free the klog patterns
  */
@@ -854,107 +907,76 @@ static void literal_strip_quotes(token *t)
 	memmove(t->token, t->token + 1, len - 1);
 }
 
-/*
- *  Concatenate new string onto old. The old
- *  string can be NULL or an existing string
- *  on the heap.  This returns the newly
- *  concatenated string.
- */
-static char *strdupcat(char *old, char *new)
-{
-	size_t len = strlen(new);
-	char *tmp;
-
-	if (old == NULL) {
-		tmp = malloc(len + 1);
-		if (tmp == NULL) {
-			fprintf(stderr, "strdupcat(): Out of memory.\n");
-			exit(EXIT_FAILURE);
-		}
-		strcpy(tmp, new);
-	} else {
-		size_t oldlen = strlen(old);
-		tmp = realloc(old, oldlen + len + 1);
-		if (tmp == NULL) {
-			fprintf(stderr, "strdupcat(): Out of memory.\n");
-			exit(EXIT_FAILURE);
-		}
-		strcat(tmp, new);
-	}
-
-	return tmp;
-}
-
 /*
  *  Parse a kernel message, like printk() or dev_err()
  */
 static int parse_kernel_message(parser *p, token *t)
 {
 	bool got_string = false;
+	bool got_str = false;
 	bool found = false;
 	token_type prev_token_type = TOKEN_UNKNOWN;
-	char *str = NULL;
-	char *line = NULL;
+	token *line = &p->line;
+	token *str = &p->str;
 
-	line = strdupcat(line, t->token);
+	token_clear(line);
+	token_clear(str);
+	token_cat(line, t->token, t->ptr - t->token);
 	token_clear(t);
 
 	for (;;) {
 		int ret = get_token(p, t);
-		if (ret == EOF) {
-			free(line);
-			free(str);
+		if (ret == EOF)
 			return EOF;
-		}
 
 		/*
 		 *  Hit ; so lets push out what we've parsed
 		 */
 		if (t->type == TOKEN_TERMINAL) {
 			if (found) {
-				printf("OK : %s\n", line);
+				fprintf(p->out, "OK : %s\n", line->token);
+				p->ok++;
 			} else {
-				printf("ADD: %s\n", line);
+				fprintf(p->out, "ADD: %s\n", line->token);
+				p->add++;
 			}
-			free(line);
-			free(str);
 			return PARSER_OK;
 		}
 
 		if (t->type == TOKEN_LITERAL_STRING) {
 			literal_strip_quotes(t);
-			str = strdupcat(str, t->token);
+			token_cat(str, t->token, strlen(t->token));
+			got_str = true;
 
 			if (!got_string)
-				line = strdupcat(line, "\"");
+				token_append(line, '"');
 
 			got_string = true;
 		} else {
 			if (got_string)
-				line = strdupcat(line, "\"");
+				token_append(line, '"');
 
 			got_string = false;
 
-			if (str) {
-				found |= klog_find(str, klog_patterns);
-				free(str);
-				str = NULL;
+			if (got_str) {
+				found |= klog_find_cached(p, str->token);
+				token_clear(str);
+				got_str = false;
 			}
 		}
 
-		line = strdupcat(line, t->token);
+		token_cat(line, t->token, strlen(t->token));
 
 		if (t->type == TOKEN_IDENTIFIER && prev_token_type != TOKEN_COMMA)
-			line = strdupcat(line, " ");
+			token_append(line, ' ');
 
 		if (t->type == TOKEN_COMMA)
-			line = strdupcat(line, " ");
+			token_append(line, ' ');
 
 		prev_token_type = t->type;
 
 		token_clear(t);
 	}
-	free(line);
 	return PARSER_OK;
 }
 
@@ -969,20 +991,15 @@ static bool hash_find(char *token)
 /*
  *  Parse input looking for printk or dev_err calls
  */
-static void parse_kernel_messages(FILE *fp)
+static void parse_kernel_messages(parser *p)
 {
 	token t;
-	parser p;
-
-	parser_new(&p, fp, true);
-	p.fp = fp;
-	p.skip_white_space = true;
 
 	token_new(&t);
 
-	while ((get_token(&p, &t)) != EOF) {
+	while ((get_token(p, &t)) != EOF) {
 		if (hash_find(t.token))
-			parse_kernel_message(&p, &t);
+			parse_kernel_message(p, &t);
 		else
 			token_clear(&t);
 	}
@@ -990,6 +1007,312 @@ static void parse_kernel_messages(FILE *fp)
 	token_free(&t);
 }
 
+/*
+ *  Initialise a parser, the input is set up for each source
+ */
+static void parser_new(parser *p, bool skip_white_space)
+{
+	memset(p, 0, sizeof(*p));
+	p->skip_white_space = skip_white_space;
+	token_new(&p->line);
+	token_new(&p->str);
+	if ((p->found = fwts_hash_new(0)) == NULL) {
+		fprintf(stderr, "parser_new: Out of memory!\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ *  Free a parser
+ */
+static void parser_free(parser *p)
+{
+	token_free(&p->line);
+	token_free(&p->str);
+	fwts_hash_free(p->found, free);
+}
+
+/*
+ *  Parse a source held in memory, printing results to out
+ */
+static void parse_source(parser *p, const void *data, size_t len, FILE *out)
+{
+	p->ptr = data;
+	p->end = p->ptr + len;
+	p->out = out;
+	parse_kernel_messages(p);
+}
+
+/*
+ *  Scan a source file, the results are gathered in memory
+ */
+static void scan_source_file(parser *p, source_file *sf)
+{
+	struct stat buf;
+	void *data;
+	FILE *out;
+	int fd;
+
+	if ((fd = open(sf->name, O_RDONLY)) < 0) {
+		fprintf(stderr, "Cannot open %s.\n", sf->name);
+		return;
+	}
+	if (fstat(fd, &buf) < 0) {
+		fprintf(stderr, "Cannot stat %s.\n", sf->name);
+		(void)close(fd);
+		return;
+	}
+	sf->size = buf.st_size;
+	if (sf->size == 0) {
+		(void)close(fd);
+		return;
+	}
+	data = mmap(NULL, sf->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	(void)close(fd);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "Cannot mmap %s.\n", sf->name);
+		return;
+	}
+
+	if ((out = open_memstream(&sf->out, &sf->out_len)) == NULL) {
+		fprintf(stderr, "scan_source_file: Out of memory!\n");
+		exit(EXIT_FAILURE);
+	}
+	p->ok = 0;
+	p->add = 0;
+	parse_source(p, data, sf->size, out);
+	(void)fclose(out);
+	sf->ok = p->ok;
+	sf->add = p->add;
+
+	(void)munmap(data, sf->size);
+}
+
+/*
+ *  Scanner thread, scan source files until there are none left
+ */
+static void *scan_source_files(void *arg)
+{
+	source_files *files = (source_files *)arg;
+	parser p;
+
+	parser_new(&p, true);
+
+	for (;;) {
+		size_t i;
+
+		pthread_mutex_lock(&files->lock);
+		i = files->next++;
+		pthread_mutex_unlock(&files->lock);
+
+		if (i >= files->count)
+			break;
+		scan_source_file(&p, &files->files[i]);
+	}
+
+	parser_free(&p);
+
+	return NULL;
+}
+
+/*
+ *  Add a source file to the list of files to scan
+ */
+static void source_files_add(source_files *files, const char *name)
+{
+	if (files->count == files->size) {
+		source_file *tmp;
+
+		files->size = files->size ? files->size * 2 : 256;
+		tmp = realloc(files->files, files->size * sizeof(*tmp));
+		if (tmp == NULL) {
+			fprintf(stderr, "source_files_add: Out of memory!\n");
+			exit(EXIT_FAILURE);
+		}
+		files->files = tmp;
+	}
+	memset(&files->files[files->count], 0, sizeof(source_file));
+	if ((files->files[files->count].name = strdup(name)) == NULL) {
+		fprintf(stderr, "source_files_add: Out of memory!\n");
+		exit(EXIT_FAILURE);
+	}
+	files->count++;
+}
+
+static int source_file_cmp(const void *a, const void *b)
+{
+	return strcmp(((const source_file *)a)->name, ((const source_file *)b)->name);
+}
+
+/*
+ *  Add all the C source files in a directory tree, the files
+ *  are sorted so the results are printed in a stable order
+ */
+static void source_files_add_dir(source_files *files, const char *path)
+{
+	size_t first = files->count;
+	struct dirent *d;
+	DIR *dir;
+
+	if ((dir = opendir(path)) == NULL) {
+		fprintf(stderr, "Cannot open directory %s.\n", path);
+		return;
+	}
+
+	while ((d = readdir(dir)) != NULL) {
+		char name[PATH_MAX];
+		struct stat buf;
+		size_t len;
+
+		if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, ".."))
+			continue;
+		snprintf(name, sizeof(name), "%s/%s", path, d->d_name);
+		if (lstat(name, &buf) < 0)
+			continue;
+
+		len = strlen(d->d_name);
+		if (S_ISDIR(buf.st_mode))
+			source_files_add_dir(files, name);
+		else if (S_ISREG(buf.st_mode) && (len > 2) &&
+			 !strcmp(d->d_name + len - 2, ".c"))
+			source_files_add(files, name);
+	}
+	(void)closedir(dir);
+
+	qsort(files->files + first, files->count - first,
+		sizeof(source_file), source_file_cmp);
+}
+
+/*
+ *  Add a source file or, if it is a directory, all the
+ *  C source files in the directory tree
+ */
+static void source_files_add_path(source_files *files, const char *path)
+{
+	struct stat buf;
+
+	if ((stat(path, &buf) == 0) && S_ISDIR(buf.st_mode))
+		source_files_add_dir(files, path);
+	else
+		source_files_add(files, path);
+}
+
+/*
+ *  Add the files or directories listed one per line in list
+ */
+static void source_files_add_list(source_files *files, const char *list)
+{
+	char buffer[PATH_MAX];
+	FILE *fp;
+
+	fp = strcmp(list, "-") ? fopen(list, "r") : stdin;
+	if (fp == NULL) {
+		fprintf(stderr, "Cannot open file list %s.\n", list);
+		exit(EXIT_FAILURE);
+	}
+
+	while (fgets(buffer, sizeof(buffer), fp)) {
+		buffer[strcspn(buffer, "\r\n")] = '\0';
+		if (*buffer)
+			source_files_add_path(files, buffer);
+	}
+
+	if (fp != stdin)
+		(void)fclose(fp);
+}
+
+/*
+ *  Scan the source files with jobs threads, then print the
+ *  results in file order
+ */
+static void scan_sources(source_files *files, int jobs, bool stats)
+{
+	pthread_t *threads;
+	struct timespec start, finish;
+	size_t i, bytes = 0, ok = 0, add = 0;
+	int n;
+
+	if (jobs > (int)files->count)
+		jobs = files->count ? files->count : 1;
+	if ((threads = calloc(jobs, sizeof(pthread_t))) == NULL) {
+		fprintf(stderr, "scan_sources: Out of memory!\n");
+		exit(EXIT_FAILURE);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_mutex_init(&files->lock, NULL);
+	files->next = 0;
+	for (n = 0; n < jobs; n++) {
+		if (pthread_create(&threads[n], NULL, scan_source_files, files)) {
+			fprintf(stderr, "Cannot create scanner thread.\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+	for (n = 0; n < jobs; n++)
+		pthread_join(threads[n], NULL);
+	pthread_mutex_destroy(&files->lock);
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	free(threads);
+
+	for (i = 0; i < files->count; i++) {
+		source_file *sf = &files->files[i];
+
+		if (sf->out_len) {
+			printf("Source: %s\n", sf->name);
+			fwrite(sf->out, 1, sf->out_len, stdout);
+		}
+		bytes += sf->size;
+		ok += sf->ok;
+		add += sf->add;
+		free(sf->out);
+		free(sf->name);
+	}
+	free(files->files);
+
+	if (stats) {
+		double secs = (finish.tv_sec - start.tv_sec) +
+			      (finish.tv_nsec - start.tv_nsec) / 1000000000.0;
+
+		if (secs <= 0.0)
+			secs = 1e-9;
+		fprintf(stderr, "%zu files, %.2f MB in %.3f seconds with %d thread%s, "
+			"%.2f MB/s, %.0f files/s, %zu OK, %zu ADD\n",
+			files->count, bytes / 1048576.0, secs, jobs, jobs == 1 ? "" : "s",
+			bytes / 1048576.0 / secs, files->count / secs, ok, add);
+	}
+}
+
+/*
+ *  Scan source from stdin
+ */
+static void scan_stdin(void)
+{
+	char *data = NULL;
+	size_t len = 0, size = 0;
+	parser p;
+
+	for (;;) {
+		size_t n;
+
+		if (len == size) {
+			size = size ? size * 2 : 65536;
+			if ((data = realloc(data, size)) == NULL) {
+				fprintf(stderr, "scan_stdin: Out of memory!\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		n = fread(data + len, 1, size - len, stdin);
+		if (n == 0)
+			break;
+		len += n;
+	}
+
+	parser_new(&p, true);
+	parse_source(&p, data, len, stdout);
+	parser_free(&p);
+	free(data);
+}
+
 static void hash_init(void)
 {
 	size_t i;
@@ -1020,9 +1343,12 @@ static void hash_init(void)
 
 void help(void)
 {
-	printf("kernelscan:\n");
+	printf("kernelscan: [options] [file or directory ...]\n");
+	printf("-f file\t\tscan the files or directories listed in file, - for stdin\n");
 	printf("-h\t\thelp\n");
+	printf("-j jobs\t\tnumber of scanner threads, default is one per CPU\n");
 	printf("-k file\t\tspecify klog json file\n");
+	printf("-s\t\tprint scanning throughput statistics to stderr\n");
 }
 
 /*
@@ -1030,36 +1356,73 @@ void help(void)
  *  calls.
  *
  *  Usage:
- *	cat drivers/pnp/pnpacpi/rsparser.c | kernelscan -E | gcc  -E - | kernelscan -P
+ *	kernelscan < drivers/pnp/pnpacpi/rsparser.c
+ *	kernelscan -s drivers/acpi arch/x86/kernel/e820.c
  *
  *  This prints out any kernel printk KERN_ERR calls
  *  or dev_err calls and checks to see if the error can be matched by
  *  any of the fwts klog messages.  It has some intelligence, it glues
  *  literal strings together such as "this is" "a message" into
  *  "this is a message" before it makes the klog comparison.
+ *
+ *  Files and the .c files in directory trees are scanned in parallel,
+ *  the results of each file are printed after a "Source:" line in the
+ *  order the files were given, directory trees are scanned in sorted
+ *  file name order.  With no files the source is read from stdin.
  */
 int main(int argc, char **argv)
 {
+	source_files files;
+	bool stats = false;
+	int jobs = 0;
+
+	memset(&files, 0, sizeof(files));
+
 	for (;;) {
-		int c = getopt(argc, argv, "hk:");
+		int c = getopt(argc, argv, "f:hj:k:s");
 		if (c == -1)
 			break;
 		switch (c) {
+		case 'f':
+			source_files_add_list(&files, optarg);
+			break;
 		case 'h':
 			help();
 			exit(0);
+		case 'j':
+			jobs = atoi(optarg);
+			if (jobs < 1) {
+				fprintf(stderr, "-j expects a number of jobs greater than 0.\n");
+				exit(1);
+			}
+			break;
 		case 'k':
 			klog_file = optarg;
 			break;
+		case 's':
+			stats = true;
+			break;
 		default:
 			help();
 			exit(1);
 		}
 	}
 
+	for (; optind < argc; optind++)
+		source_files_add_path(&files, argv[optind]);
+
+	if (jobs == 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+		jobs = cpus > 0 ? cpus : 1;
+	}
+
 	klog_patterns = klog_load("firmware_error_warning_patterns");
 	hash_init();
-	parse_kernel_messages(stdin);
+	if (files.count)
+		scan_sources(&files, jobs, stats);
+	else
+		scan_stdin();
 	klog_free(klog_patterns);
 
 	exit(EXIT_SUCCESS);
@@ -25,7 +25,7 @@ CONFIGS="-DCONFIG_ACPI_HOTPLUG_CPU -DCONFIG_ACPI_PROC_EVENT \
 	 -DCONFIG_SUSPEND -DCONFIG_X86 -DCONFIG_X86_IO_APIC"
 
 KERNELSCAN=./kernelscan
-TMP=/tmp/kernelscan_$$.txt
+FILES=()
 
 if [ $# -lt 1 ]; then
 	echo "Usage: $0 path-to-kernel-source"
@@ -64,29 +64,34 @@ if [ ! -e "${KLOG}" ]; then
 	exit 1
 fi
 
+#
+# Individual files are gathered up and scanned together
+# by scan_source_files to save starting kernelscan for each
+#
 scan_source_file()
 {
 	if [ -f $1 ]; then
-		$KERNELSCAN -k ${KLOG} < $1 > $TMP
-		if [ $(stat -c%s $TMP) -gt 0 ]; then
-			echo "Source: $1"
-			cat $TMP
-		fi
-		rm $TMP	
+		FILES+=("$1")
 	else
 		echo "Source: $1 does not exist"
 	fi
 }
 
+scan_source_files()
+{
+	if [ ${#FILES[@]} -gt 0 ]; then
+		$KERNELSCAN -k ${KLOG} "${FILES[@]}"
+	fi
+}
+
 scan_source_tree()
 {
 	tree=$1
 
 	echo "Scanning $tree"
-	for I in $(find $tree -name "*.c")
-	do
-		scan_source_file $I
-	done
+	if [ -d $tree ]; then
+		$KERNELSCAN -k ${KLOG} $tree
+	fi
 }
 
 scan_source_tree $src/drivers/acpi
@@ -156,3 +161,5 @@ scan_source_file $src/drivers/platform/x86/toshiba_acpi.c
 scan_source_file $src/drivers/platform/x86/toshiba_bluetooth.c
 scan_source_file $src/drivers/platform/x86/wmi.c
 scan_source_file $src/drivers/platform/x86/xo15-ebook.c
+
+scan_source_files